@@ -0,0 +1,160 @@
+/*
+ * Exercises angle_sensor.c with the simulated backend under real threads: a trigger
+ * thread stands in for the control timer, a bus thread completes reads like the
+ * driver ISR, and reader threads poll angle_sensor_get() as fast as they can.
+ *
+ *   angle_bench [-d seconds] [-r readers] [-p period_us] [-l latency_us]
+ *
+ * Every sample a reader gets is checked against the simulated angle at its trigger
+ * time, so a torn read (fields from two different samples) is counted. Reports the
+ * read latency, bus utilisation and reader throughput; exits non-zero on torn reads.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "angle_sensor.h"
+
+#define BENCH_MAX_READERS   16
+#define BENCH_BUS_POLL_US   10
+#define BENCH_READER_BURST  64  // gets between yields, so the bus thread keeps its timing
+
+typedef struct
+{
+    pthread_t thread;
+    uint64_t gets;
+    uint64_t torn;
+    uint64_t seq_back;      // a sample older than one seen before
+    int64_t age_max_us;     // trigger -> read by this thread
+} reader_t;
+
+static atomic_bool s_stop;
+static uint32_t s_period_us = 1000;
+
+static void sleep_until(struct timespec *t, uint32_t step_us)
+{
+    t->tv_nsec += (long)step_us * 1000;
+    while (t->tv_nsec >= 1000000000L)
+    {
+        t->tv_nsec -= 1000000000L;
+        t->tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, t, NULL);
+}
+
+static void *trigger_thread(void *arg)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    while (!atomic_load(&s_stop))
+    {
+        angle_sensor_trigger();
+        sleep_until(&t, s_period_us);
+    }
+    return NULL;
+}
+
+static void *bus_thread(void *arg)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    while (!atomic_load(&s_stop))
+    {
+        angle_backend_sim.poll();
+        sleep_until(&t, BENCH_BUS_POLL_US);
+    }
+    return NULL;
+}
+
+static void *reader_thread(void *arg)
+{
+    reader_t *r = arg;
+    uint32_t last_seq[ANGLE_AXES] = {0};
+    while (!atomic_load(&s_stop))
+    {
+        for (uint8_t axis = 0; axis < ANGLE_AXES; axis++)
+        {
+            angle_sample_t s;
+            if (!angle_sensor_get(axis, &s)) continue;
+            r->gets++;
+            if (s.angle != angle_sensor_sim_angle(axis, s.t_us)) r->torn++;
+            if (s.seq < last_seq[axis]) r->seq_back++;
+            last_seq[axis] = s.seq;
+            int64_t age = esp_timer_get_time() - s.t_us;
+            if (age > r->age_max_us) r->age_max_us = age;
+        }
+        if (r->gets % BENCH_READER_BURST < ANGLE_AXES) sched_yield();
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seconds = 2;
+    int readers = 2;
+    uint32_t latency_us = 50;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:r:p:l:")) != -1)
+    {
+        if (opt == 'd') seconds = (uint32_t)atoi(optarg);
+        else if (opt == 'r') readers = atoi(optarg);
+        else if (opt == 'p') s_period_us = (uint32_t)atoi(optarg);
+        else if (opt == 'l') latency_us = (uint32_t)atoi(optarg);
+        else
+        {
+            fprintf(stderr, "usage: %s [-d seconds] [-r readers] [-p period_us] [-l latency_us]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (readers < 1) readers = 1;
+    if (readers > BENCH_MAX_READERS) readers = BENCH_MAX_READERS;
+
+    angle_sensor_sim_set(0, 0, 3 * 65536);          // 3 turns/s
+    angle_sensor_sim_set(1, 20000, -15 * 65536 / 2); // -7.5 turns/s
+    angle_sensor_sim_set_latency(latency_us);
+    if (angle_sensor_init(&angle_backend_sim) != ESP_OK) return 2;
+
+    static reader_t r[BENCH_MAX_READERS];
+    pthread_t trig, bus;
+    atomic_init(&s_stop, false);
+    pthread_create(&bus, NULL, bus_thread, NULL);
+    pthread_create(&trig, NULL, trigger_thread, NULL);
+    for (int i = 0; i < readers; i++) pthread_create(&r[i].thread, NULL, reader_thread, &r[i]);
+
+    sleep(seconds);
+    atomic_store(&s_stop, true);
+    pthread_join(trig, NULL);
+    pthread_join(bus, NULL);
+
+    uint64_t gets = 0, torn = 0, seq_back = 0;
+    int64_t age_max = 0;
+    for (int i = 0; i < readers; i++)
+    {
+        pthread_join(r[i].thread, NULL);
+        gets += r[i].gets;
+        torn += r[i].torn;
+        seq_back += r[i].seq_back;
+        if (r[i].age_max_us > age_max) age_max = r[i].age_max_us;
+    }
+
+    int64_t now = esp_timer_get_time();
+    for (uint8_t axis = 0; axis < ANGLE_AXES; axis++)
+    {
+        angle_sensor_stats_t st;
+        angle_sensor_get_stats(axis, &st, false);
+        double window = (double)(now - st.since_us);
+        printf("axis %d: %u reads, %u errors, %u overruns, latency min/avg/max %u/%.1f/%u us, bus %.1f%%\n",
+               axis + 1, (unsigned)st.reads, (unsigned)st.errors, (unsigned)st.overruns,
+               (unsigned)st.latency_min_us, st.reads ? (double)st.latency_sum_us / st.reads : 0.0,
+               (unsigned)st.latency_max_us, window > 0 ? 100.0 * (double)st.busy_us / window : 0.0);
+    }
+    printf("%d readers: %.2f M gets/s, newest sample at most %.2f ms old\n",
+           readers, (double)gets / seconds / 1e6, (double)age_max / 1000.0);
+    printf("%llu torn reads, %llu out-of-order samples\n", (unsigned long long)torn, (unsigned long long)seq_back);
+    return (torn || seq_back) ? 1 : 0;
+}
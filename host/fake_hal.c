@@ -0,0 +1,241 @@
+#include "fake_hal.h"
+#include <string.h>
+#include "esp_err.h"
+#include "nvs.h"
+#include "motor_control.h"
+#include "display_driver.h"
+#include "core_local.h"
+
+int host_log_level = 0;
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK: return "ESP_OK";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+    default: return "ESP_FAIL";
+    }
+}
+
+//================================================================================
+// NVS
+//================================================================================
+#define FAKE_NVS_MAX    32
+
+typedef struct
+{
+    char name[16];
+    char key[16];
+    uint32_t value;
+} fake_nvs_entry_t;
+
+static CORE_LOCAL fake_nvs_entry_t s_nvs[FAKE_NVS_MAX];
+static CORE_LOCAL int s_nvs_count = 0;
+static CORE_LOCAL const char *s_nvs_names[8];
+static CORE_LOCAL int s_nvs_handles = 0;
+
+static fake_nvs_entry_t *fake_nvs_find(const char *name, const char *key, bool create)
+{
+    for (int i = 0; i < s_nvs_count; i++)
+    {
+        if (strcmp(s_nvs[i].name, name) == 0 && strcmp(s_nvs[i].key, key) == 0) return &s_nvs[i];
+    }
+    if (!create || s_nvs_count >= FAKE_NVS_MAX) return NULL;
+
+    fake_nvs_entry_t *e = &s_nvs[s_nvs_count++];
+    strncpy(e->name, name, sizeof(e->name) - 1);
+    strncpy(e->key, key, sizeof(e->key) - 1);
+    return e;
+}
+
+void fake_nvs_clear(void)
+{
+    s_nvs_count = 0;
+    s_nvs_handles = 0;
+}
+
+void fake_nvs_set_u32(const char *name, const char *key, uint32_t value)
+{
+    fake_nvs_entry_t *e = fake_nvs_find(name, key, true);
+    if (e) e->value = value;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    for (int i = 0; i < s_nvs_handles; i++)
+    {
+        if (strcmp(s_nvs_names[i], name) == 0)
+        {
+            *out_handle = (nvs_handle_t)i;
+            return ESP_OK;
+        }
+    }
+    if (s_nvs_handles >= 8) return ESP_ERR_NO_MEM;
+    s_nvs_names[s_nvs_handles] = name;
+    *out_handle = (nvs_handle_t)s_nvs_handles++;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value)
+{
+    fake_nvs_entry_t *e = fake_nvs_find(s_nvs_names[handle], key, false);
+    if (e == NULL) return ESP_ERR_NVS_NOT_FOUND;
+    *out_value = e->value;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+    fake_nvs_set_u32(s_nvs_names[handle], key, value);
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+//================================================================================
+// Motors: only the command stream is modelled
+//================================================================================
+static CORE_LOCAL motor_cmd_hook_t s_hook = NULL;
+static CORE_LOCAL void *s_hook_arg = NULL;
+static CORE_LOCAL motor_brake_config_t s_brake_cfg[3];
+static CORE_LOCAL uint32_t s_duty_default = 90 * MOTOR_DUTY_SCALE / 100; // MOTOR_DUTY_DEFAULT in motor_control.c
+static CORE_LOCAL int8_t s_dir[3];
+
+static void fake_emit(uint8_t motor_index, int8_t dir, uint32_t duty, motor_stop_mode_t mode)
+{
+    s_dir[motor_index] = dir;
+    if (s_hook == NULL) return;
+    motor_cmd_t cmd = {.motor = motor_index, .dir = dir, .duty = duty, .stop_mode = mode};
+    s_hook(&cmd, s_hook_arg);
+}
+
+void motor_set_cmd_hook(motor_cmd_hook_t hook, void *arg)
+{
+    s_hook = hook;
+    s_hook_arg = arg;
+}
+
+void motor_set_brake_config(uint8_t motor_index, const motor_brake_config_t *cfg)
+{
+    if (motor_index < 3) s_brake_cfg[motor_index] = *cfg;
+}
+
+void motor_stop_mode(uint8_t motor_index, motor_stop_mode_t mode)
+{
+    if (motor_index < 3) fake_emit(motor_index, 0, 0, mode);
+}
+
+void motor_stop(uint8_t motor_index)
+{
+    if (motor_index < 3) motor_stop_mode(motor_index, s_brake_cfg[motor_index].mode);
+}
+
+esp_err_t motor_start_duty(uint8_t motor_index, int8_t dir, uint32_t duty)
+{
+    if (motor_index >= 3 || dir == 0) return ESP_ERR_INVALID_ARG;
+    if (duty > MOTOR_DUTY_SCALE) duty = MOTOR_DUTY_SCALE;
+    if (duty == 0)
+    {
+        motor_stop(motor_index);
+        return ESP_OK;
+    }
+    fake_emit(motor_index, dir, duty, MOTOR_STOP_BRAKE);
+    return ESP_OK;
+}
+
+bool motor_busy(void)
+{
+    return s_dir[0] != 0 || s_dir[1] != 0 || s_dir[2] != 0;
+}
+
+void motor_set_default_duty(uint32_t duty)
+{
+    if (duty > 0 && duty <= MOTOR_DUTY_SCALE) s_duty_default = duty;
+}
+
+uint32_t motor_get_default_duty(void)
+{
+    return s_duty_default;
+}
+
+esp_err_t motor_start_forward(uint8_t motor_index)
+{
+    return motor_start_duty(motor_index, 1, s_duty_default);
+}
+
+esp_err_t motor_start_reverse(uint8_t motor_index)
+{
+    return motor_start_duty(motor_index, -1, s_duty_default);
+}
+
+void motor_set_travel(uint8_t motor_index, uint32_t travel_fwd_us, uint32_t travel_rev_us, uint32_t travel_duty)
+{
+}
+
+void motor_track_sync(uint8_t motor_index, int32_t pos)
+{
+}
+
+//================================================================================
+// Display
+//================================================================================
+static CORE_LOCAL uint8_t s_display_seg[4];
+static CORE_LOCAL uint8_t s_display_ctrl;
+
+void display_write_segments(const uint8_t seg[4])
+{
+    memcpy(s_display_seg, seg, sizeof(s_display_seg));
+}
+
+void display_set_control(bool on, uint8_t level)
+{
+    s_display_ctrl = (uint8_t)((on ? 0x08 : 0x00) | level);
+}
+
+uint8_t fake_display_frame(uint8_t seg[4])
+{
+    memcpy(seg, s_display_seg, sizeof(s_display_seg));
+    return s_display_ctrl;
+}
+
+//================================================================================
+// Stabilizer: the loop itself does not run on the host, see replay.c
+//================================================================================
+void stabilizer_enable(bool on)
+{
+}
+
+void stabilizer_set_rate(int32_t yaw_mdps, int32_t pitch_mdps)
+{
+}
+
+void stabilizer_set_limits(uint32_t gpio)
+{
+}
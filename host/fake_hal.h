@@ -0,0 +1,16 @@
+#ifndef _FAKE_HAL_H_
+#define _FAKE_HAL_H_
+
+#include <stdint.h>
+
+/*
+ * Host stand-ins for the drivers the control logic calls: motor commands go to the
+ * motor_set_cmd_hook() callback only, the display keeps its last frame and NVS lives in RAM.
+ * All state is per thread, like the control logic built with CORE_THREAD_LOCAL.
+ */
+
+void fake_nvs_clear(void);
+void fake_nvs_set_u32(const char *name, const char *key, uint32_t value);
+uint8_t fake_display_frame(uint8_t seg[4]); // last segments written, returns the control bits (0x08 on | level)
+
+#endif // !_FAKE_HAL_H_
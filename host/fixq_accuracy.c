@@ -0,0 +1,189 @@
+/*
+ * Checks the fixed-point signal path in fixq.c against a double precision
+ * reference and reports the worst error of each stage:
+ *
+ *   fixq_accuracy
+ *
+ *  - pot counts -> launch speed setpoint, all 4096 codes
+ *  - joystick counts -> signed duty, all 4096 codes on both axes
+ *  - display: every value from 0.000 to 9999.499, decoded back from the segments
+ *  - pot low-pass filter against a float EMA on a noisy step sequence
+ *  - atan2 for the IMU tilt over accelerometer-sized inputs
+ *
+ * Exits non-zero if any stage is outside its bound.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "fixq.h"
+#include "launch_ctrl.h"
+
+#define ADC_MAX             4095
+#define JOY_DUTY_MIN        2000    // same as control_core.c
+#define JOY_DUTY_MAX        9000
+#define POT_FILTER_SHIFT    2
+#define DISPLAY_MILLI_MAX   9999499
+
+static int s_failures = 0;
+
+static void report(const char *name, double worst, double bound, const char *unit)
+{
+    bool ok = worst <= bound;
+    printf("%-28s max error %8.3f %-6s (bound %.3f) %s\n", name, worst, unit, bound, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static double check_map(int32_t in_lo, int32_t in_hi, int32_t out_lo, int32_t out_hi)
+{
+    fixq_map_t map;
+    fixq_map_init(&map, in_lo, in_hi, out_lo, out_hi);
+    double worst = 0.0;
+    for (int32_t x = in_lo; x <= in_hi; x++)
+    {
+        double ref = out_lo + (double)(x - in_lo) * (out_hi - out_lo) / (in_hi - in_lo);
+        double err = fabs(fixq_map(&map, x) - ref);
+        if (err > worst) worst = err;
+    }
+    return worst;
+}
+
+static double check_joy(int32_t dz_lo, int32_t dz_hi)
+{
+    fixq_joy_t joy;
+    fixq_joy_init(&joy, ADC_MAX, dz_lo, dz_hi, JOY_DUTY_MIN, JOY_DUTY_MAX);
+    double worst = 0.0;
+    for (int32_t x = 0; x <= ADC_MAX; x++)
+    {
+        double ref = 0.0;
+        if (x < dz_lo) ref = -(JOY_DUTY_MAX - (double)x * (JOY_DUTY_MAX - JOY_DUTY_MIN) / dz_lo);
+        else if (x > dz_hi) ref = JOY_DUTY_MIN + (double)(x - dz_hi) * (JOY_DUTY_MAX - JOY_DUTY_MIN) / (ADC_MAX - dz_hi);
+        double err = fabs(fixq_joy_duty(&joy, x) - ref);
+        if (err > worst) worst = err;
+    }
+    return worst;
+}
+
+// Segment bytes back to thousandths; -1 if a digit is not a valid glyph.
+static int64_t decode_segments(const uint8_t seg[4], int64_t *step)
+{
+    static const uint8_t glyph[10] = {0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, 0x7f, 0x6f};
+    int64_t value = 0;
+    int dot = 3;
+    for (int i = 0; i < 4; i++)
+    {
+        uint8_t s = seg[i] & 0x7f;
+        int digit = -1;
+        if (s == 0x00) digit = 0;
+        for (int d = 0; d < 10 && digit < 0; d++)
+        {
+            if (glyph[d] == s) digit = d;
+        }
+        if (digit < 0) return -1;
+        if (seg[i] & 0x80) dot = i;
+        value = value * 10 + digit;
+    }
+    // the point after digit i leaves 3 - i decimals
+    int64_t scale = 1;
+    for (int i = 0; i < dot; i++) scale *= 10;
+    *step = scale;
+    return value * scale;
+}
+
+// What the old float path wrote: the 4-digit number before blanking, or -1 when it
+// gave up (a value rounding to 10000 was dropped instead of moving to the next range).
+static int legacy_number(float number)
+{
+    long n;
+    if (number < 10.0f) n = lroundf(number * 1000.0f);
+    else if (number < 100.0f) n = lroundf(number * 100.0f);
+    else if (number < 1000.0f) n = lroundf(number * 10.0f);
+    else n = lroundf(number);
+    return n > 9999 ? -1 : (int)n;
+}
+
+static double check_display(long *bad_glyphs, long *legacy_dropped)
+{
+    double worst = 0.0;
+    for (uint32_t milli = 0; milli <= DISPLAY_MILLI_MAX; milli++)
+    {
+        uint8_t seg[4];
+        int64_t step = 1;
+        fixq_segments_milli(milli, seg);
+        int64_t shown = decode_segments(seg, &step);
+        if (shown < 0)
+        {
+            (*bad_glyphs)++;
+            continue;
+        }
+        // in units of half a display step, so the bound is 1 for every range
+        double err = fabs((double)(shown - (int64_t)milli)) / (step / 2.0);
+        if (err > worst) worst = err;
+        if (legacy_number((float)milli / 1000.0f) < 0) (*legacy_dropped)++;
+    }
+    return worst;
+}
+
+static double check_lpf(void)
+{
+    fixq_lpf_t lpf;
+    fixq_lpf_init(&lpf, POT_FILTER_SHIFT);
+    double ref = 0.0;
+    double alpha = 1.0 / (1 << POT_FILTER_SHIFT);
+    double worst = 0.0;
+    uint32_t rng = 0x2545f491;
+    for (int i = 0; i < 200000; i++)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        int level = ((i / 500) % 4) * 1300;     // steps across the pot range
+        int x = level + (int)(rng % 64) - 32;   // plus ADC noise
+        if (x < 0) x = 0;
+        if (x > ADC_MAX) x = ADC_MAX;
+
+        uint16_t y = fixq_lpf_update(&lpf, (uint16_t)x);
+        ref = (i == 0) ? x : ref + alpha * (x - ref);
+        double err = fabs(y - ref);
+        if (err > worst) worst = err;
+    }
+    return worst;
+}
+
+static double check_atan2(void)
+{
+    double worst = 0.0;
+    for (int32_t y = -8192; y <= 8192; y += 37)
+    {
+        for (int32_t x = -8192; x <= 8192; x += 41)
+        {
+            if (x == 0 && y == 0) continue;
+            double ref = atan2((double)y, (double)x) * 180000.0 / M_PI;
+            double err = fabs(fixq_atan2_mdeg(y, x) - ref);
+            if (err > 180000.0) err = 360000.0 - err; // +-180 deg are the same angle
+            if (err > worst) worst = err;
+        }
+    }
+    return worst;
+}
+
+int main(void)
+{
+    report("pot -> setpoint", check_map(0, ADC_MAX, LAUNCH_SPEED_MIN_MMPS, LAUNCH_SPEED_MAX_MMPS), 1.0, "mm/s");
+    report("pot -> display speed", check_map(0, ADC_MAX, 0, 30000), 1.0, "mm/s");
+    report("joystick X -> duty", check_joy(1500, 1600), 1.0, "duty");
+    report("joystick Y -> duty", check_joy(1300, 1400), 1.0, "duty");
+
+    long bad_glyphs = 0;
+    long legacy_dropped = 0;
+    report("display x.xxx .. xxxx", check_display(&bad_glyphs, &legacy_dropped), 1.0, "step/2");
+    if (bad_glyphs)
+    {
+        printf("  %ld values produced segments that are not digits\n", bad_glyphs);
+        s_failures++;
+    }
+    printf("  old float path dropped %ld of %d values at range carries\n", legacy_dropped, DISPLAY_MILLI_MAX + 1);
+
+    report("pot low-pass filter", check_lpf(), 1.0, "counts");
+    report("atan2", check_atan2(), 100.0, "mdeg");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,305 @@
+/*
+ * Assembler and validator for motion programs (main/motion.h).
+ *
+ *   motion_asm [-o prog.bin] [-x] [-c name] prog.mp   assemble, validate, list
+ *   motion_asm -d prog.bin                            disassemble
+ *   motion_asm -b progs_dir                           check the built-in programs
+ *
+ * -x prints the bytecode as hex for the console (prog put <id> <name> <hex>), -c as a
+ * C initializer for motion_progs.c. -b assembles progs_dir/<name>.mp for every
+ * built-in program and checks it against the compiled-in bytecode.
+ *
+ * Source, one instruction per line, '#' starts a comment; motors 0..2, limit switches
+ * 1..6, duty in 1/10000, times in ms:
+ *
+ *   move <motor> fwd|rev <duty>|default|arg
+ *   stop <motor> brake|coast|ramp|config
+ *   wait_limit <switch> <timeout>
+ *   wait_ms <time>
+ *   ramp <motor> fwd|rev <from> <to> <time>
+ *   loop <count>|forever
+ *   next
+ *   emit stroke|stroke_end|return|return_end|mark|<code> [arg]
+ *   end
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "motion.h"
+#include "motion_progs.h"
+#include "motor_control.h"
+
+#define ASM_MAX_TOKENS  8
+
+typedef struct
+{
+    const char *name;
+    uint32_t value;
+} asm_word_t;
+
+static const asm_word_t s_dirs[] = {{"fwd", 1}, {"rev", (uint8_t)-1}, {NULL, 0}};
+static const asm_word_t s_duties[] = {{"default", MOTION_DUTY_DEFAULT}, {"arg", MOTION_DUTY_ARG}, {NULL, 0}};
+static const asm_word_t s_stops[] = {
+    {"brake", MOTOR_STOP_BRAKE}, {"coast", MOTOR_STOP_COAST}, {"ramp", MOTOR_STOP_RAMP}, {"config", MOTION_STOP_CONFIG}, {NULL, 0},
+};
+static const asm_word_t s_counts[] = {{"forever", 0}, {NULL, 0}};
+static const asm_word_t s_emits[] = {
+    {"stroke", MOTION_EMIT_STROKE}, {"stroke_end", MOTION_EMIT_STROKE_END}, {"return", MOTION_EMIT_RETURN},
+    {"return_end", MOTION_EMIT_RETURN_END}, {"mark", MOTION_EMIT_MARK}, {NULL, 0},
+};
+
+static const char *s_file;
+static int s_line;
+
+static bool fail(const char *msg, const char *token)
+{
+    fprintf(stderr, "%s:%d: %s%s%s\n", s_file, s_line, msg, token ? " " : "", token ? token : "");
+    return false;
+}
+
+// A keyword from `words` (may be NULL) or a number up to `max`.
+static bool operand(const char *token, const asm_word_t *words, uint32_t max, uint32_t *out)
+{
+    for (; words && words->name; words++)
+    {
+        if (strcmp(token, words->name) == 0)
+        {
+            *out = words->value;
+            return true;
+        }
+    }
+    char *end;
+    unsigned long v = strtoul(token, &end, 0);
+    if (*token == '\0' || *end != '\0' || v > max) return fail("bad operand", token);
+    *out = (uint32_t)v;
+    return true;
+}
+
+static void put_u16(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v & 0xff);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+// Appends one instruction; false with a message on errors.
+static bool assemble_line(char **tok, int n, uint8_t *code, size_t *len)
+{
+    static const struct
+    {
+        const char *name;
+        motion_op_t op;
+        int operands;
+        uint8_t size;
+    } ops[] = {
+        {"end", MOTION_OP_END, 0, 1},
+        {"move", MOTION_OP_MOVE, 3, 5},
+        {"stop", MOTION_OP_STOP, 2, 3},
+        {"wait_limit", MOTION_OP_WAIT_LIMIT, 2, 4},
+        {"wait_ms", MOTION_OP_WAIT_MS, 1, 3},
+        {"ramp", MOTION_OP_RAMP, 5, 9},
+        {"loop", MOTION_OP_LOOP, 1, 2},
+        {"next", MOTION_OP_NEXT, 0, 1},
+        {"emit", MOTION_OP_EMIT, 2, 4},
+    };
+    int i = 0;
+    while (i < (int)(sizeof(ops) / sizeof(ops[0])) && strcmp(tok[0], ops[i].name) != 0) i++;
+    if (i == (int)(sizeof(ops) / sizeof(ops[0]))) return fail("unknown instruction", tok[0]);
+
+    // the emit argument is optional
+    char zero[] = "0";
+    if (ops[i].op == MOTION_OP_EMIT && n == 2) tok[n++] = zero;
+    if (n - 1 != ops[i].operands) return fail("wrong number of operands for", tok[0]);
+    if (*len + ops[i].size > MOTION_PROG_MAX) return fail("program longer than", "MOTION_PROG_MAX");
+
+    uint8_t *p = code + *len;
+    uint32_t v[5] = {0};
+    bool ok = true;
+    p[0] = (uint8_t)ops[i].op;
+    switch (ops[i].op)
+    {
+    case MOTION_OP_MOVE:
+        ok = operand(tok[1], NULL, 255, &v[0]) && operand(tok[2], s_dirs, 0, &v[1]) && operand(tok[3], s_duties, 0xffff, &v[2]);
+        p[1] = (uint8_t)v[0];
+        p[2] = (uint8_t)v[1];
+        put_u16(p + 3, v[2]);
+        break;
+    case MOTION_OP_STOP:
+        ok = operand(tok[1], NULL, 255, &v[0]) && operand(tok[2], s_stops, 0, &v[1]);
+        p[1] = (uint8_t)v[0];
+        p[2] = (uint8_t)v[1];
+        break;
+    case MOTION_OP_WAIT_LIMIT:
+        ok = operand(tok[1], NULL, 255, &v[0]) && operand(tok[2], NULL, 0xffff, &v[1]);
+        p[1] = (uint8_t)v[0];
+        put_u16(p + 2, v[1]);
+        break;
+    case MOTION_OP_WAIT_MS:
+        ok = operand(tok[1], NULL, 0xffff, &v[0]);
+        put_u16(p + 1, v[0]);
+        break;
+    case MOTION_OP_RAMP:
+        ok = operand(tok[1], NULL, 255, &v[0]) && operand(tok[2], s_dirs, 0, &v[1]) && operand(tok[3], NULL, 0xffff, &v[2]) &&
+             operand(tok[4], NULL, 0xffff, &v[3]) && operand(tok[5], NULL, 0xffff, &v[4]);
+        p[1] = (uint8_t)v[0];
+        p[2] = (uint8_t)v[1];
+        put_u16(p + 3, v[2]);
+        put_u16(p + 5, v[3]);
+        put_u16(p + 7, v[4]);
+        break;
+    case MOTION_OP_LOOP:
+        ok = operand(tok[1], s_counts, 255, &v[0]);
+        p[1] = (uint8_t)v[0];
+        break;
+    case MOTION_OP_EMIT:
+        ok = operand(tok[1], s_emits, 255, &v[0]) && operand(tok[2], NULL, 0xffff, &v[1]);
+        p[1] = (uint8_t)v[0];
+        put_u16(p + 2, v[1]);
+        break;
+    default:
+        break;
+    }
+    if (ok) *len += ops[i].size;
+    return ok;
+}
+
+// Assembles and validates a source file; returns the length, 0 on errors.
+static size_t assemble_file(const char *path, uint8_t *code)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+    {
+        perror(path);
+        return 0;
+    }
+    char text[256];
+    size_t len = 0;
+    bool ok = true;
+    s_file = path;
+    for (s_line = 1; fgets(text, sizeof(text), f); s_line++)
+    {
+        char *hash = strchr(text, '#');
+        if (hash) *hash = '\0';
+        char *tok[ASM_MAX_TOKENS + 1];
+        int n = 0;
+        for (char *t = strtok(text, " \t\r\n,"); t && n < ASM_MAX_TOKENS; t = strtok(NULL, " \t\r\n,")) tok[n++] = t;
+        if (n > 0 && !assemble_line(tok, n, code, &len)) ok = false;
+    }
+    fclose(f);
+    if (!ok) return 0;
+
+    size_t err_pc = 0;
+    uint8_t motors = 0;
+    motion_err_t err = motion_validate(code, len, &motors, &err_pc);
+    if (err != MOTION_OK)
+    {
+        fprintf(stderr, "%s: %s at byte %u\n", path, motion_err_name(err), (unsigned)err_pc);
+        return 0;
+    }
+    return len;
+}
+
+static void list(const uint8_t *code, size_t len)
+{
+    char line[64];
+    size_t pc = 0;
+    do
+    {
+        pc = motion_disasm(code, len, pc, line, sizeof(line));
+        printf("%s\n", line);
+    } while (pc != 0);
+}
+
+static int check_builtins(const char *dir)
+{
+    int bad = 0;
+    for (uint8_t id = 1; id <= MOTION_BUILTIN_COUNT; id++)
+    {
+        const motion_prog_t *prog = motion_prog_get(id);
+        char path[512];
+        uint8_t code[MOTION_PROG_MAX], motors = 0;
+        snprintf(path, sizeof(path), "%s/%s.mp", dir, prog->name);
+        size_t len = assemble_file(path, code);
+        motion_err_t err = motion_validate(prog->code, prog->len, &motors, NULL);
+        const char *verdict = "ok";
+        if (err != MOTION_OK) verdict = motion_err_name(err);
+        else if (motors != prog->motors) verdict = "motor mask differs from the code";
+        else if (len != prog->len || memcmp(code, prog->code, len) != 0) verdict = "differs from the source";
+        printf("%d %-15s %3u bytes  %s\n", id, prog->name, prog->len, verdict);
+        if (strcmp(verdict, "ok") != 0) bad++;
+    }
+    return bad ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *out_path = NULL, *c_name = NULL, *bin_path = NULL, *builtin_dir = NULL;
+    bool hex = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:xc:d:b:")) != -1)
+    {
+        if (opt == 'o') out_path = optarg;
+        else if (opt == 'x') hex = true;
+        else if (opt == 'c') c_name = optarg;
+        else if (opt == 'd') bin_path = optarg;
+        else if (opt == 'b') builtin_dir = optarg;
+        else break;
+    }
+    if (builtin_dir) return check_builtins(builtin_dir);
+
+    uint8_t code[MOTION_PROG_MAX + 1];
+    size_t len = 0;
+    if (bin_path)
+    {
+        FILE *f = fopen(bin_path, "rb");
+        if (f == NULL)
+        {
+            perror(bin_path);
+            return 1;
+        }
+        len = fread(code, 1, sizeof(code), f);
+        fclose(f);
+        size_t err_pc = 0;
+        motion_err_t err = motion_validate(code, len, NULL, &err_pc);
+        list(code, len);
+        if (err != MOTION_OK) printf("invalid: %s at byte %u\n", motion_err_name(err), (unsigned)err_pc);
+        return err == MOTION_OK ? 0 : 1;
+    }
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-o prog.bin] [-x] [-c name] prog.mp | -d prog.bin | -b progs_dir\n", argv[0]);
+        return 2;
+    }
+
+    len = assemble_file(argv[optind], code);
+    if (len == 0) return 1;
+    uint8_t motors = 0;
+    motion_validate(code, len, &motors, NULL);
+    if (out_path)
+    {
+        FILE *f = fopen(out_path, "wb");
+        if (f == NULL || fwrite(code, 1, len, f) != len)
+        {
+            perror(out_path);
+            return 1;
+        }
+        fclose(f);
+    }
+    if (hex)
+    {
+        for (size_t i = 0; i < len; i++) printf("%02x", code[i]);
+        printf("\n");
+    }
+    else if (c_name)
+    {
+        printf("static const uint8_t %s[] = {", c_name);
+        for (size_t i = 0; i < len; i++) printf("%s0x%02x,", (i % 12) ? " " : "\n    ", code[i]);
+        printf("\n}; // %u bytes, motors 0x%x\n", (unsigned)len, motors);
+    }
+    else
+    {
+        list(code, len);
+        printf("%u bytes, motors 0x%x\n", (unsigned)len, motors);
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "plant.h"
+#include <string.h>
+
+#define PLANT_DUTY_REF      9000    // duty the travel times are given for
+#define PLANT_RELEASE_POS   1e-4    // carriage clears switch 1 after this much travel
+
+uint32_t plant_rand(plant_t *p)
+{
+    // xorshift32
+    uint32_t x = p->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    p->rng = x;
+    return x;
+}
+
+static bool switch_truth(const plant_t *p, uint8_t sw)
+{
+    switch (sw)
+    {
+    case 1: return p->pos[0] <= 0.0;
+    case 2: return p->pos[0] >= 1.0;
+    case 3: return p->pos[1] >= 1.0;
+    case 4: return p->pos[1] <= 0.0;
+    case 5: return p->pos[2] >= 1.0;
+    case 6: return p->pos[2] <= 0.0;
+    default: return false;
+    }
+}
+
+void plant_init(plant_t *p, uint32_t seed)
+{
+    memset(p, 0, sizeof(*p));
+    p->rng = seed ? seed : 1;
+    p->travel_us[0] = 5000;     // 120 mm stroke at ~22 m/s
+    p->travel_us[1] = 1500000;
+    p->travel_us[2] = 1500000;
+    for (uint8_t sw = 1; sw <= PLANT_SWITCHES; sw++)
+    {
+        p->true_hit[sw - 1] = switch_truth(p, sw);
+    }
+}
+
+void plant_command(plant_t *p, const motor_cmd_t *cmd)
+{
+    if (cmd->motor >= 3) return;
+    p->dir[cmd->motor] = cmd->dir;
+    p->duty[cmd->motor] = cmd->dir ? cmd->duty : 0;
+}
+
+static bool edge_visible(const plant_t *p, uint8_t sw, int64_t t_us)
+{
+    if (p->fault_switch != sw || t_us < p->fault_from_us) return true;
+    return (p->fault != PLANT_FAULT_STUCK_HIT) && (p->fault != PLANT_FAULT_STUCK_OPEN);
+}
+
+void plant_advance(plant_t *p, int64_t t_us, input_frame_t *frame)
+{
+    int64_t t0 = p->t_us;
+    double dt = (double)(t_us - t0);
+    memset(frame->t_edge_us, 0, sizeof(frame->t_edge_us));
+
+    for (int m = 0; m < 3; m++)
+    {
+        if (p->dir[m] == 0 || dt <= 0) continue;
+        double speed = (double)p->duty[m] / PLANT_DUTY_REF / p->travel_us[m]; // per us
+        double start = p->pos[m];
+        double end = start + p->dir[m] * speed * dt;
+
+        // the carriage switches raise edge interrupts with the exact crossing time
+        if (m == 0 && p->dir[m] > 0)
+        {
+            if (start < PLANT_RELEASE_POS && end >= PLANT_RELEASE_POS && edge_visible(p, 1, t_us))
+            {
+                frame->t_edge_us[INPUT_EDGE_LIMIT1_RELEASE] = t0 + (int64_t)((PLANT_RELEASE_POS - start) / speed) + 1;
+            }
+            if (start < 1.0 && end >= 1.0 && edge_visible(p, 2, t_us))
+            {
+                frame->t_edge_us[INPUT_EDGE_LIMIT2_HIT] = t0 + (int64_t)((1.0 - start) / speed) + 1;
+            }
+        }
+        p->pos[m] = end < 0.0 ? 0.0 : (end > 1.0 ? 1.0 : end);
+    }
+    p->t_us = t_us;
+
+    for (uint8_t sw = 1; sw <= PLANT_SWITCHES; sw++)
+    {
+        bool hit = switch_truth(p, sw);
+        if (hit != p->true_hit[sw - 1])
+        {
+            p->true_hit[sw - 1] = hit;
+            p->changed_us[sw - 1] = t_us;
+        }
+    }
+
+    frame->t_us = t_us;
+    for (uint8_t sw = 1; sw <= PLANT_SWITCHES; sw++)
+    {
+        if (plant_switch_read(p, sw)) frame->gpio &= (uint16_t)~INPUT_LIMIT_BIT(sw);
+        else frame->gpio |= INPUT_LIMIT_BIT(sw);
+    }
+}
+
+bool plant_switch_read(plant_t *p, uint8_t sw)
+{
+    bool hit = p->true_hit[sw - 1];
+    if (p->fault_switch != sw || p->t_us < p->fault_from_us) return hit;
+
+    switch (p->fault)
+    {
+    case PLANT_FAULT_STUCK_HIT:  return true;
+    case PLANT_FAULT_STUCK_OPEN: return false;
+    case PLANT_FAULT_BOUNCE:
+        if (p->t_us - p->changed_us[sw - 1] < (int64_t)p->bounce_us) return (plant_rand(p) & 1) != 0;
+        return hit;
+    default:
+        return hit;
+    }
+}
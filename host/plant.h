@@ -0,0 +1,49 @@
+#ifndef _PLANT_H_
+#define _PLANT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "input_frame.h"
+#include "motor_control.h"
+
+/*
+ * Simulated mechanics for host runs: the launch carriage (motor 0) between limit
+ * switches 1 and 2, and the two aim axes (motors 1 and 2) between switches 3/4 and
+ * 5/6. Speed is proportional to duty; positions run 0 (reverse end) .. 1 (forward
+ * end). One limit switch can be given a fault.
+ */
+
+#define PLANT_SWITCHES  6
+
+typedef enum
+{
+    PLANT_FAULT_NONE,
+    PLANT_FAULT_STUCK_HIT,  // switch reads asserted from fault_from_us on
+    PLANT_FAULT_STUCK_OPEN, // switch never reads asserted from fault_from_us on
+    PLANT_FAULT_BOUNCE,     // switch chatters for bounce_us after each change
+} plant_fault_t;
+
+typedef struct
+{
+    double pos[3];
+    int8_t dir[3];
+    uint32_t duty[3];
+    uint32_t travel_us[3];      // end to end at the default 90% duty
+    int64_t t_us;               // time the positions refer to
+
+    plant_fault_t fault;
+    uint8_t fault_switch;       // 1..6
+    int64_t fault_from_us;
+    uint32_t bounce_us;
+    bool true_hit[PLANT_SWITCHES];
+    int64_t changed_us[PLANT_SWITCHES];
+    uint32_t rng;
+} plant_t;
+
+void plant_init(plant_t *p, uint32_t seed);
+void plant_command(plant_t *p, const motor_cmd_t *cmd);
+void plant_advance(plant_t *p, int64_t t_us, input_frame_t *frame); // sets t_us, limit bits and edges
+bool plant_switch_read(plant_t *p, uint8_t sw);                     // level the controller sees
+uint32_t plant_rand(plant_t *p);
+
+#endif // !_PLANT_H_
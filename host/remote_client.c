@@ -0,0 +1,210 @@
+/*
+ * Command-line client for the remote protocol (main/remote_proto.h) on a serial port.
+ *
+ *   remote_client [-b baud] DEVICE aim X Y [seconds]   stream aim (-1000..1000) at 50 Hz
+ *   remote_client [-b baud] DEVICE launch | rehome | random | stabilize
+ *   remote_client [-b baud] DEVICE speed N              launch speed, 0..1000 of the pot range
+ *   remote_client [-b baud] DEVICE ping [count]         round trip time
+ *
+ * Every command ends with a release, so the device goes back to its local inputs
+ * instead of tripping the link-loss failsafe when the client exits.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "remote_proto.h"
+
+#define CLIENT_AIM_PERIOD_US    20000
+
+static int s_fd = -1;
+static uint16_t s_seq = 0;
+
+static int64_t mono_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static speed_t baud_const(int baud)
+{
+    switch (baud)
+    {
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return 0;
+    }
+}
+
+static bool open_port(const char *path, int baud)
+{
+    speed_t speed = baud_const(baud);
+    if (speed == 0)
+    {
+        fprintf(stderr, "unsupported baud rate %d\n", baud);
+        return false;
+    }
+    s_fd = open(path, O_RDWR | O_NOCTTY);
+    if (s_fd < 0)
+    {
+        perror(path);
+        return false;
+    }
+    struct termios tio;
+    tcgetattr(s_fd, &tio);
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    return tcsetattr(s_fd, TCSANOW, &tio) == 0;
+}
+
+static void send_frame(uint8_t type, const void *payload, uint8_t len)
+{
+    uint8_t out[REMOTE_MAX_FRAME];
+    size_t n = remote_encode(out, ++s_seq, type, payload, len);
+    if (write(s_fd, out, n) != (ssize_t)n) perror("write");
+}
+
+static void send_mode(remote_mode_t mode)
+{
+    uint8_t m = (uint8_t)mode;
+    send_frame(REMOTE_MODE, &m, 1);
+}
+
+static void stream_aim(int x, int y, double seconds)
+{
+    uint8_t p[4];
+    remote_put_i16(p, (int16_t)x);
+    remote_put_i16(p + 2, (int16_t)y);
+    int64_t t_end = mono_us() + (int64_t)(seconds * 1e6);
+    while (mono_us() < t_end)
+    {
+        send_frame(REMOTE_AIM, p, sizeof(p));
+        usleep(CLIENT_AIM_PERIOD_US);
+    }
+    remote_put_i16(p, 0);
+    remote_put_i16(p + 2, 0);
+    send_frame(REMOTE_AIM, p, sizeof(p));
+}
+
+// Other traffic on the line (boot messages) is skipped by the parser.
+static int ping(int count)
+{
+    remote_parser_t rx;
+    remote_parser_init(&rx);
+    int answered = 0;
+    for (int i = 0; i < count; i++)
+    {
+        uint8_t p[4];
+        remote_put_i32(p, i);
+        int64_t t0 = mono_us();
+        send_frame(REMOTE_PING, p, sizeof(p));
+        bool got_pong = false;
+        while (!got_pong && mono_us() - t0 < 200000)
+        {
+            struct pollfd pfd = {.fd = s_fd, .events = POLLIN};
+            if (poll(&pfd, 1, 20) <= 0) continue;
+            uint8_t buf[128];
+            ssize_t n = read(s_fd, buf, sizeof(buf));
+            for (ssize_t k = 0; k < n && !got_pong;)
+            {
+                remote_msg_t msg;
+                bool got;
+                k += (ssize_t)remote_parser_feed(&rx, buf + k, (size_t)(n - k), &msg, &got);
+                got_pong = got && msg.type == REMOTE_PONG && remote_get_i32(msg.payload) == i;
+            }
+        }
+        if (got_pong)
+        {
+            printf("pong %d: %.2f ms\n", i, (mono_us() - t0) / 1e3);
+            answered++;
+        }
+        else
+        {
+            printf("ping %d: no answer\n", i);
+        }
+        usleep(50000);
+    }
+    return answered == count ? 0 : 1;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-b baud] DEVICE aim X Y [seconds] | launch | rehome | random | stabilize | "
+                    "speed N | ping [count]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    int baud = 921600;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:")) != -1)
+    {
+        if (opt == 'b') baud = atoi(optarg);
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - optind < 2)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *cmd = argv[optind + 1];
+    char **args = &argv[optind + 2];
+    int nargs = argc - optind - 2;
+    if (!open_port(argv[optind], baud)) return 2;
+
+    int ret = 0;
+    if (strcmp(cmd, "aim") == 0 && nargs >= 2)
+    {
+        stream_aim(atoi(args[0]), atoi(args[1]), nargs >= 3 ? atof(args[2]) : 1.0);
+    }
+    else if (strcmp(cmd, "launch") == 0)
+    {
+        send_frame(REMOTE_LAUNCH, NULL, 0);
+    }
+    else if (strcmp(cmd, "rehome") == 0)
+    {
+        send_mode(REMOTE_MODE_REHOME);
+    }
+    else if (strcmp(cmd, "random") == 0)
+    {
+        send_mode(REMOTE_MODE_RANDOM);
+    }
+    else if (strcmp(cmd, "stabilize") == 0)
+    {
+        send_mode(REMOTE_MODE_STABILIZE);
+    }
+    else if (strcmp(cmd, "speed") == 0 && nargs >= 1)
+    {
+        uint8_t p[5] = {REMOTE_PARAM_LAUNCH_SPEED};
+        remote_put_i32(p + 1, atoi(args[0]));
+        send_frame(REMOTE_PARAM, p, sizeof(p));
+    }
+    else if (strcmp(cmd, "ping") == 0)
+    {
+        ret = ping(nargs >= 1 ? atoi(args[0]) : 5);
+    }
+    else
+    {
+        usage(argv[0]);
+        ret = 2;
+    }
+    send_mode(REMOTE_MODE_RELEASE);
+    tcdrain(s_fd);
+    close(s_fd);
+    return ret;
+}
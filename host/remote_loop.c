@@ -0,0 +1,395 @@
+/*
+ * Loopback test of the remote protocol through a pseudo-terminal, no hardware or
+ * network needed. A device thread plays the firmware side: it reads the pty slave
+ * like remote_uart.c reads its port, runs control ticks at the device rate against
+ * the simulated plant, and answers pings. The main thread is the client on the pty
+ * master.
+ *
+ *   remote_loop [-p tick_us] [-r commands_per_s] [-d seconds]
+ *
+ * Phases: aim commands at a fixed rate (command-to-motor latency), pings (round
+ * trip), an unthrottled burst with every 100th frame corrupted (throughput, CRC and
+ * sequence accounting), then silence (failsafe must brake all motors) and recovery.
+ * Exits non-zero if a check fails.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "motor_control.h"
+#include "control_core.h"
+#include "remote_ctrl.h"
+#include "fake_hal.h"
+#include "plant.h"
+
+#define LOOP_CORRUPT_EVERY  100
+#define LOOP_MAX_SAMPLES    100000
+#define LOOP_HOMING_MAX_US  60000000
+#define LOOP_UART_BAUD      921600  // for comparison with the real link
+
+typedef enum
+{
+    PHASE_HOMING,
+    PHASE_LATENCY,
+    PHASE_PING,
+    PHASE_BURST,
+    PHASE_FAILSAFE,
+    PHASE_RECOVER,
+} phase_t;
+
+static int s_master = -1, s_slave = -1;
+static uint32_t s_tick_us = 20000;
+static atomic_bool s_stop;
+static atomic_int s_phase;
+static _Atomic int64_t s_send_us[1 << 16];  // client send time by seq
+
+// device thread state, shared under s_lock
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static remote_parser_t s_parser;
+static plant_t s_plant;
+static int64_t s_clock_offset = 0;
+static int64_t s_latency_us[LOOP_MAX_SAMPLES];
+static int s_num_latency = 0;
+static int s_last_seq = -1;
+static int64_t s_brake_us[3];               // first brake per motor in PHASE_FAILSAFE
+
+static int64_t mono_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// device time: homing runs in simulated time ahead of the wall clock
+static int64_t dev_us(void)
+{
+    return mono_us() + s_clock_offset;
+}
+
+static void on_motor_cmd(const motor_cmd_t *cmd, void *arg)
+{
+    plant_command(&s_plant, cmd);
+    int phase = atomic_load(&s_phase);
+    if (phase == PHASE_LATENCY && cmd->motor == 1 && cmd->dir != 0)
+    {
+        int seq = remote_ctrl_applied_seq();
+        int64_t sent = atomic_load(&s_send_us[seq]);
+        if (seq != s_last_seq && sent != 0 && s_num_latency < LOOP_MAX_SAMPLES)
+        {
+            s_latency_us[s_num_latency++] = mono_us() - sent;
+        }
+        s_last_seq = seq;
+    }
+    if (phase == PHASE_FAILSAFE && cmd->dir == 0 && cmd->stop_mode == MOTOR_STOP_BRAKE && s_brake_us[cmd->motor] == 0)
+    {
+        s_brake_us[cmd->motor] = mono_us();
+    }
+}
+
+static void pty_reply(const uint8_t *frame, size_t len, void *arg)
+{
+    if (write(s_slave, frame, len) != (ssize_t)len) fprintf(stderr, "pong write failed\n");
+}
+
+static void device_tick(input_frame_t *frame, int64_t t_us)
+{
+    plant_advance(&s_plant, t_us, frame);
+    input_frame_t in = *frame;
+    in.joy_x = INPUT_JOY_X_REST;
+    in.joy_y = INPUT_JOY_Y_REST;
+    remote_ctrl_apply(&in);
+    control_core_step(&in);
+}
+
+static void *device_thread(void *arg)
+{
+    input_frame_t frame = INPUT_FRAME_INIT;
+    uint8_t buf[256];
+
+    // same stop configuration as app_main(); motor and control state are per thread
+    const motor_brake_config_t launch_brake = {.mode = MOTOR_STOP_BRAKE, .ramp_ms = 0, .reverse_dead_ms = 30};
+    const motor_brake_config_t aim_brake = {.mode = MOTOR_STOP_RAMP, .ramp_ms = 80, .reverse_dead_ms = 30};
+    motor_set_brake_config(0, &launch_brake);
+    motor_set_brake_config(1, &aim_brake);
+    motor_set_brake_config(2, &aim_brake);
+    motor_set_cmd_hook(on_motor_cmd, NULL);
+
+    // home the aim axes in simulated time, then run on the wall clock
+    pthread_mutex_lock(&s_lock);
+    int64_t t = mono_us();
+    int64_t t_end = t + LOOP_HOMING_MAX_US;
+    plant_init(&s_plant, 1);
+    s_plant.t_us = t;
+    control_core_init();
+    while (control_core_state() == STATE_HOMING && t < t_end)
+    {
+        t += s_tick_us;
+        device_tick(&frame, t);
+    }
+    s_clock_offset = t - mono_us();
+    pthread_mutex_unlock(&s_lock);
+    atomic_store(&s_phase, PHASE_LATENCY);
+
+    int64_t next_tick = t + s_tick_us;
+    while (!atomic_load(&s_stop))
+    {
+        int64_t wait_us = next_tick - dev_us();
+        if (wait_us > 0)
+        {
+            struct pollfd pfd = {.fd = s_slave, .events = POLLIN};
+            struct timespec ts = {.tv_sec = wait_us / 1000000, .tv_nsec = (wait_us % 1000000) * 1000};
+            if (ppoll(&pfd, 1, &ts, NULL) > 0)
+            {
+                ssize_t n = read(s_slave, buf, sizeof(buf));
+                if (n > 0)
+                {
+                    pthread_mutex_lock(&s_lock);
+                    remote_ctrl_rx_bytes(&s_parser, buf, (size_t)n, dev_us(), pty_reply, NULL);
+                    pthread_mutex_unlock(&s_lock);
+                }
+            }
+            continue;
+        }
+        pthread_mutex_lock(&s_lock);
+        device_tick(&frame, next_tick);
+        pthread_mutex_unlock(&s_lock);
+        next_tick += s_tick_us;
+    }
+    return NULL;
+}
+
+static uint16_t s_seq = 0;
+
+static void send_frame(uint8_t type, const void *payload, uint8_t len, bool corrupt)
+{
+    uint8_t out[REMOTE_MAX_FRAME];
+    uint16_t seq = ++s_seq;
+    size_t n = remote_encode(out, seq, type, payload, len);
+    if (corrupt) out[6] ^= 0x10; // first payload byte, after the CRC was computed
+    atomic_store(&s_send_us[seq], mono_us());
+    if (write(s_master, out, n) != (ssize_t)n) fprintf(stderr, "write failed\n");
+}
+
+static void send_aim(int16_t x, int16_t y, bool corrupt)
+{
+    uint8_t p[4];
+    remote_put_i16(p, x);
+    remote_put_i16(p + 2, y);
+    send_frame(REMOTE_AIM, p, sizeof(p), corrupt);
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_dist(const char *what, int64_t *v, int n)
+{
+    if (n == 0)
+    {
+        printf("  %-22s no samples\n", what);
+        return;
+    }
+    qsort(v, (size_t)n, sizeof(v[0]), cmp_i64);
+    int64_t sum = 0;
+    for (int i = 0; i < n; i++) sum += v[i];
+    printf("  %-22s %d samples, min %.2f ms, avg %.2f ms, p99 %.2f ms, max %.2f ms\n", what, n,
+           v[0] / 1e3, (double)sum / n / 1e3, v[n * 99 / 100] / 1e3, v[n - 1] / 1e3);
+}
+
+// Reads the pty master until a pong with this token arrives, returns the round trip.
+static int64_t ping(uint32_t token, remote_parser_t *rx)
+{
+    uint8_t p[4];
+    remote_put_i32(p, (int32_t)token);
+    int64_t t0 = mono_us();
+    send_frame(REMOTE_PING, p, sizeof(p), false);
+    while (mono_us() - t0 < 100000)
+    {
+        struct pollfd pfd = {.fd = s_master, .events = POLLIN};
+        if (poll(&pfd, 1, 10) <= 0) continue;
+        uint8_t buf[64];
+        ssize_t n = read(s_master, buf, sizeof(buf));
+        for (ssize_t i = 0; i < n;)
+        {
+            remote_msg_t msg;
+            bool got;
+            i += (ssize_t)remote_parser_feed(rx, buf + i, (size_t)(n - i), &msg, &got);
+            if (got && msg.type == REMOTE_PONG && (uint32_t)remote_get_i32(msg.payload) == token)
+            {
+                return mono_us() - t0;
+            }
+        }
+    }
+    return -1;
+}
+
+static void sleep_us(int64_t us)
+{
+    struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000};
+    nanosleep(&ts, NULL);
+}
+
+static bool open_pty(void)
+{
+    s_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (s_master < 0 || grantpt(s_master) != 0 || unlockpt(s_master) != 0) return false;
+    s_slave = open(ptsname(s_master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (s_slave < 0) return false;
+    struct termios tio;
+    tcgetattr(s_slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(s_slave, TCSANOW, &tio);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    double duration_s = 2.0;
+    int rate = 200;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:r:d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': s_tick_us = (uint32_t)atoi(optarg); break;
+        case 'r': rate = atoi(optarg); break;
+        case 'd': duration_s = atof(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-p tick_us] [-r commands_per_s] [-d seconds]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!open_pty())
+    {
+        perror("pty");
+        return 2;
+    }
+    host_log_level = 2; // warnings: the failsafe reports itself
+    remote_ctrl_init();
+    remote_parser_init(&s_parser);
+
+    pthread_t dev;
+    pthread_create(&dev, NULL, device_thread, NULL);
+    while (atomic_load(&s_phase) == PHASE_HOMING) sleep_us(1000);
+    bool ok = true;
+    printf("pty loopback, control tick %.1f ms\n", s_tick_us / 1e3);
+
+    // 1. aim commands at a fixed rate; the speed changes with every command and the
+    //    direction every 50, so the axis stays clear of its limits
+    int64_t period = 1000000 / rate, t_next = mono_us();
+    int sent = (int)(duration_s * rate);
+    for (int i = 0; i < sent; i++)
+    {
+        int16_t x = (int16_t)(300 + (i * 53) % 600);
+        send_aim((i / 50) & 1 ? x : -x, 0, false);
+        t_next += period;
+        int64_t wait = t_next - mono_us();
+        if (wait > 0) sleep_us(wait);
+    }
+    pthread_mutex_lock(&s_lock);
+    printf("  %d aim commands at %d/s, %d reached a motor (the rest were superseded within a tick)\n",
+           sent, rate, s_num_latency);
+    print_dist("command -> motor", s_latency_us, s_num_latency);
+    pthread_mutex_unlock(&s_lock);
+
+    // 2. round trip through the device's reply path
+    atomic_store(&s_phase, PHASE_PING);
+    remote_parser_t rx;
+    remote_parser_init(&rx);
+    int64_t rtt[50];
+    int n_rtt = 0;
+    for (uint32_t i = 0; i < 50; i++)
+    {
+        int64_t r = ping(i + 1, &rx);
+        if (r >= 0) rtt[n_rtt++] = r;
+    }
+    print_dist("ping round trip", rtt, n_rtt);
+    if (n_rtt != 50) ok = false;
+
+    // 3. unthrottled burst with corrupted frames
+    atomic_store(&s_phase, PHASE_BURST);
+    sleep_us(50000);
+    pthread_mutex_lock(&s_lock);
+    remote_parser_t before = s_parser;
+    pthread_mutex_unlock(&s_lock);
+    int burst = 0, corrupted = 0;
+    int64_t t0 = mono_us();
+    while (mono_us() - t0 < 1000000)
+    {
+        bool corrupt = (++burst % LOOP_CORRUPT_EVERY) == 0;
+        corrupted += corrupt;
+        send_aim((burst & 1) ? 300 : -300, 0, corrupt);
+        if (burst % 32 == 0)
+        {
+            while (poll(&(struct pollfd){.fd = s_master, .events = POLLIN}, 1, 0) > 0) // drop pongs
+            {
+                uint8_t drain[256];
+                if (read(s_master, drain, sizeof(drain)) <= 0) break;
+            }
+        }
+    }
+    double burst_s = (mono_us() - t0) / 1e6;
+    sleep_us(100000);
+    pthread_mutex_lock(&s_lock);
+    uint32_t accepted = s_parser.frames - before.frames;
+    uint32_t crc_errors = s_parser.crc_errors - before.crc_errors;
+    uint32_t lost = s_parser.lost - before.lost;
+    pthread_mutex_unlock(&s_lock);
+    printf("  burst: %d frames in %.2f s, %u accepted (%.0f commands/s; a %d baud UART carries %d/s)\n",
+           burst, burst_s, (unsigned)accepted, accepted / burst_s, LOOP_UART_BAUD, LOOP_UART_BAUD / 10 / 12);
+    printf("  %d corrupted: %u CRC errors, %u sequence numbers missing\n", corrupted, (unsigned)crc_errors, (unsigned)lost);
+    if (crc_errors != (uint32_t)corrupted || lost != (uint32_t)corrupted || accepted != (uint32_t)(burst - corrupted)) ok = false;
+
+    // 4. silence: the link times out and every motor is braked
+    pthread_mutex_lock(&s_lock);
+    memset(s_brake_us, 0, sizeof(s_brake_us));
+    atomic_store(&s_phase, PHASE_FAILSAFE);
+    pthread_mutex_unlock(&s_lock);
+    int64_t t_silent = atomic_load(&s_send_us[s_seq]);
+    sleep_us((REMOTE_LINK_TIMEOUT_MS * 1000 + 3 * s_tick_us) * 2);
+    pthread_mutex_lock(&s_lock);
+    int64_t worst = 0;
+    for (int m = 0; m < 3; m++)
+    {
+        if (s_brake_us[m] == 0) ok = false;
+        else if (s_brake_us[m] - t_silent > worst) worst = s_brake_us[m] - t_silent;
+    }
+    bool lost_link = remote_ctrl_link() == REMOTE_LINK_LOST;
+    printf("  failsafe: link %s, motors braked %s, %.1f ms after the last command (timeout %d ms)\n",
+           lost_link ? "lost" : "NOT lost", (s_brake_us[0] && s_brake_us[1] && s_brake_us[2]) ? "all" : "NOT all",
+           worst / 1e3, REMOTE_LINK_TIMEOUT_MS);
+    if (!lost_link || worst > (REMOTE_LINK_TIMEOUT_MS * 1000 + 2 * s_tick_us)) ok = false;
+    pthread_mutex_unlock(&s_lock);
+
+    // 5. the client comes back, then hands control back to the local inputs
+    atomic_store(&s_phase, PHASE_RECOVER);
+    send_frame(REMOTE_HEARTBEAT, NULL, 0, false);
+    sleep_us(3 * s_tick_us);
+    pthread_mutex_lock(&s_lock);
+    bool back = remote_ctrl_link() == REMOTE_LINK_ACTIVE;
+    pthread_mutex_unlock(&s_lock);
+    uint8_t mode = REMOTE_MODE_RELEASE;
+    send_frame(REMOTE_MODE, &mode, 1, false);
+    sleep_us(5 * s_tick_us);
+    pthread_mutex_lock(&s_lock);
+    bool released = remote_ctrl_link() == REMOTE_LINK_NONE;
+    pthread_mutex_unlock(&s_lock);
+    printf("  recovery: link %s after a heartbeat, %s after release\n",
+           back ? "active" : "NOT active", released ? "local" : "NOT local");
+    if (!back || !released) ok = false;
+
+    atomic_store(&s_stop, true);
+    pthread_join(dev, NULL);
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,284 @@
+/*
+ * Replays a session recorded by input_recorder.c through the real control logic
+ * (control_core.c and the modules it drives) and checks that the motor commands
+ * match the recorded ones.
+ *
+ *   replay [-v level] [-p] reclog.bin
+ *
+ * The file may be a single session or a dump of the whole reclog partition; in the
+ * latter case the newer half is replayed unless -p (previous session) is given.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "motor_control.h"
+#include "control_core.h"
+#include "rec_log.h"
+#include "tune_cfg.h"
+#include "fake_hal.h"
+
+#define REPLAY_MAX_CMDS     16  // commands per control tick
+#define REPLAY_MAX_REPORTS  20
+
+typedef struct
+{
+    uint8_t motor;
+    int8_t dir;
+    uint8_t stop_mode;
+    uint16_t duty;
+} replay_cmd_t;
+
+static replay_cmd_t s_actual[REPLAY_MAX_CMDS];
+static int s_num_actual = 0;
+static replay_cmd_t s_expected[REPLAY_MAX_CMDS];
+static int s_num_expected = 0;
+
+static void on_motor_cmd(const motor_cmd_t *cmd, void *arg)
+{
+    if (s_num_actual >= REPLAY_MAX_CMDS) return;
+    replay_cmd_t *c = &s_actual[s_num_actual++];
+    c->motor = cmd->motor;
+    c->dir = cmd->dir;
+    c->stop_mode = cmd->dir == 0 ? (uint8_t)cmd->stop_mode : 0;
+    c->duty = (uint16_t)cmd->duty;
+}
+
+static void print_cmds(const char *what, const replay_cmd_t *cmds, int n)
+{
+    printf("    %-8s", what);
+    for (int i = 0; i < n; i++)
+    {
+        if (cmds[i].dir == 0) printf(" m%d:stop/%d", cmds[i].motor, cmds[i].stop_mode);
+        else printf(" m%d:%+d@%d", cmds[i].motor, cmds[i].dir, cmds[i].duty);
+    }
+    printf("\n");
+}
+
+// Drops the aim motor commands; in STATE_STABILIZE they come from the stabilizer
+// task, which is not part of the replayed logic.
+static int drop_aim_cmds(replay_cmd_t *cmds, int n)
+{
+    int kept = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (cmds[i].motor == 0) cmds[kept++] = cmds[i];
+    }
+    return kept;
+}
+
+// Compares the commands issued for one frame, returns false on a mismatch.
+static bool check_tick(int64_t t_us, bool stabilizing, uint32_t *reports)
+{
+    if (stabilizing)
+    {
+        s_num_actual = drop_aim_cmds(s_actual, s_num_actual);
+        s_num_expected = drop_aim_cmds(s_expected, s_num_expected);
+    }
+    bool same = (s_num_actual == s_num_expected);
+    for (int i = 0; same && i < s_num_expected; i++)
+    {
+        same = (memcmp(&s_actual[i], &s_expected[i], sizeof(replay_cmd_t)) == 0);
+    }
+    if (!same && (*reports)++ < REPLAY_MAX_REPORTS)
+    {
+        printf("  mismatch at t=%.3f s:\n", (double)t_us / 1e6);
+        print_cmds("recorded", s_expected, s_num_expected);
+        print_cmds("replayed", s_actual, s_num_actual);
+    }
+    s_num_actual = 0;
+    s_num_expected = 0;
+    return same;
+}
+
+static uint8_t *load_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(size > 0 ? (size_t)size : 1);
+    if (buf != NULL && fread(buf, 1, (size_t)size, f) != (size_t)size)
+    {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = (size_t)size;
+    return buf;
+}
+
+// Picks the session to replay: one of the two partition halves, or the whole file.
+static bool open_session(rec_reader_t *rd, const uint8_t *buf, size_t len, bool previous)
+{
+    rec_reader_t a, b;
+    bool have_a = rec_log_open(&a, buf, len / 2);
+    bool have_b = rec_log_open(&b, buf + len / 2, len - len / 2);
+    if (have_a && have_b)
+    {
+        bool b_newer = (int32_t)(b.boot_count - a.boot_count) > 0;
+        *rd = (b_newer != previous) ? b : a;
+        return true;
+    }
+    if (have_b && !rec_log_open(&a, buf, len))
+    {
+        *rd = b;
+        return !previous;
+    }
+    return rec_log_open(rd, buf, len) && !previous;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    bool previous = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "v:p")) != -1)
+    {
+        if (opt == 'v') host_log_level = atoi(optarg);
+        else if (opt == 'p') previous = true;
+        else
+        {
+            fprintf(stderr, "usage: %s [-v level] [-p] reclog.bin\n", argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "usage: %s [-v level] [-p] reclog.bin\n", argv[0]);
+        return 2;
+    }
+
+    size_t len = 0;
+    uint8_t *buf = load_file(argv[optind], &len);
+    if (buf == NULL)
+    {
+        fprintf(stderr, "cannot read %s\n", argv[optind]);
+        return 2;
+    }
+    rec_reader_t rd;
+    if (!open_session(&rd, buf, len, previous))
+    {
+        fprintf(stderr, "%s: no recorded session found\n", argv[optind]);
+        return 2;
+    }
+    printf("session %u\n", (unsigned)rd.boot_count);
+
+    // the NVS state at boot decides whether homing measures travel, restore it first
+    rec_item_t item;
+    rec_reader_t scan = rd;
+    while (rec_log_next(&scan, &item) && item.type != REC_INPUT)
+    {
+        if (item.type == REC_BOOT)
+        {
+            if (item.travel_us[0] && item.travel_us[1])
+            {
+                fake_nvs_set_u32("axis", "m1_fwd", item.travel_us[0]);
+                fake_nvs_set_u32("axis", "m1_rev", item.travel_us[1]);
+            }
+            if (item.travel_us[2] && item.travel_us[3])
+            {
+                fake_nvs_set_u32("axis", "m2_fwd", item.travel_us[2]);
+                fake_nvs_set_u32("axis", "m2_rev", item.travel_us[3]);
+            }
+        }
+        else if (item.type == REC_DUTY)
+        {
+            // older logs have no REC_DUTY; homing then assumes the factory duty
+            if (item.travel_duty[0]) fake_nvs_set_u32("axis", "m1_duty", item.travel_duty[0]);
+            if (item.travel_duty[1]) fake_nvs_set_u32("axis", "m2_duty", item.travel_duty[1]);
+        }
+    }
+
+    // same stop configuration as app_main()
+    const motor_brake_config_t launch_brake = {.mode = MOTOR_STOP_BRAKE, .ramp_ms = 0, .reverse_dead_ms = 30};
+    const motor_brake_config_t aim_brake = {.mode = MOTOR_STOP_RAMP, .ramp_ms = 80, .reverse_dead_ms = 30};
+    motor_set_brake_config(0, &launch_brake);
+    motor_set_brake_config(1, &aim_brake);
+    motor_set_brake_config(2, &aim_brake);
+    motor_set_cmd_hook(on_motor_cmd, NULL);
+    control_core_init();
+
+    uint32_t frames = 0, cmds = 0, ticks_bad = 0, reports = 0, gaps = 0;
+    tune_cfg_t params = *tune_cfg_get(); // tuning changes collected for the next frame
+    bool params_dirty = false;
+    int64_t params_clock = 0;            // publish clock, nothing holds a snapshot here
+    int64_t t_first = 0, t_last = 0;
+    bool stepped = false;
+    bool stabilizing = false; // state was STATE_STABILIZE before or after the last step
+    double wall_start = now_s();
+
+    while (rec_log_next(&rd, &item))
+    {
+        switch (item.type)
+        {
+        case REC_INPUT:
+            if (stepped && !check_tick(t_last, stabilizing, &reports)) ticks_bad++;
+            if (params_dirty)
+            {
+                params_clock += TUNE_CFG_GRACE_US;
+                if (!tune_cfg_publish(&params, params_clock)) printf("  rejected parameter set at t=%.3f s\n", (double)item.input.t_us / 1e6);
+                control_core_set_cfg(tune_cfg_get());
+                params_dirty = false;
+            }
+            stabilizing = control_core_state() == STATE_STABILIZE;
+            control_core_step(&item.input);
+            stabilizing |= control_core_state() == STATE_STABILIZE;
+            if (!stepped) t_first = item.input.t_us;
+            t_last = item.input.t_us;
+            stepped = true;
+            frames++;
+            break;
+
+        case REC_MOTOR:
+            if (s_num_expected < REPLAY_MAX_CMDS)
+            {
+                replay_cmd_t *c = &s_expected[s_num_expected++];
+                c->motor = item.motor.motor;
+                c->dir = item.motor.dir;
+                c->stop_mode = item.motor.dir == 0 ? item.motor.stop_mode : 0;
+                c->duty = item.motor.duty;
+            }
+            cmds++;
+            break;
+
+        case REC_SEED:
+            control_core_set_seed(item.seed);
+            break;
+
+        case REC_PARAM:
+            if (!tune_cfg_put(&params, (tune_param_t)item.param.id, item.param.value))
+            {
+                printf("  unknown parameter %u = %u\n", (unsigned)item.param.id, (unsigned)item.param.value);
+            }
+            params_dirty = true;
+            break;
+
+        case REC_GAP:
+            printf("  %u records dropped while recording at t=%.3f s\n", (unsigned)item.dropped, (double)t_last / 1e6);
+            gaps++;
+            break;
+
+        default:
+            break;
+        }
+    }
+    if (stepped && !check_tick(t_last, stabilizing, &reports)) ticks_bad++;
+    double wall = now_s() - wall_start;
+
+    double span = (double)(t_last - t_first) / 1e6;
+    printf("%u frames, %u motor commands, %.1f s recorded, replayed in %.3f s (%.0fx real time)\n",
+           (unsigned)frames, (unsigned)cmds, span, wall, wall > 0 ? span / wall : 0.0);
+    printf("%u ticks with mismatching commands, %u gaps\n", (unsigned)ticks_bad, (unsigned)gaps);
+    free(buf);
+    return ticks_bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,499 @@
+/*
+ * Runs many simulated sessions of the control logic (control_core.c) against the
+ * plant model and checks invariants on every control tick.
+ *
+ *   scenarios [-n count] [-j threads] [-d seconds] [-s index]
+ *
+ * Scenario i is generated from seed i, so a failure can be rerun alone with -s i
+ * (which also turns on the control logic's log output). The random mode seed is
+ * the scenario index too, so every scenario replays exactly at any -j.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "motor_control.h"
+#include "control_core.h"
+#include "axis_homing.h"
+#include "fake_hal.h"
+#include "plant.h"
+#include "work_pool.h"
+
+#define TICK_US                 20000
+#define LAUNCH_DEADLINE_US      500000      // key press to carriage back on switch 1
+#define MOTOR0_RUN_MAX_US       1500000     // launch motor never runs longer than this
+#define HOMING_MAX_US           35000000
+#define TRAVEL_TOLERANCE_PCT    10
+
+typedef enum
+{
+    SCN_JOY_SWEEP,      // joystick sweeps over the whole range on both axes
+    SCN_LAUNCH_KEYS,    // launches with keys pressed during the stroke
+    SCN_STUCK_SWITCH,   // a limit switch sticks asserted or open
+    SCN_BOUNCE,         // a limit switch bounces after each change
+    SCN_RANDOM_MODE,    // random mode runs, sometimes interrupted
+    SCN_MIXED,          // random operator input
+    SCN_KINDS,
+} scn_kind_t;
+
+static const char *const s_kind_names[SCN_KINDS] = {
+    "joy_sweep", "launch_keys", "stuck_switch", "bounce", "random_mode", "mixed",
+};
+
+typedef enum
+{
+    INV_LIMIT_CMD,      // a motor was started towards an asserted limit switch
+    INV_LIMIT_HOLD,     // a motor was still driving into an asserted switch after the tick
+    INV_MOTOR0_RUN,     // the launch motor ran too long in one go
+    INV_LAUNCH_TIME,    // a launch did not return the carriage within LAUNCH_DEADLINE_US
+    INV_HOMING_TIME,    // homing did not finish within HOMING_MAX_US
+    INV_TRAVEL,         // learned travel time differs from the mechanics
+    INV_REPEAT_CMD,     // random mode started an aim motor it was already running
+    INV_COUNT,
+} inv_t;
+
+static const char *const s_inv_names[INV_COUNT] = {
+    "limit_cmd", "limit_hold", "motor0_run", "launch_time", "homing_time", "travel", "repeat_cmd",
+};
+
+typedef struct
+{
+    uint32_t index;
+    scn_kind_t kind;
+    plant_t plant;
+    input_frame_t frame;
+    uint32_t rng;
+
+    // operator
+    int64_t op_until_us;
+    uint16_t joy_x, joy_y;
+    uint8_t key;
+    int64_t sweep_period_us;
+
+    // invariant tracking
+    int64_t launch_t0;
+    int64_t motor0_t0;
+    int64_t homing_t0;
+    motor_cmd_t last_cmd[3];
+    bool homing;
+    uint32_t violations[INV_COUNT];
+    bool failed;
+    char first[128];
+    uint64_t ticks;
+    uint32_t launches;
+} scn_t;
+
+typedef struct
+{
+    uint32_t first;     // index of results[0]
+    uint32_t count;
+    uint32_t duration_s;
+    scn_t *results;
+} run_t;
+
+static _Thread_local scn_t *tl_scn;
+static bool s_trace = false; // print every motor command (single scenario runs)
+
+static uint32_t scn_rand(scn_t *s)
+{
+    s->rng ^= s->rng << 13;
+    s->rng ^= s->rng >> 17;
+    s->rng ^= s->rng << 5;
+    return s->rng;
+}
+
+static uint32_t scn_range(scn_t *s, uint32_t lo, uint32_t hi)
+{
+    return lo + scn_rand(s) % (hi - lo + 1);
+}
+
+static void violate(scn_t *s, inv_t inv, const char *fmt, int a, int b)
+{
+    s->violations[inv]++;
+    if (!s->failed)
+    {
+        s->failed = true;
+        char what[80];
+        snprintf(what, sizeof(what), fmt, a, b);
+        snprintf(s->first, sizeof(s->first), "%s at t=%.2f s: %s", s_inv_names[inv], (double)s->frame.t_us / 1e6, what);
+    }
+}
+
+// Switch a motor drives into: motor 0 fwd -> 2, rev -> 1; motor 1 fwd -> 3, rev -> 4; ...
+static uint8_t target_switch(uint8_t motor, int8_t dir)
+{
+    if (motor == 0) return dir > 0 ? 2 : 1;
+    return (uint8_t)(dir > 0 ? 1 + 2 * motor : 2 + 2 * motor);
+}
+
+static bool switch_faulty(const scn_t *s, uint8_t sw)
+{
+    return s->plant.fault != PLANT_FAULT_NONE && s->plant.fault_switch == sw;
+}
+
+static void on_motor_cmd(const motor_cmd_t *cmd, void *arg)
+{
+    scn_t *s = tl_scn;
+    if (s_trace)
+    {
+        printf("  t=%.2f m%d %s\n", (double)s->frame.t_us / 1e6, cmd->motor,
+               cmd->dir > 0 ? "fwd" : (cmd->dir < 0 ? "rev" : "stop"));
+    }
+    if (cmd->dir != 0 && input_limit_hit(&s->frame, target_switch(cmd->motor, cmd->dir)))
+    {
+        violate(s, INV_LIMIT_CMD, "motor %d started into switch %d", cmd->motor, target_switch(cmd->motor, cmd->dir));
+    }
+    if (cmd->motor < 3)
+    {
+        const motor_cmd_t *last = &s->last_cmd[cmd->motor];
+        if (cmd->motor > 0 && cmd->dir != 0 && control_core_state() == STATE_IDLE &&
+            cmd->dir == last->dir && cmd->duty == last->duty)
+        {
+            violate(s, INV_REPEAT_CMD, "motor %d restarted at duty %d", cmd->motor, (int)cmd->duty);
+        }
+        s->last_cmd[cmd->motor] = *cmd;
+    }
+    if (cmd->motor == 0 && cmd->dir == 0 && s->plant.pos[0] <= 0.0)
+    {
+        s->launch_t0 = 0; // back home, a held key may start the next launch in the same tick
+    }
+    if (cmd->motor == 0 && cmd->dir > 0 && s->launch_t0 == 0)
+    {
+        s->launch_t0 = s->frame.t_us;
+        s->launches++;
+    }
+    plant_command(&s->plant, cmd);
+}
+
+//================================================================================
+// Operator input
+//================================================================================
+static uint16_t sweep(int64_t t_us, int64_t period_us)
+{
+    int64_t ph = t_us % period_us;
+    int64_t half = period_us / 2;
+    return (uint16_t)((ph < half ? ph : period_us - ph) * 4095 / half);
+}
+
+static void operator_mixed(scn_t *s)
+{
+    s->joy_x = INPUT_JOY_X_REST;
+    s->joy_y = INPUT_JOY_Y_REST;
+    s->key = 0;
+    uint32_t r = scn_range(s, 0, 99);
+    if (r < 30) s->joy_x = (uint16_t)scn_range(s, 0, 4095);
+    else if (r < 55) s->joy_y = (uint16_t)scn_range(s, 0, 4095);
+    else if (r < 70) s->key = 2;
+    else if (r < 75) s->key = 3;
+    else if (r < 77) s->key = 1;
+    s->op_until_us = s->frame.t_us + scn_range(s, 1, 100) * TICK_US;
+}
+
+static void operator_step(scn_t *s)
+{
+    int64_t t = s->frame.t_us;
+    switch (s->kind)
+    {
+    case SCN_JOY_SWEEP:
+        // alternate sweeps of X and Y with pauses at the centre
+        if ((t / s->sweep_period_us) % 3 == 0)
+        {
+            s->joy_x = sweep(t, s->sweep_period_us);
+            s->joy_y = INPUT_JOY_Y_REST;
+        }
+        else if ((t / s->sweep_period_us) % 3 == 1)
+        {
+            s->joy_x = INPUT_JOY_X_REST;
+            s->joy_y = sweep(t, s->sweep_period_us);
+        }
+        else
+        {
+            s->joy_x = INPUT_JOY_X_REST;
+            s->joy_y = INPUT_JOY_Y_REST;
+        }
+        break;
+
+    case SCN_LAUNCH_KEYS:
+        if (t < s->op_until_us) break;
+        if (s->key == 0)
+        {
+            // launch, then press a random key somewhere in the next few ticks
+            s->key = (s->launch_t0 != 0) ? (uint8_t)scn_range(s, 1, 3) : 2;
+            s->op_until_us = t + scn_range(s, 1, 5) * TICK_US;
+        }
+        else
+        {
+            s->key = 0;
+            s->op_until_us = t + ((scn_rand(s) & 1) ? scn_range(s, 1, 10) : scn_range(s, 50, 150)) * TICK_US;
+        }
+        break;
+
+    case SCN_RANDOM_MODE:
+        if (t < s->op_until_us) break;
+        if (s->key == 0 && s->joy_x == INPUT_JOY_X_REST)
+        {
+            uint32_t r = scn_range(s, 0, 9);
+            if (r < 7) s->key = 3;
+            else if (r < 9) s->joy_x = (uint16_t)scn_range(s, 0, 1400); // take over during random mode
+            else s->key = 1;
+            s->op_until_us = t + scn_range(s, 1, 20) * TICK_US;
+        }
+        else
+        {
+            s->key = 0;
+            s->joy_x = INPUT_JOY_X_REST;
+            s->op_until_us = t + scn_range(s, 50, 400) * TICK_US;
+        }
+        break;
+
+    default:
+        if (t >= s->op_until_us) operator_mixed(s);
+        break;
+    }
+
+    s->frame.joy_x = s->joy_x;
+    s->frame.joy_y = s->joy_y;
+    s->frame.gpio |= INPUT_KEY_BIT(1) | INPUT_KEY_BIT(2) | INPUT_KEY_BIT(3) | INPUT_KEY_BIT(4);
+    if (s->key) s->frame.gpio &= (uint16_t)~INPUT_KEY_BIT(s->key);
+
+    // potentiometer drifts slowly, ADC data arrives every tick
+    int pot = (int)s->frame.pot + (int)scn_range(s, 0, 40) - 20;
+    s->frame.pot = (uint16_t)(pot < 0 ? 0 : (pot > 4095 ? 4095 : pot));
+    s->frame.gpio |= INPUT_ADC_FRESH_BIT;
+
+    // the runtime reports the motor layer's position estimate once an axis is homed;
+    // the plant's true position stands in for it
+    for (int i = 0; i < INPUT_AIM_AXES; i++)
+    {
+        uint32_t fwd = 0, rev = 0;
+        axis_homing_get_travel((uint8_t)i, &fwd, &rev);
+        bool known = !axis_homing_busy() && fwd != 0;
+        s->frame.aim_pos[i] = known ? (int8_t)(s->plant.pos[1 + i] * 100.0) : -1;
+    }
+}
+
+//================================================================================
+// Invariants checked after every tick
+//================================================================================
+static void check_travel(scn_t *s)
+{
+    for (uint8_t axis = 0; axis < AXIS_COUNT; axis++)
+    {
+        uint8_t motor = axis + 1;
+        if (switch_faulty(s, 1 + 2 * motor) || switch_faulty(s, 2 + 2 * motor)) continue;
+
+        uint32_t fwd = 0, rev = 0;
+        axis_homing_get_travel(axis, &fwd, &rev);
+        uint32_t real = s->plant.travel_us[motor];
+        uint32_t tol = real * TRAVEL_TOLERANCE_PCT / 100;
+        if (fwd == 0 || (fwd + tol < real) || (fwd > real + tol) || (rev + tol < real) || (rev > real + tol))
+        {
+            violate(s, INV_TRAVEL, "motor %d learned %d ms", motor, (int)(fwd / 1000));
+        }
+    }
+}
+
+static void check_tick(scn_t *s)
+{
+    int64_t t = s->frame.t_us;
+
+    for (uint8_t m = 0; m < 3; m++)
+    {
+        int8_t dir = s->plant.dir[m];
+        if (dir != 0 && input_limit_hit(&s->frame, target_switch(m, dir)))
+        {
+            violate(s, INV_LIMIT_HOLD, "motor %d still driving into switch %d", m, target_switch(m, dir));
+        }
+    }
+
+    if (s->plant.dir[0] == 0) s->motor0_t0 = 0;
+    else if (s->motor0_t0 == 0) s->motor0_t0 = t;
+    else if (t - s->motor0_t0 > MOTOR0_RUN_MAX_US)
+    {
+        violate(s, INV_MOTOR0_RUN, "launch motor running for %d ms", (int)((t - s->motor0_t0) / 1000), 0);
+        s->motor0_t0 = t;
+    }
+
+    if (s->launch_t0 != 0)
+    {
+        bool home = (s->plant.pos[0] <= 0.0) && (s->plant.dir[0] == 0);
+        if (home || switch_faulty(s, 1) || switch_faulty(s, 2))
+        {
+            if (s->plant.dir[0] == 0) s->launch_t0 = 0;
+        }
+        else if (t - s->launch_t0 > LAUNCH_DEADLINE_US)
+        {
+            violate(s, INV_LAUNCH_TIME, "carriage not back after %d ms", (int)((t - s->launch_t0) / 1000), 0);
+            s->launch_t0 = 0;
+        }
+    }
+
+    bool homing = (control_core_state() == STATE_HOMING);
+    if (homing && !s->homing) s->homing_t0 = t;
+    if (homing && t - s->homing_t0 > HOMING_MAX_US)
+    {
+        violate(s, INV_HOMING_TIME, "homing for %d s", (int)((t - s->homing_t0) / 1000000), 0);
+        s->homing_t0 = t;
+    }
+    if (!homing && s->homing) check_travel(s);
+    s->homing = homing;
+}
+
+//================================================================================
+// One scenario
+//================================================================================
+static void scn_setup(scn_t *s, uint32_t index)
+{
+    memset(s, 0, sizeof(*s));
+    s->index = index;
+    s->rng = index * 2654435761u + 0x9e3779b9u;
+    if (s->rng == 0) s->rng = 1;
+    scn_rand(s);
+    s->kind = (scn_kind_t)(index % SCN_KINDS);
+
+    plant_init(&s->plant, scn_rand(s));
+    s->plant.travel_us[1] = scn_range(s, 800, 2500) * 1000;
+    s->plant.travel_us[2] = scn_range(s, 800, 2500) * 1000;
+    s->plant.pos[1] = scn_range(s, 0, 1000) / 1000.0;
+    s->plant.pos[2] = scn_range(s, 0, 1000) / 1000.0;
+
+    if (s->kind == SCN_STUCK_SWITCH)
+    {
+        s->plant.fault = (scn_rand(s) & 1) ? PLANT_FAULT_STUCK_HIT : PLANT_FAULT_STUCK_OPEN;
+        s->plant.fault_switch = (uint8_t)scn_range(s, 1, PLANT_SWITCHES);
+        s->plant.fault_from_us = (int64_t)scn_range(s, 0, 30) * 1000000;
+    }
+    else if (s->kind == SCN_BOUNCE)
+    {
+        s->plant.fault = PLANT_FAULT_BOUNCE;
+        s->plant.fault_switch = (uint8_t)scn_range(s, 1, PLANT_SWITCHES);
+        s->plant.bounce_us = scn_range(s, 5, 60) * 1000;
+    }
+    s->sweep_period_us = (int64_t)scn_range(s, 2, 10) * 1000000;
+
+    // travel already learned on an earlier boot, or a fresh board
+    fake_nvs_clear();
+    if (scn_rand(s) & 1)
+    {
+        fake_nvs_set_u32("axis", "m1_fwd", s->plant.travel_us[1]);
+        fake_nvs_set_u32("axis", "m1_rev", s->plant.travel_us[1]);
+        fake_nvs_set_u32("axis", "m2_fwd", s->plant.travel_us[2]);
+        fake_nvs_set_u32("axis", "m2_rev", s->plant.travel_us[2]);
+    }
+
+    const input_frame_t idle = INPUT_FRAME_INIT;
+    s->frame = idle;
+    s->frame.pot = (uint16_t)scn_range(s, 0, 4095);
+    s->joy_x = INPUT_JOY_X_REST;
+    s->joy_y = INPUT_JOY_Y_REST;
+}
+
+static void run_scenario(uint32_t index, int worker, void *arg)
+{
+    run_t *run = (run_t *)arg;
+    scn_t *s = &run->results[index - run->first];
+    scn_setup(s, index);
+    tl_scn = s;
+
+    const motor_brake_config_t launch_brake = {.mode = MOTOR_STOP_BRAKE, .ramp_ms = 0, .reverse_dead_ms = 30};
+    const motor_brake_config_t aim_brake = {.mode = MOTOR_STOP_RAMP, .ramp_ms = 80, .reverse_dead_ms = 30};
+    motor_set_brake_config(0, &launch_brake);
+    motor_set_brake_config(1, &aim_brake);
+    motor_set_brake_config(2, &aim_brake);
+    motor_set_cmd_hook(on_motor_cmd, NULL);
+    control_core_init();
+    control_core_set_seed(index);
+
+    int64_t end_us = (int64_t)run->duration_s * 1000000;
+    for (int64_t t = TICK_US; t <= end_us; t += TICK_US)
+    {
+        plant_advance(&s->plant, t, &s->frame);
+        operator_step(s);
+        control_core_step(&s->frame);
+        check_tick(s);
+        s->ticks++;
+    }
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    run_t run = {.count = 10000, .duration_s = 40};
+    int workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    long single = -1;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:j:d:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': run.count = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'j': workers = atoi(optarg); break;
+        case 'd': run.duration_s = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 's': single = strtol(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-n count] [-j threads] [-d seconds] [-s index]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (workers < 1) workers = 1;
+
+    if (single >= 0)
+    {
+        scn_t s;
+        run.results = &s;
+        run.first = (uint32_t)single;
+        host_log_level = 3;
+        s_trace = true;
+        run_scenario((uint32_t)single, 0, &run);
+        printf("scenario %ld (%s): %s\n", single, s_kind_names[s.kind], s.failed ? s.first : "ok");
+        return s.failed ? 1 : 0;
+    }
+
+    run.results = calloc(run.count, sizeof(scn_t));
+    work_stats_t *stats = calloc((size_t)workers, sizeof(work_stats_t));
+    if (!run.results || !stats) return 2;
+
+    double t0 = now_s();
+    work_pool_run(run.count, workers, run_scenario, &run, stats);
+    double wall = now_s() - t0;
+
+    uint32_t runs[SCN_KINDS] = {0}, fails[SCN_KINDS] = {0}, inv[INV_COUNT] = {0};
+    uint32_t failed = 0, launches = 0, steals = 0;
+    uint64_t ticks = 0;
+    for (uint32_t i = 0; i < run.count; i++)
+    {
+        const scn_t *s = &run.results[i];
+        runs[s->kind]++;
+        ticks += s->ticks;
+        launches += s->launches;
+        for (int k = 0; k < INV_COUNT; k++) inv[k] += s->violations[k];
+        if (s->failed)
+        {
+            fails[s->kind]++;
+            if (failed++ < 10) printf("  #%u %s: %s\n", (unsigned)i, s_kind_names[s->kind], s->first);
+        }
+    }
+    for (int w = 0; w < workers; w++) steals += stats[w].steals;
+
+    printf("\n%-14s %8s %8s\n", "scenario", "runs", "failing");
+    for (int k = 0; k < SCN_KINDS; k++) printf("%-14s %8u %8u\n", s_kind_names[k], (unsigned)runs[k], (unsigned)fails[k]);
+    printf("\n%-14s %8s\n", "invariant", "hits");
+    for (int k = 0; k < INV_COUNT; k++) printf("%-14s %8u\n", s_inv_names[k], (unsigned)inv[k]);
+
+    printf("\n%u scenarios (%u failing), %u launches, %.0f s simulated each\n",
+           (unsigned)run.count, (unsigned)failed, (unsigned)launches, (double)run.duration_s);
+    printf("%d workers, %u steals, %.2f s wall: %.0f scenarios/s, %.1f M ticks/s\n",
+           workers, (unsigned)steals, wall, run.count / wall, (double)ticks / wall / 1e6);
+
+    free(stats);
+    free(run.results);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,23 @@
+#ifndef _HOST_ESP_ERR_H_
+#define _HOST_ESP_ERR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+// Subset of esp_err.h for host builds of the control logic.
+
+typedef int esp_err_t;
+
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_NO_MEM          0x101
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_NOT_FOUND       0x105
+#define ESP_ERR_INVALID_VERSION 0x10A
+#define ESP_ERR_NVS_NOT_FOUND   0x1102
+
+const char *esp_err_to_name(esp_err_t code);
+
+#endif // !_HOST_ESP_ERR_H_
@@ -0,0 +1,21 @@
+#ifndef _HOST_ESP_LOG_H_
+#define _HOST_ESP_LOG_H_
+
+#include <stdio.h>
+#include <inttypes.h>
+
+// Log macros for host builds; output is off unless host_log_level is raised.
+
+extern int host_log_level; // 0 none, 1 error, 2 warn, 3 info, 4 debug
+
+#define HOST_LOG_(lvl, c, tag, fmt, ...)                                            \
+    do {                                                                            \
+        if (host_log_level >= (lvl)) printf(c " (%s) " fmt "\n", tag, ##__VA_ARGS__); \
+    } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG_(1, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG_(2, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG_(3, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG_(4, "D", tag, fmt, ##__VA_ARGS__)
+
+#endif // !_HOST_ESP_LOG_H_
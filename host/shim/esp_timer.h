@@ -0,0 +1,16 @@
+#ifndef _HOST_ESP_TIMER_H_
+#define _HOST_ESP_TIMER_H_
+
+#include <stdint.h>
+#include <time.h>
+
+// Microsecond clock for host builds; the control logic itself takes time from frames.
+
+static inline int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#endif // !_HOST_ESP_TIMER_H_
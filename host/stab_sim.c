@@ -0,0 +1,214 @@
+/*
+ * Closed-loop test of the stabilization path (imu_sim -> attitude -> stab_ctrl) on a
+ * platform whose base turns and tilts. The base follows slow sinusoids, the two aim
+ * motors are first-order speed models with stiction, and the IMU sees the platform's
+ * true motion at IMU_RATE_HZ while the controller runs every STAB_PERIOD_US, like
+ * stabilizer.c on the device. Halfway through, a joystick rate command moves the
+ * target for a few seconds.
+ *
+ *   stab_sim [-d seconds] [-s seed] [-v]
+ *
+ * Reports the hold error with and without stabilization, the attitude filter error
+ * and the cost of one control period. Exits non-zero when stabilization does not
+ * cut the RMS hold error at least STAB_SIM_MIN_GAIN times.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "imu.h"
+#include "attitude.h"
+#include "stab_ctrl.h"
+#include "stabilizer.h"
+
+#define SIM_MOTOR_DPS       60.0    // platform rate at full duty
+#define SIM_MOTOR_TAU_S     0.05
+#define SIM_MOTOR_STICTION  1000    // duty below which the axis does not move
+#define SIM_DUTY_STEP       100     // as STAB_DUTY_STEP
+#define STAB_SIM_MIN_GAIN   4.0
+
+typedef struct
+{
+    double amp_deg;
+    double freq_hz;
+} base_motion_t;
+
+static const base_motion_t s_base[STAB_AXES] = {
+    {10.0, 0.3},    // yaw
+    {5.0, 0.5},     // pitch
+};
+
+// same gains as stabilizer.c
+static const stab_gains_t s_gains = {
+    .kp = FIXQ_ONE * 3,
+    .kd = FIXQ_ONE / 10,
+    .duty_min = 1500,
+    .duty_max = 9000,
+};
+
+typedef struct
+{
+    double sum_sq;
+    double max;
+    uint32_t n;
+} err_stat_t;
+
+static void err_add(err_stat_t *e, double v)
+{
+    e->sum_sq += v * v;
+    if (fabs(v) > e->max) e->max = fabs(v);
+    e->n++;
+}
+
+static double err_rms(const err_stat_t *e)
+{
+    return e->n ? sqrt(e->sum_sq / e->n) : 0.0;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Joystick rate command (deg/s) at time t of a run lasting d seconds.
+static void rate_cmd(double t, double d, double cmd[STAB_AXES])
+{
+    bool on = t > d * 0.4 && t < d * 0.55;
+    cmd[0] = on ? 10.0 : 0.0;
+    cmd[1] = on ? -5.0 : 0.0;
+}
+
+typedef struct
+{
+    err_stat_t hold[STAB_AXES];     // platform against the commanded attitude
+    err_stat_t filter[STAB_AXES];   // attitude estimate against truth
+    uint32_t periods;
+    int64_t ctrl_ns;
+} run_t;
+
+static void run(double duration_s, uint32_t seed, bool stabilize, bool verbose, run_t *r)
+{
+    const double dt = 1.0 / IMU_RATE_HZ;
+    const int samples_per_period = STAB_PERIOD_US * IMU_RATE_HZ / 1000000;
+    attitude_t att;
+    stab_ctrl_t ctrl;
+    double motor_deg[STAB_AXES] = {0}, motor_dps[STAB_AXES] = {0};
+    double target_deg[STAB_AXES] = {0};
+    int32_t duty[STAB_AXES] = {0};
+    bool holding = false;
+
+    imu_sim_seed(seed);
+    attitude_init(&att);
+    stab_ctrl_init(&ctrl, &s_gains);
+
+    // platform at rest while the gyro bias is estimated, then the base starts moving
+    double t_move = (double)ATTITUDE_BIAS_SAMPLES / IMU_RATE_HZ;
+    int total = (int)((t_move + duration_s) * IMU_RATE_HZ);
+    for (int k = 0; k < total; k++)
+    {
+        double t = k * dt;
+        double tm = t > t_move ? t - t_move : 0.0;
+        double cmd[STAB_AXES];
+        rate_cmd(tm, duration_s, cmd);
+
+        double plat_deg[STAB_AXES], plat_dps[STAB_AXES];
+        for (int i = 0; i < STAB_AXES; i++)
+        {
+            double w = 2.0 * M_PI * s_base[i].freq_hz;
+            double base_deg = t > t_move ? s_base[i].amp_deg * sin(w * tm) : 0.0;
+            double base_dps = t > t_move ? s_base[i].amp_deg * w * cos(w * tm) : 0.0;
+
+            int32_t mag = duty[i] < 0 ? -duty[i] : duty[i];
+            double drive = mag < SIM_MOTOR_STICTION ? 0.0 : SIM_MOTOR_DPS * duty[i] / 10000.0;
+            motor_dps[i] += (drive - motor_dps[i]) * dt / SIM_MOTOR_TAU_S;
+            motor_deg[i] += motor_dps[i] * dt;
+
+            plat_deg[i] = base_deg + motor_deg[i];
+            plat_dps[i] = base_dps + motor_dps[i];
+        }
+
+        imu_sim_truth_t truth = {
+            .rate_dps = {0.0f, (float)plat_dps[1], (float)plat_dps[0]},
+            .pitch_deg = (float)plat_deg[1],
+        };
+        imu_sample_t s;
+        imu_sim_encode(&truth, &s);
+
+        int64_t t0 = now_ns();
+        attitude_update(&att, &s);
+        bool control = (k % samples_per_period) == samples_per_period - 1;
+        if (control && stabilize && attitude_ready(&att))
+        {
+            if (!holding)
+            {
+                stab_ctrl_hold(&ctrl, &att);
+                holding = true;
+            }
+            stab_ctrl_set_rate(&ctrl, (int32_t)(cmd[0] * 1000), (int32_t)(cmd[1] * 1000));
+            stab_ctrl_step(&ctrl, &att, STAB_PERIOD_US, duty);
+            for (int i = 0; i < STAB_AXES; i++) duty[i] = duty[i] / SIM_DUTY_STEP * SIM_DUTY_STEP;
+        }
+        if (control)
+        {
+            r->ctrl_ns += now_ns() - t0;
+            r->periods++;
+        }
+
+        if (t <= t_move) continue;
+        for (int i = 0; i < STAB_AXES; i++)
+        {
+            target_deg[i] += cmd[i] * dt;
+            err_add(&r->hold[i], plat_deg[i] - target_deg[i]);
+        }
+        err_add(&r->filter[0], att.yaw_mdeg / 1000.0 - plat_deg[0]);
+        err_add(&r->filter[1], att.pitch_mdeg / 1000.0 - plat_deg[1]);
+        if (verbose && stabilize && k % 100 == 0)
+        {
+            printf("%7.2f  yaw %7.2f / %7.2f  pitch %7.2f / %7.2f  duty %5d %5d\n", tm,
+                   plat_deg[0], target_deg[0], plat_deg[1], target_deg[1], (int)duty[0], (int)duty[1]);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double duration_s = 20.0;
+    uint32_t seed = 1;
+    bool verbose = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:s:v")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd': duration_s = atof(optarg); break;
+        case 's': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'v': verbose = true; break;
+        default:
+            fprintf(stderr, "usage: %s [-d seconds] [-s seed] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    run_t open = {0}, closed = {0};
+    run(duration_s, seed, false, false, &open);
+    run(duration_s, seed, true, verbose, &closed);
+
+    static const char *axis[STAB_AXES] = {"yaw", "pitch"};
+    bool ok = true;
+    printf("%.0f s, base yaw %.0f deg @ %.1f Hz, pitch %.0f deg @ %.1f Hz, control %d Hz\n", duration_s,
+           s_base[0].amp_deg, s_base[0].freq_hz, s_base[1].amp_deg, s_base[1].freq_hz, 1000000 / STAB_PERIOD_US);
+    for (int i = 0; i < STAB_AXES; i++)
+    {
+        double gain = err_rms(&closed.hold[i]) > 0 ? err_rms(&open.hold[i]) / err_rms(&closed.hold[i]) : 0.0;
+        printf("  %-5s hold error rms/max: off %6.2f/%6.2f deg, on %6.2f/%6.2f deg (x%.1f), filter %5.2f/%5.2f deg\n",
+               axis[i], err_rms(&open.hold[i]), open.hold[i].max, err_rms(&closed.hold[i]), closed.hold[i].max,
+               gain, err_rms(&closed.filter[i]), closed.filter[i].max);
+        if (gain < STAB_SIM_MIN_GAIN) ok = false;
+    }
+    printf("  filter + controller: %.0f ns per control period\n",
+           closed.periods ? (double)closed.ctrl_ns / closed.periods : 0.0);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include "work_pool.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    uint32_t next;
+    uint32_t end;
+    work_stats_t stats;
+    char pad[64]; // keep neighbouring slices off one cache line
+} work_slice_t;
+
+typedef struct
+{
+    work_slice_t *slices;
+    int workers;
+    work_fn_t fn;
+    void *arg;
+} work_pool_t;
+
+typedef struct
+{
+    work_pool_t *pool;
+    int self;
+} work_thread_t;
+
+static bool take_own(work_slice_t *s, uint32_t *index)
+{
+    pthread_mutex_lock(&s->lock);
+    bool ok = s->next < s->end;
+    if (ok) *index = s->next++;
+    pthread_mutex_unlock(&s->lock);
+    return ok;
+}
+
+// Moves the back half of a victim's slice to `self`; false if every slice is empty.
+static bool steal(work_pool_t *pool, int self, unsigned *seed)
+{
+    int start = (int)(rand_r(seed) % (unsigned)pool->workers);
+    for (int i = 0; i < pool->workers; i++)
+    {
+        int v = (start + i) % pool->workers;
+        if (v == self) continue;
+
+        work_slice_t *victim = &pool->slices[v];
+        pthread_mutex_lock(&victim->lock);
+        uint32_t left = victim->end - victim->next;
+        uint32_t from = victim->end - (left + 1) / 2;
+        uint32_t to = victim->end;
+        if (left > 0) victim->end = from;
+        pthread_mutex_unlock(&victim->lock);
+        if (left == 0) continue;
+
+        work_slice_t *mine = &pool->slices[self];
+        pthread_mutex_lock(&mine->lock);
+        mine->next = from;
+        mine->end = to;
+        mine->stats.steals++;
+        pthread_mutex_unlock(&mine->lock);
+        return true;
+    }
+    return false;
+}
+
+static void *work_thread(void *p)
+{
+    work_thread_t *t = (work_thread_t *)p;
+    work_pool_t *pool = t->pool;
+    work_slice_t *mine = &pool->slices[t->self];
+    unsigned seed = (unsigned)t->self * 2654435761u + 1;
+
+    while (1)
+    {
+        uint32_t index;
+        if (take_own(mine, &index))
+        {
+            pool->fn(index, t->self, pool->arg);
+            mine->stats.done++;
+        }
+        else if (!steal(pool, t->self, &seed))
+        {
+            break; // work is never added, so one empty sweep means we are done
+        }
+    }
+    return NULL;
+}
+
+int work_pool_run(uint32_t count, int workers, work_fn_t fn, void *arg, work_stats_t *stats)
+{
+    if (workers < 1) workers = 1;
+    work_pool_t pool = {.workers = workers, .fn = fn, .arg = arg};
+    pool.slices = calloc((size_t)workers, sizeof(work_slice_t));
+    pthread_t *threads = calloc((size_t)workers, sizeof(pthread_t));
+    work_thread_t *args = calloc((size_t)workers, sizeof(work_thread_t));
+    if (!pool.slices || !threads || !args)
+    {
+        free(pool.slices);
+        free(threads);
+        free(args);
+        return -1;
+    }
+
+    for (int i = 0; i < workers; i++)
+    {
+        pthread_mutex_init(&pool.slices[i].lock, NULL);
+        pool.slices[i].next = (uint32_t)((uint64_t)count * i / workers);
+        pool.slices[i].end = (uint32_t)((uint64_t)count * (i + 1) / workers);
+        args[i].pool = &pool;
+        args[i].self = i;
+    }
+    int started = 0;
+    for (; started < workers; started++)
+    {
+        if (pthread_create(&threads[started], NULL, work_thread, &args[started]) != 0) break;
+    }
+    if (started == 0) work_thread(&args[0]); // no threads available, run inline
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (int i = 0; i < workers; i++)
+    {
+        if (stats) stats[i] = pool.slices[i].stats;
+        pthread_mutex_destroy(&pool.slices[i].lock);
+    }
+    free(pool.slices);
+    free(threads);
+    free(args);
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef _WORK_POOL_H_
+#define _WORK_POOL_H_
+
+#include <stdint.h>
+
+/*
+ * Runs fn(index) for index 0..count-1 on a set of threads. Each worker starts with
+ * an equal slice of the index range and takes items from its front; a worker that
+ * runs dry steals the back half of another worker's remaining slice.
+ */
+
+typedef void (*work_fn_t)(uint32_t index, int worker, void *arg);
+
+typedef struct
+{
+    uint32_t done;      // items this worker ran
+    uint32_t steals;    // successful steals
+} work_stats_t;
+
+// stats may be NULL, otherwise it holds one entry per worker.
+int work_pool_run(uint32_t count, int workers, work_fn_t fn, void *arg, work_stats_t *stats);
+
+#endif // !_WORK_POOL_H_
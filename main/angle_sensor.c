@@ -0,0 +1,139 @@
+#include "angle_sensor.h"
+#include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+static const char *TAG = "ANGLE";
+
+typedef struct
+{
+    angle_sample_t buf[2];  // the newest sample is buf[pub & 1], the writer fills the other
+    atomic_uint pub;        // samples published so far
+    atomic_bool busy;       // a read is in flight
+    int64_t t_start_us;
+    angle_sensor_stats_t stats;
+} angle_axis_t;
+
+static angle_axis_t s_axis[ANGLE_AXES];
+static const angle_backend_t *s_backend = NULL;
+
+static void stats_reset(angle_sensor_stats_t *st, int64_t now)
+{
+    memset(st, 0, sizeof(*st));
+    st->latency_min_us = UINT32_MAX;
+    st->since_us = now;
+}
+
+esp_err_t angle_sensor_init(const angle_backend_t *backend)
+{
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < ANGLE_AXES; i++)
+    {
+        angle_axis_t *ax = &s_axis[i];
+        memset(ax->buf, 0, sizeof(ax->buf));
+        atomic_init(&ax->pub, 0);
+        atomic_init(&ax->busy, false);
+        stats_reset(&ax->stats, now);
+    }
+    esp_err_t ret = backend->init();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "%s init failed: %s", backend->name, esp_err_to_name(ret));
+        return ret;
+    }
+    s_backend = backend;
+    ESP_LOGI(TAG, "angle sensors: %s", backend->name);
+    return ESP_OK;
+}
+
+void angle_sensor_trigger(void)
+{
+    if (s_backend == NULL) return;
+    if (s_backend->poll) s_backend->poll();
+
+    for (uint8_t i = 0; i < ANGLE_AXES; i++)
+    {
+        angle_axis_t *ax = &s_axis[i];
+        if (atomic_exchange(&ax->busy, true))
+        {
+            ax->stats.overruns++;
+            continue;
+        }
+        ax->t_start_us = esp_timer_get_time();
+        if (!s_backend->start(i, ax->t_start_us))
+        {
+            ax->stats.errors++;
+            atomic_store(&ax->busy, false);
+        }
+    }
+}
+
+void IRAM_ATTR angle_sensor_complete(uint8_t axis, uint16_t angle, bool ok)
+{
+    if (axis >= ANGLE_AXES) return;
+    angle_axis_t *ax = &s_axis[axis];
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - ax->t_start_us);
+
+    unsigned n = atomic_load_explicit(&ax->pub, memory_order_relaxed) + 1;
+    angle_sample_t *dst = &ax->buf[n & 1];
+    dst->angle = angle;
+    dst->ok = ok;
+    dst->seq = n;
+    dst->t_us = ax->t_start_us;
+    dst->latency_us = latency;
+    atomic_store_explicit(&ax->pub, n, memory_order_release);
+
+    angle_sensor_stats_t *st = &ax->stats;
+    st->reads++;
+    if (!ok) st->errors++;
+    if (latency < st->latency_min_us) st->latency_min_us = latency;
+    if (latency > st->latency_max_us) st->latency_max_us = latency;
+    st->latency_sum_us += latency;
+    st->busy_us += latency;
+    atomic_store(&ax->busy, false);
+}
+
+bool angle_sensor_get(uint8_t axis, angle_sample_t *out)
+{
+    if (axis >= ANGLE_AXES) return false;
+    angle_axis_t *ax = &s_axis[axis];
+    while (1)
+    {
+        unsigned n = atomic_load_explicit(&ax->pub, memory_order_acquire);
+        if (n == 0) return false;
+        *out = ax->buf[n & 1];
+        atomic_thread_fence(memory_order_acquire);
+        // the writer only starts on this buffer after publishing n + 1, so if
+        // nothing was published during the copy it is consistent
+        if (atomic_load_explicit(&ax->pub, memory_order_relaxed) == n) return true;
+    }
+}
+
+// Counters are updated from the completion ISR without a lock; a report taken
+// while a read finishes may be off by one sample.
+void angle_sensor_get_stats(uint8_t axis, angle_sensor_stats_t *stats, bool reset)
+{
+    if (axis >= ANGLE_AXES) return;
+    *stats = s_axis[axis].stats;
+    if (stats->reads == 0) stats->latency_min_us = 0;
+    if (reset) stats_reset(&s_axis[axis].stats, esp_timer_get_time());
+}
+
+void angle_sensor_log_stats(void)
+{
+    int64_t now = esp_timer_get_time();
+    for (uint8_t i = 0; i < ANGLE_AXES; i++)
+    {
+        angle_sensor_stats_t st;
+        angle_sensor_get_stats(i, &st, true);
+        int64_t window = now - st.since_us;
+        uint32_t avg = st.reads ? (uint32_t)(st.latency_sum_us / st.reads) : 0;
+        uint32_t busy_permille = window > 0 ? (uint32_t)(st.busy_us * 1000 / (uint64_t)window) : 0;
+        ESP_LOGI(TAG, "axis %d: %" PRIu32 " reads, %" PRIu32 " errors, %" PRIu32 " overruns, latency %" PRIu32 "/%" PRIu32 "/%" PRIu32 " us, bus %" PRIu32 ".%" PRIu32 "%%",
+                 i + 1, st.reads, st.errors, st.overruns, st.latency_min_us, avg, st.latency_max_us,
+                 busy_permille / 10, busy_permille % 10);
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef _ANGLE_SENSOR_H_
+#define _ANGLE_SENSOR_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * Absolute angle of the aim axes (motors 1 and 2) from magnetic encoders.
+ *
+ * angle_sensor_trigger() queues one asynchronous bus transaction per axis and
+ * returns at once; the backend's completion callback (ISR context) publishes the
+ * result into a double-buffered slot per axis. angle_sensor_get() copies the newest
+ * sample without locks or waiting, so the control loop never blocks on the bus.
+ *
+ * Backends: AS5600 over I2C (one bus per sensor, the address is fixed), AS5047 over
+ * SPI with DMA (both sensors on one bus), and a simulated sensor for host builds
+ * and boards without encoders.
+ */
+
+#define ANGLE_AXES          2
+#define ANGLE_TURN          65536u  // angle units per revolution
+
+typedef struct
+{
+    uint16_t angle;     // 0..65535 per turn
+    bool ok;            // false: bus error or the sensor flagged a fault
+    uint32_t seq;       // increments with every published sample
+    int64_t t_us;       // when the read was triggered
+    uint32_t latency_us; // trigger -> completion
+} angle_sample_t;
+
+typedef struct
+{
+    uint32_t reads;
+    uint32_t errors;
+    uint32_t overruns;      // triggers skipped because the previous read was still in flight
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+    uint64_t latency_sum_us;
+    uint64_t busy_us;       // sum of trigger -> completion time
+    int64_t since_us;       // start of the counting window
+} angle_sensor_stats_t;
+
+typedef struct
+{
+    const char *name;
+    esp_err_t (*init)(void);
+    bool (*start)(uint8_t axis, int64_t t_us); // queue a read sampled at t_us, false if not queued
+    void (*poll)(void);          // optional, task context: reap finished transfers
+} angle_backend_t;
+
+extern const angle_backend_t angle_backend_as5600;
+extern const angle_backend_t angle_backend_as5047;
+extern const angle_backend_t angle_backend_sim;
+
+esp_err_t angle_sensor_init(const angle_backend_t *backend);
+void angle_sensor_trigger(void);                         // task context, e.g. the control timer
+bool angle_sensor_get(uint8_t axis, angle_sample_t *out); // false until the first sample
+void angle_sensor_get_stats(uint8_t axis, angle_sensor_stats_t *stats, bool reset);
+void angle_sensor_log_stats(void);
+
+// Called by the backends when a read finishes (ISR safe).
+void angle_sensor_complete(uint8_t axis, uint16_t angle, bool ok);
+
+// Simulated sensor: constant speed from a start angle, fixed transfer time.
+void angle_sensor_sim_set(uint8_t axis, uint16_t angle, int32_t turns_per_s_q16);
+void angle_sensor_sim_set_latency(uint32_t latency_us);
+uint16_t angle_sensor_sim_angle(uint8_t axis, int64_t t_us); // ground truth at t_us
+
+#endif // !_ANGLE_SENSOR_H_
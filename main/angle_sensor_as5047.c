@@ -0,0 +1,106 @@
+#include "angle_sensor.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/spi_master.h"
+
+static const char *TAG = "AS5047";
+
+// Both sensors share one SPI bus with a chip select each. As with the AS5600, the
+// pins are placeholders until the board has spare GPIOs.
+#define AS5047_HOST             SPI2_HOST
+#define AS5047_SCLK             GPIO_NUM_NC
+#define AS5047_MOSI             GPIO_NUM_NC
+#define AS5047_MISO             GPIO_NUM_NC
+#define AS5047_CS1              GPIO_NUM_NC
+#define AS5047_CS2              GPIO_NUM_NC
+
+#define AS5047_CLOCK_HZ         10000000 // 2 frames of 16 bit: ~4 us per read
+#define AS5047_CMD_ANGLECOM     0xffff   // read 0x3fff, parity bit set
+#define AS5047_CMD_NOP          0xc000   // read 0x0000, parity bit set
+#define AS5047_ERROR_FLAG       0x4000
+
+static const gpio_num_t s_cs_pins[ANGLE_AXES] = {AS5047_CS1, AS5047_CS2};
+static spi_device_handle_t s_dev[ANGLE_AXES];
+// The answer to a command comes in the next frame: frame 0 sends the read,
+// frame 1 clocks the angle out while sending a NOP.
+static spi_transaction_t s_trans[ANGLE_AXES][2];
+
+static void IRAM_ATTR as5047_post_cb(spi_transaction_t *trans)
+{
+    uintptr_t user = (uintptr_t)trans->user;
+    if ((user & 0x80) == 0) return; // first frame of the pair
+    uint8_t axis = (uint8_t)(user & 0x7f);
+    uint16_t v = (uint16_t)((trans->rx_data[0] << 8) | trans->rx_data[1]);
+    bool ok = !(v & AS5047_ERROR_FLAG) && (__builtin_parity(v) == 0);
+    angle_sensor_complete(axis, (uint16_t)((v & 0x3fff) << 2), ok);
+}
+
+static esp_err_t as5047_init(void)
+{
+    if (AS5047_SCLK == GPIO_NUM_NC)
+    {
+        ESP_LOGW(TAG, "no SPI pins assigned");
+        return ESP_ERR_NOT_FOUND;
+    }
+    spi_bus_config_t bus_cfg = {
+        .sclk_io_num = AS5047_SCLK,
+        .mosi_io_num = AS5047_MOSI,
+        .miso_io_num = AS5047_MISO,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = 4,
+    };
+    ESP_ERROR_CHECK(spi_bus_initialize(AS5047_HOST, &bus_cfg, SPI_DMA_CH_AUTO));
+
+    for (int i = 0; i < ANGLE_AXES; i++)
+    {
+        spi_device_interface_config_t dev_cfg = {
+            .mode = 1,
+            .clock_speed_hz = AS5047_CLOCK_HZ,
+            .spics_io_num = s_cs_pins[i],
+            .cs_ena_posttrans = 1, // CSn high time between frames
+            .queue_size = 4,
+            .post_cb = as5047_post_cb,
+        };
+        ESP_ERROR_CHECK(spi_bus_add_device(AS5047_HOST, &dev_cfg, &s_dev[i]));
+
+        for (int f = 0; f < 2; f++)
+        {
+            uint16_t cmd = f ? AS5047_CMD_NOP : AS5047_CMD_ANGLECOM;
+            spi_transaction_t *t = &s_trans[i][f];
+            t->length = 16;
+            t->flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+            t->tx_data[0] = (uint8_t)(cmd >> 8);
+            t->tx_data[1] = (uint8_t)cmd;
+            t->user = (void *)(uintptr_t)(i | (f ? 0x80 : 0));
+        }
+    }
+    return ESP_OK;
+}
+
+static bool as5047_start(uint8_t axis, int64_t t_us)
+{
+    if (spi_device_queue_trans(s_dev[axis], &s_trans[axis][0], 0) != ESP_OK) return false;
+    // the first frame is already queued, the second must follow or the pair is lost
+    return spi_device_queue_trans(s_dev[axis], &s_trans[axis][1], portMAX_DELAY) == ESP_OK;
+}
+
+// Queued transactions have to be collected before they can be queued again.
+static void as5047_poll(void)
+{
+    for (int i = 0; i < ANGLE_AXES; i++)
+    {
+        spi_transaction_t *t;
+        while (spi_device_get_trans_result(s_dev[i], &t, 0) == ESP_OK)
+        {
+        }
+    }
+}
+
+const angle_backend_t angle_backend_as5047 = {
+    .name = "AS5047 (SPI, DMA)",
+    .init = as5047_init,
+    .start = as5047_start,
+    .poll = as5047_poll,
+};
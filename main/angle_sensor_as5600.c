@@ -0,0 +1,89 @@
+#include "angle_sensor.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "driver/i2c_master.h"
+
+static const char *TAG = "AS5600";
+
+// The AS5600 address is fixed, so each sensor gets its own I2C port. The current
+// board has no spare pins for the second bus; assign them with the next revision.
+#define AS5600_SDA1             GPIO_NUM_2
+#define AS5600_SCL1             GPIO_NUM_0
+#define AS5600_SDA2             GPIO_NUM_NC
+#define AS5600_SCL2             GPIO_NUM_NC
+
+#define AS5600_ADDR             0x36
+#define AS5600_REG_RAW_ANGLE    0x0c    // 12 bit, unfiltered
+#define AS5600_SCL_HZ           1000000 // fast mode plus: ~45 us per read
+
+static const struct
+{
+    i2c_port_num_t port;
+    gpio_num_t sda;
+    gpio_num_t scl;
+} s_bus_pins[ANGLE_AXES] = {
+    {I2C_NUM_0, AS5600_SDA1, AS5600_SCL1},
+    {I2C_NUM_1, AS5600_SDA2, AS5600_SCL2},
+};
+
+static i2c_master_dev_handle_t s_dev[ANGLE_AXES];
+static const uint8_t s_reg = AS5600_REG_RAW_ANGLE;
+static uint8_t s_rx[ANGLE_AXES][2];
+
+static bool IRAM_ATTR as5600_done(i2c_master_dev_handle_t dev, const i2c_master_event_data_t *evt, void *arg)
+{
+    uint8_t axis = (uint8_t)(uintptr_t)arg;
+    uint16_t raw = (uint16_t)(((s_rx[axis][0] & 0x0f) << 8) | s_rx[axis][1]);
+    angle_sensor_complete(axis, (uint16_t)(raw << 4), evt->event == I2C_EVENT_DONE);
+    return false;
+}
+
+static esp_err_t as5600_init(void)
+{
+    for (int i = 0; i < ANGLE_AXES; i++)
+    {
+        if (s_bus_pins[i].sda == GPIO_NUM_NC || s_bus_pins[i].scl == GPIO_NUM_NC)
+        {
+            ESP_LOGW(TAG, "axis %d: no I2C pins assigned", i + 1);
+            continue;
+        }
+        // a transaction queue makes i2c_master_transmit_receive() return at once
+        i2c_master_bus_config_t bus_cfg = {
+            .i2c_port = s_bus_pins[i].port,
+            .sda_io_num = s_bus_pins[i].sda,
+            .scl_io_num = s_bus_pins[i].scl,
+            .clk_source = I2C_CLK_SRC_DEFAULT,
+            .glitch_ignore_cnt = 7,
+            .trans_queue_depth = 2,
+            .flags.enable_internal_pullup = true,
+        };
+        i2c_master_bus_handle_t bus;
+        ESP_ERROR_CHECK(i2c_new_master_bus(&bus_cfg, &bus));
+
+        i2c_device_config_t dev_cfg = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = AS5600_ADDR,
+            .scl_speed_hz = AS5600_SCL_HZ,
+        };
+        ESP_ERROR_CHECK(i2c_master_bus_add_device(bus, &dev_cfg, &s_dev[i]));
+
+        i2c_master_event_callbacks_t cbs = {
+            .on_trans_done = as5600_done,
+        };
+        ESP_ERROR_CHECK(i2c_master_register_event_callbacks(s_dev[i], &cbs, (void *)(uintptr_t)i));
+    }
+    return ESP_OK;
+}
+
+static bool as5600_start(uint8_t axis, int64_t t_us)
+{
+    if (s_dev[axis] == NULL) return false;
+    return i2c_master_transmit_receive(s_dev[axis], &s_reg, 1, s_rx[axis], sizeof(s_rx[axis]), -1) == ESP_OK;
+}
+
+const angle_backend_t angle_backend_as5600 = {
+    .name = "AS5600 (I2C)",
+    .init = as5600_init,
+    .start = as5600_start,
+    .poll = NULL,
+};
@@ -0,0 +1,76 @@
+#include "angle_sensor.h"
+#include <stdatomic.h>
+#include "esp_timer.h"
+
+// Simulated encoders: each axis turns at a constant speed, a read completes
+// `latency` after it was started when the backend is polled.
+
+typedef struct
+{
+    uint16_t angle0;
+    int32_t speed;          // angle units per second (= turns/s in Q16)
+    atomic_bool pending;
+    int64_t t_sample_us;
+} sim_axis_t;
+
+static sim_axis_t s_sim[ANGLE_AXES];
+static int64_t s_t0_us = 0;
+static uint32_t s_latency_us = 50;
+
+void angle_sensor_sim_set(uint8_t axis, uint16_t angle, int32_t turns_per_s_q16)
+{
+    if (axis >= ANGLE_AXES) return;
+    s_sim[axis].angle0 = angle;
+    s_sim[axis].speed = turns_per_s_q16;
+}
+
+void angle_sensor_sim_set_latency(uint32_t latency_us)
+{
+    s_latency_us = latency_us;
+}
+
+uint16_t angle_sensor_sim_angle(uint8_t axis, int64_t t_us)
+{
+    const sim_axis_t *sim = &s_sim[axis];
+    int64_t moved = (int64_t)sim->speed * (t_us - s_t0_us) / 1000000;
+    return (uint16_t)(sim->angle0 + moved);
+}
+
+static esp_err_t sim_init(void)
+{
+    s_t0_us = esp_timer_get_time();
+    for (int i = 0; i < ANGLE_AXES; i++)
+    {
+        atomic_init(&s_sim[i].pending, false);
+    }
+    return ESP_OK;
+}
+
+static bool sim_start(uint8_t axis, int64_t t_us)
+{
+    s_sim[axis].t_sample_us = t_us;
+    atomic_store(&s_sim[axis].pending, true);
+    return true;
+}
+
+static void sim_poll(void)
+{
+    int64_t now = esp_timer_get_time();
+    for (uint8_t i = 0; i < ANGLE_AXES; i++)
+    {
+        sim_axis_t *sim = &s_sim[i];
+        if (!atomic_load(&sim->pending) || now - sim->t_sample_us < (int64_t)s_latency_us) continue;
+        // the poll may run from a bus thread and from angle_sensor_trigger() at once
+        if (atomic_exchange(&sim->pending, false))
+        {
+            angle_sensor_complete(i, angle_sensor_sim_angle(i, sim->t_sample_us), true);
+        }
+    }
+}
+
+const angle_backend_t angle_backend_sim = {
+    .name = "simulated",
+    .init = sim_init,
+    .start = sim_start,
+    .poll = sim_poll,
+};
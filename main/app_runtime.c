@@ -0,0 +1,327 @@
+#include "app_runtime.h"
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "nvs_flash.h"
+
+#include "input_driver.h"
+#include "display_driver.h"
+#include "motor_control.h"
+#include "axis_homing.h"
+#include "control_core.h"
+#include "input_recorder.h"
+#include "angle_sensor.h"
+#include "stabilizer.h"
+#include "remote_ctrl.h"
+#include "remote_uart.h"
+#include "tune_cfg.h"
+#include "tune_console.h"
+#include "joy_cal.h"
+#include "power_mgr.h"
+#include "bench.h"
+#include "core_event.h"
+#include "journal.h"
+#include "motion_progs.h"
+#include "display_service.h"
+
+static const char *TAG = "APP";
+
+static adc_continuous_handle_t adc_handle = NULL;
+static uint32_t s_ticks = 0;
+static uint32_t s_idle_ticks = 0;
+static uint8_t s_pwm_pending = 0; // 电机运行中, 新的PWM频率等它停止后再设置
+
+#if ANGLE_SENSOR_ENABLE
+// 定时器只发起总线传输, 结果由驱动中断写入 angle_sensor 的双缓冲
+static void angle_timer_cb(void *arg)
+{
+    angle_sensor_trigger();
+}
+
+static void angle_sensor_start(void)
+{
+    if (angle_sensor_init(&ANGLE_SENSOR_BACKEND) != ESP_OK) return;
+    const esp_timer_create_args_t args = {
+        .callback = angle_timer_cb,
+        .name = "angle",
+    };
+    esp_timer_handle_t timer;
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, ANGLE_SENSOR_PERIOD_US));
+}
+#endif
+
+//================================================================================
+// 可调参数: 控制台发布新版本后, 在下一节拍开始时记录变化并应用
+//================================================================================
+// PWM 频率只能在电机停止时修改: 运行中的电机保留旧频率, 每个节拍重试到它停下为止
+static void pwm_follow(const tune_cfg_t *cfg)
+{
+    for (uint8_t m = 0; m < 3; m++)
+    {
+        if ((s_pwm_pending & (1u << m)) == 0) continue;
+        esp_err_t err = motor_set_pwm_freq(m, cfg->pwm_hz[m]);
+        if (err == ESP_ERR_INVALID_STATE) continue;
+        s_pwm_pending &= (uint8_t)~(1u << m);
+        if (err != ESP_OK) ESP_LOGW(TAG, "motor %d: PWM %" PRIu32 " Hz not applied (%s)", m, cfg->pwm_hz[m], esp_err_to_name(err));
+    }
+}
+
+static void tune_cfg_follow(void)
+{
+    static tune_cfg_t applied; // version 0: 第一个节拍按出厂值比较, 记录并应用从NVS加载的参数
+    const tune_cfg_t *cfg = tune_cfg_get();
+    if (cfg->version == applied.version)
+    {
+        if (s_pwm_pending) pwm_follow(cfg);
+        return;
+    }
+    if (applied.version == 0) applied = *tune_cfg_defaults();
+
+#if INPUT_RECORD_ENABLE
+    for (int i = 0; i < TUNE_PARAM_COUNT; i++)
+    {
+        uint32_t v = tune_cfg_value(cfg, (tune_param_t)i);
+        if (v != tune_cfg_value(&applied, (tune_param_t)i)) input_recorder_param((uint8_t)i, v);
+    }
+#endif
+    for (uint8_t m = 0; m < 3; m++)
+    {
+        if (cfg->pwm_hz[m] != applied.pwm_hz[m]) s_pwm_pending |= (uint8_t)(1u << m);
+    }
+    pwm_follow(cfg);
+    if (cfg->brightness != applied.brightness) display_service_set_brightness((uint8_t)cfg->brightness);
+    if (cfg->display_page_ms != applied.display_page_ms) display_service_set_rotation(cfg->display_page_ms);
+    if (memcmp(cfg->joy_dz_lo, applied.joy_dz_lo, sizeof(cfg->joy_dz_lo)) != 0 ||
+        memcmp(cfg->joy_dz_hi, applied.joy_dz_hi, sizeof(cfg->joy_dz_hi)) != 0)
+    {
+        joy_cal_set_deadzone(cfg->joy_dz_lo, cfg->joy_dz_hi);
+    }
+    control_core_set_cfg(cfg);
+    applied = *cfg;
+    ESP_LOGI(TAG, "parameters version %" PRIu32 " in effect", cfg->version);
+    for (uint8_t m = 0; m < 3; m++)
+    {
+        if (s_pwm_pending & (1u << m)) ESP_LOGW(TAG, "motor %d running: PWM %" PRIu32 " Hz applies when it stops", m, cfg->pwm_hz[m]);
+    }
+}
+
+//================================================================================
+// 控制核心的事件: 写入故障日志, 故障码闪烁显示 (失效保护解除时清除)
+//================================================================================
+static void runtime_core_event(core_event_t evt, uint32_t a, uint32_t b, void *arg)
+{
+#if JOURNAL_ENABLE
+    journal_log(JOURNAL_CORE, (uint8_t)evt, a, b, control_core_state());
+#endif
+    if (evt == CORE_EVT_FAILSAFE) display_service_post(DISPLAY_SRC_FAULT, a ? evt : 0);
+    else if (evt != CORE_EVT_STATE) display_service_post(DISPLAY_SRC_FAULT, evt);
+}
+
+//================================================================================
+// 故障日志: 限位器异常先进入内存, 空闲时写入flash
+//================================================================================
+#if JOURNAL_ENABLE
+
+// 同一对限位器同时触发 (接线或开关故障), 只在开始时记录一次
+static void journal_limits(const input_frame_t *frame)
+{
+    static uint8_t conflict_prev = 0;
+    uint8_t conflict = 0;
+    for (uint8_t p = 0; p < 3; p++)
+    {
+        if (input_limit_hit(frame, 1 + 2 * p) && input_limit_hit(frame, 2 + 2 * p)) conflict |= 1u << p;
+    }
+    for (uint8_t p = 0; p < 3; p++)
+    {
+        if ((conflict & ~conflict_prev) & (1u << p))
+        {
+            journal_log(JOURNAL_LIMIT, 1 + 2 * p, frame->gpio, control_core_state(), 0);
+        }
+    }
+    conflict_prev = conflict;
+}
+#endif
+
+//================================================================================
+// 控制节拍: 采样输入帧, 叠加校准/稳定/遥控, 记录后交给控制逻辑
+//================================================================================
+void app_runtime_tick(input_frame_t *frame)
+{
+    int64_t t_start = esp_timer_get_time();
+    input_sample(adc_handle, frame);
+    // 瞄准轴位置估计按1%量化放进帧: 随机模式从这里取起点, 回放时来自记录
+    for (int i = 0; i < INPUT_AIM_AXES; i++)
+    {
+        int32_t pos = motor_get_position(1 + i);
+        frame->aim_pos[i] = (pos == MOTOR_POS_UNKNOWN) ? -1 : (int8_t)(pos * 100 / MOTOR_POS_FULL);
+    }
+#if JOURNAL_ENABLE
+    journal_limits(frame);
+#endif
+    tune_cfg_follow(); // 参数变化记录在本帧之前
+    joy_cal_apply(&frame->joy_x, &frame->joy_y, frame->t_us, input_adc_fresh(frame)); // 摇杆原始值 -> 校准刻度
+#if STABILIZER_ENABLE
+    if (stabilizer_available()) frame->gpio |= INPUT_STAB_READY_BIT; // 进入稳定模式的条件也记录在帧里
+#endif
+#if REMOTE_ENABLE
+    remote_ctrl_apply(frame); // 遥控命令叠加到输入帧, 与本地输入走同一路径
+#endif
+#if INPUT_RECORD_ENABLE
+    input_recorder_frame(frame);
+#endif
+    control_core_step(frame);
+    display_service_poll(frame->t_us); // 电机命令之后; 最多每 DISPLAY_REFRESH_MS 写一次数码管
+    bench_loop_time(t_start, esp_timer_get_time());
+
+    s_ticks++;
+#if ANGLE_SENSOR_ENABLE
+    if (s_ticks % ANGLE_STATS_TICKS == 0) angle_sensor_log_stats();
+#endif
+#if STABILIZER_ENABLE
+    if (s_ticks % STAB_STATS_TICKS == 0) stabilizer_log_stats();
+#endif
+#if CONFIG_APP_BENCH_REPORT_S
+    if (s_ticks % BENCH_REPORT_TICKS == 0) bench_report(false);
+#endif
+}
+
+//================================================================================
+// 空闲: 无人操作且核心没有进行中的动作时写入故障日志 (flash 操作不会延误运动),
+// 再停用ADC和PWM定时器, 睡到唤醒引脚或下一次轮询
+//================================================================================
+static bool runtime_idle(const input_frame_t *frame)
+{
+    if (control_core_state() != STATE_IDLE || input_failsafe(frame) || joy_cal_active()) return false;
+    if (!control_core_quiescent()) return false; // 随机模式和动作程序在 STATE_IDLE 下运行
+    for (uint8_t k = 1; k <= 4; k++)
+    {
+        if (input_key_down(frame, k)) return false;
+    }
+#if REMOTE_ENABLE
+    if (remote_ctrl_link() != REMOTE_LINK_NONE) return false;
+#endif
+    return true;
+}
+
+#if POWER_MGR_ENABLE
+static bool power_idle_sleep(void)
+{
+    if (motor_suspend(true) != ESP_OK) return false;
+    ESP_ERROR_CHECK(adc_continuous_stop(adc_handle));
+    power_mgr_sleep();
+    power_mgr_wait(POWER_POLL_MS); // 引脚唤醒时记录唤醒时刻, 到第一条电机驱动命令的延迟见 lat_hist
+    power_mgr_wake();
+    ESP_ERROR_CHECK(adc_continuous_start(adc_handle));
+    ESP_ERROR_CHECK(motor_suspend(false));
+    bench_resync(); // 睡眠不计入节拍抖动
+    return true;
+}
+#endif
+
+bool app_runtime_idle(const input_frame_t *frame)
+{
+    // 醒来后的第一帧还没有新的ADC数据, 等到有新数据的空闲帧再睡
+    if (!runtime_idle(frame)) s_idle_ticks = 0;
+    else if (input_adc_fresh(frame)) s_idle_ticks++;
+    if (s_idle_ticks < POWER_IDLE_ENTER_TICKS || !input_adc_fresh(frame)) return false;
+#if JOURNAL_ENABLE
+    journal_flush(); // 没有待写记录时不访问flash
+#endif
+#if POWER_MGR_ENABLE
+    return power_idle_sleep();
+#else
+    return false;
+#endif
+}
+
+void app_runtime_loop_init(const char *name)
+{
+    bench_init(name, CONTROL_PERIOD_MS * 1000);
+#if POWER_MGR_ENABLE
+    power_mgr_init();
+#endif
+}
+
+//================================================================================
+// 上电初始化
+//================================================================================
+void app_runtime_init(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
+    {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+#if JOURNAL_ENABLE
+    journal_init(); // 记录复位原因并写入上次会话遗留的记录, 控制循环启动前写flash
+#endif
+    core_event_set_hook(runtime_core_event, NULL);
+    tune_cfg_t cfg;
+    if (tune_cfg_load(&cfg) == ESP_OK) tune_cfg_publish(&cfg, esp_timer_get_time()); // 第一个节拍开始应用
+    motion_prog_load(); // 用户动作程序只在开机时校验载入, 运行中不变
+    joy_cal_t cal;
+    joy_cal_init((joy_cal_load(&cal) == ESP_OK) ? &cal : NULL); // 开机静止测量中心和噪声
+
+    ESP_LOGI(TAG, "init hardware drivers...");
+    limitStop_IO_init();
+    key_init();
+    display_init();
+    display_service_init(); // 此后只有显示服务访问数码管
+    display_service_set_brightness((uint8_t)tune_cfg_defaults()->brightness); // 与出厂值不同的参数在第一个节拍应用
+    motor_init(); // 电机ID范围为0，1，2 ---> 对应电机1，2，3
+
+    // 发射电机到限位必须立即刹车; 瞄准电机回中时斜坡停止, 换向前滑行30ms
+    const motor_brake_config_t launch_brake = {.mode = MOTOR_STOP_BRAKE, .ramp_ms = 0, .reverse_dead_ms = 30};
+    const motor_brake_config_t aim_brake = {.mode = MOTOR_STOP_RAMP, .ramp_ms = 80, .reverse_dead_ms = 30};
+    motor_set_brake_config(0, &launch_brake);
+    motor_set_brake_config(1, &aim_brake);
+    motor_set_brake_config(2, &aim_brake);
+    // 瞄准电机低速时用占空比抖动获得更细的速度分辨率
+    motor_set_dither(1, true);
+    motor_set_dither(2, true);
+    input_edges_init();
+#if ANGLE_SENSOR_ENABLE
+    angle_sensor_start();
+#endif
+#if STABILIZER_ENABLE
+    stabilizer_start(&STABILIZER_IMU); // 上电后平台静止约0.5秒以估计陀螺零偏
+#endif
+#if REMOTE_ENABLE
+    remote_ctrl_init();
+    remote_uart_start();
+#endif
+#if INPUT_RECORD_ENABLE
+    input_recorder_init();
+#endif
+
+    ESP_LOGI(TAG, "init ADC...");
+    continuous_adc_init(adc_channel, 4, &adc_handle);
+    adc_continuous_start(adc_handle);
+
+    ESP_LOGI(TAG, "init control logic...");
+    control_core_init();
+    // 随机模式种子每次上电不同, 打印并记录下来以便复现同一段会话
+    uint32_t seed = esp_random();
+    control_core_set_seed(seed);
+    ESP_LOGI(TAG, "random mode seed 0x%08" PRIx32, seed);
+#if INPUT_RECORD_ENABLE
+    // 记录上电时的行程时间, 回放时按相同状态开始回零
+    uint32_t travel_us[4];
+    uint32_t travel_duty[2] = {axis_homing_get_travel_duty(0), axis_homing_get_travel_duty(1)};
+    axis_homing_get_travel(0, &travel_us[0], &travel_us[1]);
+    axis_homing_get_travel(1, &travel_us[2], &travel_us[3]);
+    input_recorder_boot(travel_us, travel_duty);
+    input_recorder_seed(seed);
+#endif
+#if TUNE_CONSOLE_ENABLE
+    tune_console_start();
+#endif
+}
@@ -0,0 +1,41 @@
+#ifndef _APP_RUNTIME_H_
+#define _APP_RUNTIME_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "input_frame.h"
+
+/*
+ * 两种运行时共用的部分: 上电初始化, 每个控制节拍的 采样 -> 参数/校准 -> 叠加 -> 记录
+ * -> 控制核心, 周期统计和空闲低功耗。运行时只决定节拍怎样调度 (menuconfig 选择):
+ *   main_os.c  CONFIG_APP_RUNTIME_RTOS       独立的控制任务, vTaskDelayUntil 按系统节拍唤醒
+ *   main.c     CONFIG_APP_RUNTIME_SUPERLOOP  app_main 中单一循环, esp_timer 单次定时器按微秒唤醒
+ * 两者运行同一套基准统计 (bench.h), 可在同一块板上对比延迟、抖动、CPU和内存。
+ */
+
+#define CONTROL_PERIOD_MS       20   // 控制节拍: 每20ms采样一次输入并运行控制逻辑
+#define CONTROL_TASK_PRIO       6    // 运行控制节拍的任务 (超级循环时为 app_main 任务)
+#define INPUT_RECORD_ENABLE     0    // 记录输入帧和电机命令到 reclog 分区; 擦除扇区会卡住控制节拍约40ms, 只在采集回放数据时打开
+#define ANGLE_SENSOR_ENABLE     0    // 瞄准轴角度传感器 (板上尚未安装)
+#define ANGLE_SENSOR_BACKEND    angle_backend_as5600
+#define ANGLE_SENSOR_PERIOD_US  1000 // 角度采样周期
+#define ANGLE_STATS_TICKS       500  // 每10秒打印一次角度采样统计
+#define STABILIZER_ENABLE       0    // 瞄准平台IMU稳定环 (板上尚未安装IMU)
+#define STABILIZER_IMU          imu_backend_mpu6050
+#define STAB_STATS_TICKS        500  // 每10秒打印一次稳定环时序统计
+#define REMOTE_ENABLE           0    // 串口遥控命令 (遥控串口引脚尚未分配)
+#define TUNE_CONSOLE_ENABLE     1    // 串口控制台: 运行时查看/修改参数 (见 main/tune_console.h)
+#define JOURNAL_ENABLE          1    // 状态变化/故障/复位原因写入 journal 分区, 空闲时批量写flash (见 main/journal.h)
+#define POWER_MGR_ENABLE        1    // 空闲时降频并 light sleep (需 CONFIG_PM_ENABLE), 按键/限位器唤醒
+#define POWER_IDLE_ENTER_TICKS  150  // 连续空闲3秒后写日志并进入低功耗
+#define POWER_POLL_MS           200  // 低功耗时每200ms醒来检查一次摇杆
+#define BENCH_REPORT_TICKS      (CONFIG_APP_BENCH_REPORT_S * 1000 / CONTROL_PERIOD_MS) // 0 = 不打印
+
+void app_runtime_init(void);                 // 上电初始化, 在 app_main 中调用
+void app_runtime_loop_init(const char *name); // 在运行控制节拍的任务中调用一次
+void app_runtime_tick(input_frame_t *frame);  // 一个控制节拍
+bool app_runtime_idle(const input_frame_t *frame); // true: 刚睡醒, 运行时应重新对齐节拍
+
+#endif // !_APP_RUNTIME_H_
@@ -0,0 +1,59 @@
+#include "attitude.h"
+#include <string.h>
+#include "fixq.h"
+
+#define MDEG_HALF_TURN_Q8   (180000 * 256)
+
+void attitude_init(attitude_t *att)
+{
+    memset(att, 0, sizeof(*att));
+}
+
+bool attitude_ready(const attitude_t *att)
+{
+    return att->bias_n >= ATTITUDE_BIAS_SAMPLES;
+}
+
+// gyro counts (1/256) to 1/256 mdeg turned during one sample period
+static int32_t gyro_step_q8(int32_t counts_q8)
+{
+    return (int32_t)((int64_t)counts_q8 * 10000 / ((int64_t)IMU_GYRO_LSB_PER_DPS_X10 * IMU_RATE_HZ));
+}
+
+void attitude_update(attitude_t *att, const imu_sample_t *s)
+{
+    int32_t tilt_q8 = fixq_atan2_mdeg(-s->accel[0], s->accel[2]) * 256;
+
+    if (!attitude_ready(att))
+    {
+        for (int i = 0; i < 3; i++) att->bias_sum[i] += s->gyro[i];
+        att->bias_n++;
+        att->pitch_q8 = tilt_q8;
+        if (attitude_ready(att))
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                att->bias_q8[i] = (int32_t)((int64_t)att->bias_sum[i] * 256 / att->bias_n);
+            }
+        }
+        att->pitch_mdeg = att->pitch_q8 / 256;
+        return;
+    }
+
+    int32_t counts_q8[3];
+    for (int i = 0; i < 3; i++)
+    {
+        counts_q8[i] = (int32_t)s->gyro[i] * 256 - att->bias_q8[i];
+        att->rate_mdps[i] = (int32_t)((int64_t)counts_q8[i] * 10000 / (IMU_GYRO_LSB_PER_DPS_X10 * 256));
+    }
+
+    att->pitch_q8 += gyro_step_q8(counts_q8[1]);
+    att->pitch_q8 += (tilt_q8 - att->pitch_q8) >> ATTITUDE_ACCEL_SHIFT;
+
+    att->yaw_q8 += gyro_step_q8(counts_q8[2]);
+    if (att->yaw_q8 > MDEG_HALF_TURN_Q8) att->yaw_q8 -= 2 * MDEG_HALF_TURN_Q8;
+    if (att->yaw_q8 < -MDEG_HALF_TURN_Q8) att->yaw_q8 += 2 * MDEG_HALF_TURN_Q8;
+
+    att->pitch_mdeg = att->pitch_q8 / 256;
+    att->yaw_mdeg = att->yaw_q8 / 256;
+}
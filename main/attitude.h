@@ -0,0 +1,37 @@
+#ifndef _ATTITUDE_H_
+#define _ATTITUDE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "imu.h"
+
+/*
+ * Fixed-point complementary filter for the aim platform, one update per IMU sample.
+ * Pitch integrates the gyro and is pulled towards the accelerometer tilt with a
+ * time constant of 2^ATTITUDE_ACCEL_SHIFT samples; yaw has no absolute reference
+ * and is the integrated gyro only, so it drifts with the residual gyro bias. The
+ * bias is averaged over the first ATTITUDE_BIAS_SAMPLES, with the platform at rest.
+ */
+
+#define ATTITUDE_BIAS_SAMPLES   500     // 0.5 s at IMU_RATE_HZ
+#define ATTITUDE_ACCEL_SHIFT    9       // ~0.5 s at IMU_RATE_HZ
+
+typedef struct
+{
+    int32_t yaw_mdeg;       // -180000..180000
+    int32_t pitch_mdeg;
+    int32_t rate_mdps[3];   // bias corrected body rates
+
+    int32_t yaw_q8;         // state in 1/256 mdeg
+    int32_t pitch_q8;
+    int32_t bias_q8[3];     // gyro bias in 1/256 counts
+    int32_t bias_sum[3];
+    uint16_t bias_n;
+} attitude_t;
+
+void attitude_init(attitude_t *att);
+bool attitude_ready(const attitude_t *att); // bias estimated, outputs valid
+void attitude_update(attitude_t *att, const imu_sample_t *s);
+
+#endif // !_ATTITUDE_H_
@@ -0,0 +1,237 @@
+#include "axis_homing.h"
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "motor_control.h"
+#include "core_local.h"
+#include "core_event.h"
+
+static const char *TAG = "AXIS_HOMING";
+
+#define AXIS_NVS_NAMESPACE      "axis"
+#define AXIS_POLL_MS            0       // re-check on every control tick
+#define AXIS_SETTLE_MS          100
+#define AXIS_TIMEOUT_MS         10000   // one end-to-end move must finish within this
+#define AXIS_TRAVEL_MIN_US      50000   // shorter spans mean a switch is stuck
+#define AXIS_DUTY_LEGACY        (90 * MOTOR_DUTY_SCALE / 100) // times saved without a duty were measured at the factory duty_pct
+
+typedef struct
+{
+    uint8_t motor;          // motor index
+    uint8_t limit_fwd;      // limit switch at the forward end
+    uint8_t limit_rev;      // limit switch at the reverse end
+    const char *key_fwd;    // NVS keys for the learned travel times
+    const char *key_rev;
+    const char *key_duty;   // NVS key for the duty the travel was measured at
+    uint32_t travel_fwd_us;
+    uint32_t travel_rev_us;
+    uint32_t travel_duty;   // MOTOR_DUTY_SCALE units
+    bool full;              // measure travel, not just find the reverse end
+    bool busy;
+    bool timed_out;
+    int64_t t_start;
+    coop_job_t job;
+} axis_t;
+
+static CORE_LOCAL axis_t s_axes[AXIS_COUNT] = {
+    {.motor = 1, .limit_fwd = 3, .limit_rev = 4, .key_fwd = "m1_fwd", .key_rev = "m1_rev", .key_duty = "m1_duty"},
+    {.motor = 2, .limit_fwd = 5, .limit_rev = 6, .key_fwd = "m2_fwd", .key_rev = "m2_rev", .key_duty = "m2_duty"},
+};
+static CORE_LOCAL uint32_t s_rehome_event = 0;
+static CORE_LOCAL const input_frame_t *s_in = NULL;
+
+static void axis_load(axis_t *axis)
+{
+    nvs_handle_t nvs;
+    axis->travel_fwd_us = 0;
+    axis->travel_rev_us = 0;
+    axis->travel_duty = AXIS_DUTY_LEGACY;
+    if (nvs_open(AXIS_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) return;
+
+    if ((nvs_get_u32(nvs, axis->key_fwd, &axis->travel_fwd_us) != ESP_OK) ||
+        (nvs_get_u32(nvs, axis->key_rev, &axis->travel_rev_us) != ESP_OK))
+    {
+        axis->travel_fwd_us = 0;
+        axis->travel_rev_us = 0;
+    }
+    if ((nvs_get_u32(nvs, axis->key_duty, &axis->travel_duty) != ESP_OK) ||
+        (axis->travel_duty == 0) || (axis->travel_duty > MOTOR_DUTY_SCALE))
+    {
+        axis->travel_duty = AXIS_DUTY_LEGACY;
+    }
+    nvs_close(nvs);
+}
+
+static void axis_save(const axis_t *axis)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(AXIS_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK)
+    {
+        nvs_set_u32(nvs, axis->key_fwd, axis->travel_fwd_us);
+        nvs_set_u32(nvs, axis->key_rev, axis->travel_rev_us);
+        nvs_set_u32(nvs, axis->key_duty, axis->travel_duty);
+        err = nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to save travel of motor %d: %s", axis->motor, esp_err_to_name(err));
+    }
+}
+
+static bool axis_at(uint8_t limit)
+{
+    return input_limit_hit(s_in, limit);
+}
+
+// True once the switch trips or the move has run out of time (sets timed_out).
+static bool axis_reached(axis_t *axis, uint8_t limit, int64_t now)
+{
+    if (axis_at(limit)) return true;
+    axis->timed_out = (now - axis->t_start) > AXIS_TIMEOUT_MS * 1000LL;
+    return axis->timed_out;
+}
+
+static coop_status_t axis_job(coop_job_t *job, int64_t now)
+{
+    axis_t *axis = (axis_t *)job->ctx;
+
+    COOP_BEGIN(job);
+    while (1)
+    {
+        axis->busy = true;
+        axis->timed_out = false;
+        motor_track_sync(axis->motor, MOTOR_POS_UNKNOWN); // no soft limits while homing
+        ESP_LOGI(TAG, "Homing motor %d (%s)", axis->motor, axis->full ? "measure travel" : "find reverse end");
+
+        // 1. drive to the reverse end, unless already there
+        axis->t_start = now;
+        if (!axis_at(axis->limit_rev))
+        {
+            motor_start_reverse(axis->motor);
+            COOP_WAIT_UNTIL(job, now, axis_reached(axis, axis->limit_rev, now), AXIS_POLL_MS);
+            motor_stop_mode(axis->motor, MOTOR_STOP_BRAKE);
+            if (axis->timed_out) goto failed;
+        }
+
+        if (axis->full)
+        {
+            // 2. measure reverse -> forward, both legs at the duty saved with the times
+            COOP_DELAY_MS(job, now, AXIS_SETTLE_MS);
+            if (axis_at(axis->limit_fwd)) goto stuck;
+            axis->travel_duty = motor_get_default_duty();
+            axis->t_start = now;
+            motor_start_duty(axis->motor, 1, axis->travel_duty);
+            COOP_WAIT_UNTIL(job, now, axis_reached(axis, axis->limit_fwd, now), AXIS_POLL_MS);
+            motor_stop_mode(axis->motor, MOTOR_STOP_BRAKE);
+            if (axis->timed_out) goto failed;
+            axis->travel_fwd_us = (uint32_t)(now - axis->t_start);
+
+            // 3. measure forward -> reverse
+            COOP_DELAY_MS(job, now, AXIS_SETTLE_MS);
+            if (axis_at(axis->limit_rev)) goto stuck;
+            axis->t_start = now;
+            motor_start_duty(axis->motor, -1, axis->travel_duty);
+            COOP_WAIT_UNTIL(job, now, axis_reached(axis, axis->limit_rev, now), AXIS_POLL_MS);
+            motor_stop_mode(axis->motor, MOTOR_STOP_BRAKE);
+            if (axis->timed_out) goto failed;
+            axis->travel_rev_us = (uint32_t)(now - axis->t_start);
+
+            if ((axis->travel_fwd_us < AXIS_TRAVEL_MIN_US) || (axis->travel_rev_us < AXIS_TRAVEL_MIN_US))
+            {
+                ESP_LOGE(TAG, "Motor %d travel too short, check limit switches", axis->motor);
+                core_event_emit(CORE_EVT_HOME_SHORT, axis->motor,
+                                (axis->travel_fwd_us < axis->travel_rev_us) ? axis->travel_fwd_us : axis->travel_rev_us);
+                axis->travel_fwd_us = 0;
+                axis->travel_rev_us = 0;
+                goto done;
+            }
+            axis_save(axis);
+            axis->full = false;
+        }
+
+        ESP_LOGI(TAG, "Motor %d homed, travel fwd %" PRIu32 " us, rev %" PRIu32 " us at duty %" PRIu32,
+                 axis->motor, axis->travel_fwd_us, axis->travel_rev_us, axis->travel_duty);
+        motor_set_travel(axis->motor, axis->travel_fwd_us, axis->travel_rev_us, axis->travel_duty);
+        motor_track_sync(axis->motor, 0);
+        goto done;
+
+    stuck:
+        ESP_LOGE(TAG, "Motor %d has both limit switches asserted", axis->motor);
+        core_event_emit(CORE_EVT_HOME_STUCK, axis->motor, 0);
+        axis->travel_fwd_us = 0;
+        axis->travel_rev_us = 0;
+        motor_set_travel(axis->motor, 0, 0, 0);
+        goto done;
+
+    failed:
+        ESP_LOGE(TAG, "Motor %d homing timed out, soft limits disabled", axis->motor);
+        core_event_emit(CORE_EVT_HOME_TIMEOUT, axis->motor, (uint32_t)((now - axis->t_start) / 1000));
+        motor_set_travel(axis->motor, 0, 0, 0);
+
+    done:
+        axis->busy = false;
+        COOP_WAIT_EVENT(job, s_rehome_event);
+        axis->full = true;
+    }
+    COOP_END(job);
+}
+
+void axis_homing_init(coop_sched_t *sched, const input_frame_t *in, uint32_t rehome_event)
+{
+    s_rehome_event = rehome_event;
+    s_in = in;
+    for (int i = 0; i < AXIS_COUNT; i++)
+    {
+        axis_t *axis = &s_axes[i];
+        axis_load(axis);
+        axis->timed_out = false;
+        axis->full = (axis->travel_fwd_us == 0) || (axis->travel_rev_us == 0);
+        axis->busy = true;
+        coop_sched_add(sched, &axis->job, axis->motor == 1 ? "home_m1" : "home_m2", axis_job, axis, rehome_event);
+    }
+}
+
+bool axis_homing_busy(void)
+{
+    for (int i = 0; i < AXIS_COUNT; i++)
+    {
+        if (s_axes[i].busy) return true;
+    }
+    return false;
+}
+
+// Re-anchor the position estimate whenever a homed axis sits on a limit switch.
+void axis_homing_poll(void)
+{
+    for (int i = 0; i < AXIS_COUNT; i++)
+    {
+        const axis_t *axis = &s_axes[i];
+        if (axis->busy || (axis->travel_fwd_us == 0)) continue;
+
+        if (axis_at(axis->limit_rev))
+        {
+            motor_track_sync(axis->motor, 0);
+        }
+        else if (axis_at(axis->limit_fwd))
+        {
+            motor_track_sync(axis->motor, MOTOR_POS_FULL);
+        }
+    }
+}
+
+void axis_homing_get_travel(uint8_t axis, uint32_t *travel_fwd_us, uint32_t *travel_rev_us)
+{
+    if (axis >= AXIS_COUNT) return;
+    *travel_fwd_us = s_axes[axis].travel_fwd_us;
+    *travel_rev_us = s_axes[axis].travel_rev_us;
+}
+
+// Duty the travel times were measured at; position estimates scale by duty / travel_duty.
+uint32_t axis_homing_get_travel_duty(uint8_t axis)
+{
+    if (axis >= AXIS_COUNT) return 0;
+    return s_axes[axis].travel_duty;
+}
@@ -0,0 +1,25 @@
+#ifndef _AXIS_HOMING_H_
+#define _AXIS_HOMING_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "coop_sched.h"
+#include "input_frame.h"
+
+/*
+ * Homing for the aim axes (motors 1 and 2). At startup each axis is driven to its
+ * reverse limit switch; if no travel time is stored yet (or a re-home event is
+ * posted) it is also driven across to the forward switch and back, and the measured
+ * travel times are saved to NVS together with the duty they were measured at. The
+ * motor layer then tracks the estimated position and applies the soft limits.
+ */
+
+#define AXIS_COUNT  2
+
+void axis_homing_init(coop_sched_t *sched, const input_frame_t *in, uint32_t rehome_event);
+bool axis_homing_busy(void);
+void axis_homing_poll(void);
+void axis_homing_get_travel(uint8_t axis, uint32_t *travel_fwd_us, uint32_t *travel_rev_us);
+uint32_t axis_homing_get_travel_duty(uint8_t axis);
+
+#endif // !_AXIS_HOMING_H_
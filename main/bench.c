@@ -0,0 +1,169 @@
+#include "bench.h"
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "lat_hist.h"
+
+static const char *TAG = "BENCH";
+
+#define BENCH_MAX_TASKS     24
+
+typedef struct
+{
+    uint32_t ticks;
+    uint32_t busy_max_us;
+    uint64_t busy_sum_us;
+    uint32_t period_min_us;
+    uint32_t period_max_us;
+    uint64_t dev_sq_sum;        // squared deviation from the nominal period (us^2)
+    uint32_t periods;
+    int64_t last_start_us;
+    int64_t since_us;
+} loop_stats_t;
+
+static const char *s_runtime = "?";
+static uint32_t s_period_us = 0;
+static TaskHandle_t s_loop_task = NULL;
+static loop_stats_t s_loop = {.period_min_us = UINT32_MAX};
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+static uint64_t s_idle_prev = 0;
+static uint64_t s_total_prev = 0;
+#endif
+
+void bench_init(const char *runtime, uint32_t period_us)
+{
+    s_runtime = runtime;
+    s_period_us = period_us;
+    s_loop_task = xTaskGetCurrentTaskHandle();
+    s_loop.since_us = esp_timer_get_time();
+}
+
+void bench_loop_time(int64_t start_us, int64_t end_us)
+{
+    uint32_t busy = (uint32_t)(end_us - start_us);
+    taskENTER_CRITICAL(&s_lock);
+    if (s_loop.last_start_us != 0)
+    {
+        uint32_t period = (uint32_t)(start_us - s_loop.last_start_us);
+        int32_t dev = (int32_t)(period - s_period_us);
+        if (period < s_loop.period_min_us) s_loop.period_min_us = period;
+        if (period > s_loop.period_max_us) s_loop.period_max_us = period;
+        s_loop.dev_sq_sum += (uint64_t)((int64_t)dev * dev);
+        s_loop.periods++;
+    }
+    s_loop.last_start_us = start_us;
+    s_loop.ticks++;
+    s_loop.busy_sum_us += busy;
+    if (busy > s_loop.busy_max_us) s_loop.busy_max_us = busy;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void bench_resync(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_loop.last_start_us = 0;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0, bit = 1ull << 62;
+    while (bit > v) bit >>= 2;
+    while (bit != 0)
+    {
+        if (v >= r + bit)
+        {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        }
+        else
+        {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+// Load over all cores since the previous call: 1 - idle task run time / elapsed run time.
+static int32_t cpu_permille(bool reset)
+{
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    static TaskStatus_t tasks[BENCH_MAX_TASKS];
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t n = uxTaskGetSystemState(tasks, BENCH_MAX_TASKS, &total);
+    if (n == 0) return -1;
+    uint64_t idle = 0;
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        if (strncmp(tasks[i].pcTaskName, "IDLE", 4) == 0) idle += tasks[i].ulRunTimeCounter;
+    }
+    uint64_t d_total = ((uint64_t)total - s_total_prev) * portNUM_PROCESSORS;
+    uint64_t d_idle = idle - s_idle_prev;
+    if (reset)
+    {
+        s_total_prev = total;
+        s_idle_prev = idle;
+    }
+    if (d_total == 0 || d_idle > d_total) return 0;
+    return (int32_t)(1000 - d_idle * 1000 / d_total);
+#else
+    return -1;
+#endif
+}
+
+void bench_get(bench_result_t *out, bool reset)
+{
+    int64_t now = esp_timer_get_time();
+    taskENTER_CRITICAL(&s_lock);
+    loop_stats_t loop = s_loop;
+    if (reset)
+    {
+        memset(&s_loop, 0, sizeof(s_loop));
+        s_loop.period_min_us = UINT32_MAX;
+        s_loop.since_us = now;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    memset(out, 0, sizeof(*out));
+    out->ticks = loop.ticks;
+    if (loop.ticks)
+    {
+        out->busy_avg_us = (uint32_t)(loop.busy_sum_us / loop.ticks);
+        out->busy_max_us = loop.busy_max_us;
+    }
+    if (loop.periods)
+    {
+        out->period_min_us = loop.period_min_us;
+        out->period_max_us = loop.period_max_us;
+        out->jitter_rms_us = isqrt64(loop.dev_sq_sum / loop.periods);
+    }
+    int64_t elapsed = now - loop.since_us;
+    out->loop_permille = elapsed > 0 ? (uint32_t)(loop.busy_sum_us * 1000 / (uint64_t)elapsed) : 0;
+    out->cpu_permille = cpu_permille(reset);
+    out->heap_free = esp_get_free_heap_size();
+    out->heap_min_free = esp_get_minimum_free_heap_size();
+    out->stack_free = s_loop_task ? (uint32_t)uxTaskGetStackHighWaterMark(s_loop_task) * sizeof(StackType_t) : 0;
+}
+
+void bench_report(bool reset)
+{
+    bench_result_t r;
+    bench_get(&r, reset);
+    ESP_LOGI(TAG, "runtime %s, %" PRIu32 " ticks of %" PRIu32 " us", s_runtime, r.ticks, s_period_us);
+    ESP_LOGI(TAG, "jitter: period %" PRIu32 "..%" PRIu32 " us, rms %" PRIu32 " us", r.period_min_us, r.period_max_us,
+             r.jitter_rms_us);
+    ESP_LOGI(TAG, "cpu: tick busy avg %" PRIu32 " / max %" PRIu32 " us, loop %" PRIu32 ".%" PRIu32 "%%, total %s%" PRId32 ".%" PRId32 "%%",
+             r.busy_avg_us, r.busy_max_us, r.loop_permille / 10, r.loop_permille % 10, r.cpu_permille < 0 ? "n/a " : "",
+             r.cpu_permille < 0 ? 0 : r.cpu_permille / 10, r.cpu_permille < 0 ? 0 : r.cpu_permille % 10);
+    ESP_LOGI(TAG, "ram: heap free %" PRIu32 " (min %" PRIu32 "), loop stack free %" PRIu32 " bytes", r.heap_free,
+             r.heap_min_free, r.stack_free);
+    lat_hist_log(false);
+    if (reset) lat_hist_reset();
+}
@@ -0,0 +1,44 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Runtime benchmark, identical for the superloop and the RTOS runtime so the two
+ * can be compared on the same board:
+ *
+ *   latency   input-to-actuation histograms (lat_hist.h)
+ *   jitter    control tick period against the nominal period: min, max, RMS
+ *   CPU       control tick busy time, and total load from the idle tasks' run time
+ *             (needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+ *   RAM       free heap now and lowest ever, stack headroom of the control loop
+ *
+ * The runtime reports each tick with bench_loop_time() from the control loop and
+ * calls bench_resync() after a pause it chose (light sleep), which would otherwise
+ * count as jitter.
+ */
+
+typedef struct
+{
+    uint32_t ticks;
+    uint32_t busy_avg_us;
+    uint32_t busy_max_us;
+    uint32_t period_min_us;
+    uint32_t period_max_us;
+    uint32_t jitter_rms_us;     // deviation from the nominal period
+    uint32_t loop_permille;     // busy time / elapsed time
+    int32_t cpu_permille;       // all tasks, -1 without run-time stats
+    uint32_t heap_free;
+    uint32_t heap_min_free;
+    uint32_t stack_free;        // control loop task, bytes
+} bench_result_t;
+
+void bench_init(const char *runtime, uint32_t period_us); // from the control loop task
+void bench_loop_time(int64_t start_us, int64_t end_us);   // one tick: sample .. step done
+void bench_resync(void);
+void bench_get(bench_result_t *out, bool reset);
+void bench_report(bool reset);   // logs the result and the latency summary
+
+#endif // !_BENCH_H_
@@ -0,0 +1,700 @@
+#include "control_core.h"
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+
+#include "display_service.h"
+#include "motor_control.h"
+#include "coop_sched.h"
+#include "axis_homing.h"
+#include "launch_ctrl.h"
+#include "core_local.h"
+#include "fixq.h"
+#include "random_pattern.h"
+#include "stabilizer.h"
+#include "lat_hist.h"
+#include "tune_cfg.h"
+#include "core_event.h"
+#include "motion.h"
+#include "motion_progs.h"
+
+static const char *TAG = "CONTROL";
+
+// 调度器事件
+#define EVT_LAUNCH      (1u << 0) // 触发发射流程
+#define EVT_RANDOM      (1u << 1) // 触发随机模式
+#define EVT_DISPLAY     (1u << 2) // 显示内容有更新
+#define EVT_REHOME      (1u << 3) // 重新回零并测量行程
+#define EVT_TICK        (1u << 4) // 新的输入帧
+#define EVT_PROGRAM     (1u << 5) // 运行按键3的动作程序
+
+#define LIMIT_POLL_MS           0    // 每个控制节拍检查一次限位器
+#define RANDOM_TRAVEL_DEFAULT_MS 1500 // 尚未测量行程时的估计值
+
+// 摇杆死区和占空比范围见 tune_cfg.h, 可运行时修改
+#define JOYSTICK_ADC_MAX            4095
+#define KEY_BITS                    (INPUT_KEY_BIT(1) | INPUT_KEY_BIT(2) | INPUT_KEY_BIT(3) | INPUT_KEY_BIT(4))
+#define POT_FILTER_SHIFT            2    // 电位器低通滤波 1/4
+
+static CORE_LOCAL system_state_t s_state = STATE_HOMING; // 上电先回零
+static CORE_LOCAL input_frame_t s_in = INPUT_FRAME_INIT; // 当前节拍的输入
+static CORE_LOCAL coop_sched_t s_sched;
+static CORE_LOCAL coop_job_t s_control_job, s_launch_job, s_random_job, s_display_job, s_program_job;
+
+static CORE_LOCAL fixq_joy_t s_joy_x, s_joy_y;    // 摇杆偏移 -> 占空比
+static CORE_LOCAL fixq_lpf_t s_pot_lpf;
+static CORE_LOCAL bool s_stab_key_prev = false; // 按键4上一节拍状态, 按下沿切换稳定模式
+static CORE_LOCAL bool s_failsafe = false;      // 遥控链路丢失, 所有电机已刹车
+static CORE_LOCAL tune_cfg_t s_cfg;              // 可调参数的副本, 只在节拍边界更新
+static CORE_LOCAL uint16_t s_key_raw, s_key_stable; // 按键消抖: 原始电平和已确认电平
+static CORE_LOCAL int64_t s_key_raw_us;
+
+// 随机模式: 每次动作保持0.5-1秒, 三档速度, 每轴1/3概率停止
+static const random_pattern_cfg_t s_random_cfg = {
+    .dwell_min_ms = 500,
+    .dwell_max_ms = 1000,
+    .dwell = RANDOM_DWELL_UNIFORM,
+    .stop_percent = 33,
+    .num_speeds = 3,
+    .speeds = {4000, 6500, 9000},
+};
+
+static CORE_LOCAL random_pcg_t s_session_rng;    // 每次随机模式的种子由它产生
+static CORE_LOCAL random_pattern_t s_pattern;    // 当前随机模式的动作表
+static CORE_LOCAL uint8_t s_random_step = 0;     // 动作表中当前步
+static CORE_LOCAL int64_t s_random_start_us = 0; // 随机模式开始时间
+static CORE_LOCAL int64_t s_random_hold_us = 0;  // 当前随机动作保持到此时间
+static CORE_LOCAL int8_t s_random_dir[2];        // 电机2/3当前随机动作方向
+static CORE_LOCAL uint16_t s_random_duty[2];     // 电机2/3当前随机动作占空比
+static CORE_LOCAL int64_t s_launch_leg_us = 0;   // 发射当前单程开始时间
+static CORE_LOCAL bool s_stroke_armed = false;   // 发射行程已开始计时, 尚未结束
+static CORE_LOCAL uint32_t s_shots = 0;          // 上电以来到达限位器2的发射次数
+static CORE_LOCAL motion_vm_t s_launch_vm;       // 发射按键的动作程序
+static CORE_LOCAL motion_vm_t s_program_vm;      // 按键3的动作程序
+static CORE_LOCAL int64_t s_limit2_edge_us = 0;  // 最近一次限位器2触发沿的中断时间
+static CORE_LOCAL int32_t s_aim_cmd[2];          // 手动瞄准上一节拍的命令: 带符号占空比, 0 = 停止
+
+//================================================================================
+// 作业 1: 数码管显示
+//================================================================================
+// 只更新显示服务中的数值, 数码管由运行时在节拍之后按刷新预算写入
+static coop_status_t display_job(coop_job_t *job, int64_t now)
+{
+    COOP_BEGIN(job);
+    while (1)
+    {
+        COOP_WAIT_EVENT(job, EVT_DISPLAY);
+
+        // 显示实测发射速度 (m/s), 首次发射前显示设定速度
+        uint32_t speed_mmps = launch_ctrl_measured_speed_mmps();
+        if (speed_mmps == 0)
+        {
+            speed_mmps = launch_ctrl_target_speed_mmps();
+        }
+        ESP_LOGD(TAG, "ADC Value: %d, Speed: %d mm/s", (int)s_in.pot, (int)speed_mmps);
+        display_service_post(DISPLAY_SRC_SPEED, speed_mmps); // mm/s 显示为 m/s
+        if (launch_ctrl_measured_stroke_us() != 0)
+        {
+            display_service_post(DISPLAY_SRC_STROKE, launch_ctrl_measured_stroke_us() / 1000);
+        }
+        display_service_post(DISPLAY_SRC_SHOTS, s_shots);
+    }
+    COOP_END(job);
+}
+
+//================================================================================
+// 作业 2: 发射流程
+//================================================================================
+// 发射流程是动作程序 (motion_progs.c 的 launch, 单程超时1秒, 正常行程小于100ms),
+// 程序在各阶段用 EMIT 通知这里做检查、计时和报告; 返回 false 结束程序
+static bool launch_emit(motion_vm_t *vm, uint8_t code, uint16_t arg, int64_t now, void *ctx)
+{
+    switch (code)
+    {
+    case MOTION_EMIT_STROKE:
+        // 滑块必须停在限位器1, 且限位器2未触发
+        if (!input_limit_hit(&s_in, 1) || input_limit_hit(&s_in, 2))
+        {
+            ESP_LOGW(TAG, "滑块不在起始位置, 取消发射");
+            core_event_emit(CORE_EVT_LAUNCH_BLOCKED, s_in.gpio & (INPUT_LIMIT_BIT(1) | INPUT_LIMIT_BIT(2)), 0);
+            return false;
+        }
+        ESP_LOGI(TAG, "发射任务开始...");
+
+        // 电机1按电位器设定速度正转，直到触发限位器2 (行程时间由中断计时)
+        ESP_LOGI(TAG, "电机1正转...");
+        s_launch_leg_us = now;
+        vm->arg = launch_ctrl_begin_stroke();
+        s_stroke_armed = true;
+        return true;
+
+    case MOTION_EMIT_STROKE_END:
+        if (input_limit_hit(&s_in, 2))
+        {
+            // 延迟从中断记录的触发沿算起, 没有触发沿时从采样时间算起
+            lat_hist_mark(LAT_LIMIT2_BRAKE, (s_limit2_edge_us > s_launch_leg_us) ? s_limit2_edge_us : s_in.t_us);
+        }
+        s_stroke_armed = false;
+        if (vm->timed_out)
+        {
+            ESP_LOGE(TAG, "等待限位器2超时, 检查限位器");
+            core_event_emit(CORE_EVT_LAUNCH_TIMEOUT, 2, (uint32_t)((now - s_launch_leg_us) / 1000));
+            launch_ctrl_end_stroke();
+        }
+        else
+        {
+            ESP_LOGI(TAG, "触发限位器2");
+            s_shots++;
+            launch_ctrl_end_stroke();
+            coop_sched_post(&s_sched, EVT_DISPLAY); // 速度、行程时间和发射次数
+        }
+        return true;
+
+    case MOTION_EMIT_RETURN:
+        // 电机1反转，直到触发限位器1
+        if (input_limit_hit(&s_in, 1))
+        {
+            ESP_LOGE(TAG, "限位器1仍处于触发状态, 不反转");
+            core_event_emit(CORE_EVT_LIMIT_STUCK, 1, 0);
+            return false;
+        }
+        ESP_LOGI(TAG, "电机1反转...");
+        s_launch_leg_us = now;
+        return true;
+
+    case MOTION_EMIT_RETURN_END:
+        if (input_limit_hit(&s_in, 1)) lat_hist_mark(LAT_LIMIT1_BRAKE, s_in.t_us);
+        if (vm->timed_out)
+        {
+            ESP_LOGE(TAG, "等待限位器1超时, 检查限位器");
+            core_event_emit(CORE_EVT_LAUNCH_TIMEOUT, 1, (uint32_t)((now - s_launch_leg_us) / 1000));
+        }
+        else
+        {
+            ESP_LOGI(TAG, "触发限位器1, 发射流程结束。");
+        }
+        return true;
+
+    default:
+        ESP_LOGI(TAG, "程序 %s: 标记 %u, %u", vm->prog->name, code, arg);
+        return true;
+    }
+}
+
+// 两个程序不能同时驱动同一个电机
+static bool motion_motors_free(const motion_prog_t *prog, const motion_vm_t *other)
+{
+    if (!motion_running(other) || (other->prog->motors & prog->motors) == 0) return true;
+    ESP_LOGW(TAG, "电机被程序 %s 占用, 不运行 %s", other->prog->name, prog->name);
+    return false;
+}
+
+static bool launch_begin(void)
+{
+    const motion_prog_t *prog = motion_prog_get((uint8_t)s_cfg.launch_prog);
+    if (prog == NULL)
+    {
+        ESP_LOGW(TAG, "发射程序 %d 不存在, 使用内置程序", (int)s_cfg.launch_prog);
+        prog = motion_prog_get(MOTION_PROG_LAUNCH);
+    }
+    if (!motion_motors_free(prog, &s_program_vm)) return false;
+    motion_start(&s_launch_vm, prog, launch_emit, NULL);
+    return true;
+}
+
+static coop_status_t launch_job(coop_job_t *job, int64_t now)
+{
+    COOP_BEGIN(job);
+    while (1)
+    {
+        // 等待发射触发事件
+        COOP_WAIT_EVENT(job, EVT_LAUNCH);
+        if (!launch_begin()) continue;
+
+        // 每个节拍执行程序到下一个等待; 失效保护时 failsafe_enter() 中止程序
+        COOP_WAIT_UNTIL(job, now, motion_step(&s_launch_vm, &s_in, now) != MOTION_RUNNING, LIMIT_POLL_MS);
+    }
+    COOP_END(job);
+}
+
+//================================================================================
+// 作业 3: 随机模式
+//================================================================================
+static void random_mode_begin(int64_t now)
+{
+    random_pattern_cfg_t cfg = s_random_cfg;
+    cfg.duration_ms = s_cfg.random_ms;
+    for (int i = 0; i < 2; i++)
+    {
+        uint32_t fwd_us = 0, rev_us = 0;
+        axis_homing_get_travel(i, &fwd_us, &rev_us);
+        bool known = (fwd_us != 0) && (rev_us != 0);
+        cfg.travel_fwd_ms[i] = known ? fwd_us / 1000 : RANDOM_TRAVEL_DEFAULT_MS;
+        cfg.travel_rev_ms[i] = known ? rev_us / 1000 : RANDOM_TRAVEL_DEFAULT_MS;
+        cfg.travel_duty[i] = (uint16_t)axis_homing_get_travel_duty(i);
+        // 从轴当前所在位置开始规划 (回零后在反向端), 位置未知时按中间处理
+        cfg.start_ms[i] = (s_in.aim_pos[i] < 0) ? -1 : (int32_t)(cfg.travel_fwd_ms[i] * s_in.aim_pos[i] / 100);
+    }
+    random_pattern_build(&s_pattern, &cfg, random_pcg_next(&s_session_rng));
+    ESP_LOGI(TAG, "随机模式开始, seed 0x%08" PRIx32 ", %d 步", s_pattern.seed, (int)s_pattern.num_steps);
+    s_random_start_us = now;
+    s_random_step = 0;
+    memset(s_random_dir, 0, sizeof(s_random_dir)); // 空闲时瞄准电机已停止
+    memset(s_random_duty, 0, sizeof(s_random_duty));
+}
+
+// 按动作表执行当前步; 只有动作改变时才发电机命令
+static void random_mode_step(void)
+{
+    const random_step_t *step = &s_pattern.steps[s_random_step];
+    for (int i = 0; i < 2; i++)
+    {
+        int8_t dir = step->dir[i];
+        uint16_t duty = step->duty[i];
+        // 该方向已到限位则反向离开
+        uint8_t limit = (dir > 0) ? (3 + 2 * i) : (4 + 2 * i);
+        if (dir != 0 && input_limit_hit(&s_in, limit))
+        {
+            dir = (int8_t)-dir;
+            limit = (dir > 0) ? (3 + 2 * i) : (4 + 2 * i);
+            if (input_limit_hit(&s_in, limit)) dir = 0;
+        }
+        if (dir == 0) duty = 0;
+        if ((dir == s_random_dir[i]) && (duty == s_random_duty[i])) continue;
+
+        if (dir != 0)
+        {
+            motor_start_duty(1 + i, dir, duty);
+        }
+        else
+        {
+            motor_stop_mode(1 + i, MOTOR_STOP_COAST);
+        }
+        s_random_dir[i] = dir;
+        s_random_duty[i] = duty;
+    }
+
+    s_random_step++;
+    uint32_t next_ms = (s_random_step < s_pattern.num_steps) ? s_pattern.steps[s_random_step].t_ms : s_pattern.duration_ms;
+    s_random_hold_us = s_random_start_us + (int64_t)next_ms * 1000;
+}
+
+// 保持当前动作期间每个节拍检查限位器, 到限位立即刹车; 操作者接管时提前结束
+static bool random_mode_hold(int64_t now)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        uint8_t limit = (s_random_dir[i] > 0) ? (3 + 2 * i) : (4 + 2 * i);
+        if (s_random_dir[i] != 0 && input_limit_hit(&s_in, limit))
+        {
+            lat_hist_mark(LAT_LIMIT_AIM_X + i, s_in.t_us);
+            motor_stop_mode(1 + i, MOTOR_STOP_BRAKE);
+            s_random_dir[i] = 0;
+            s_random_duty[i] = 0;
+        }
+    }
+    return (now >= s_random_hold_us) || (s_state != STATE_IDLE) || s_failsafe;
+}
+
+static coop_status_t random_job(coop_job_t *job, int64_t now)
+{
+    COOP_BEGIN(job);
+    while (1)
+    {
+        // 等待随机模式触发事件
+        COOP_WAIT_EVENT(job, EVT_RANDOM);
+        random_mode_begin(now);
+        while ((s_random_step < s_pattern.num_steps) && (s_state == STATE_IDLE) && !s_failsafe)
+        {
+            random_mode_step();
+            COOP_WAIT_UNTIL(job, now, random_mode_hold(now), LIMIT_POLL_MS);
+        }
+
+        // 回零或手动瞄准接管了电机, 或失效保护, 不再发射
+        if ((s_state != STATE_IDLE) || s_failsafe)
+        {
+            ESP_LOGI(TAG, "随机模式被中断");
+            continue;
+        }
+
+        // 5秒后确保所有电机停止
+        motor_stop(1);
+        motor_stop(2);
+        ESP_LOGI(TAG, "随机模式结束，准备触发发射...");
+
+        // 触发发射流程
+        coop_sched_post(&s_sched, EVT_LAUNCH);
+    }
+    COOP_END(job);
+}
+
+//================================================================================
+// 作业 4: 核心控制
+//================================================================================
+// 手动瞄准命令改变时记录输入时间 (延迟统计): 新的占空比, 或运动中到达限位
+static void aim_cmd_mark(uint8_t axis, int32_t cmd, bool limit_brake)
+{
+    if (cmd != 0 && cmd != s_aim_cmd[axis])
+    {
+        lat_hist_mark(LAT_JOY_AIM_X + axis, s_in.t_us);
+    }
+    else if (limit_brake && s_aim_cmd[axis] != 0)
+    {
+        lat_hist_mark(LAT_LIMIT_AIM_X + axis, s_in.t_us);
+    }
+    s_aim_cmd[axis] = cmd;
+}
+
+// 遥控链路丢失: 所有电机刹车, 退出稳定/手动模式, 中止动作程序; 随机作业看到 s_failsafe 后中止
+static void failsafe_enter(void)
+{
+    ESP_LOGW(TAG, "失效保护: 遥控链路丢失, 所有电机刹车");
+    if (s_state == STATE_STABILIZE) stabilizer_enable(false);
+    for (uint8_t m = 0; m < 3; m++) motor_stop_mode(m, MOTOR_STOP_BRAKE);
+    if (motion_running(&s_launch_vm))
+    {
+        ESP_LOGW(TAG, "失效保护, 发射中止");
+        motion_abort(&s_launch_vm);
+    }
+    if (s_stroke_armed)
+    {
+        launch_ctrl_end_stroke();
+        s_stroke_armed = false;
+    }
+    if (motion_running(&s_program_vm)) motion_abort(&s_program_vm);
+    memset(s_aim_cmd, 0, sizeof(s_aim_cmd));
+    if (s_state != STATE_HOMING) s_state = STATE_IDLE;
+}
+
+static void control_step(void)
+{
+    uint32_t joy_x = s_in.joy_x;
+    uint32_t joy_y = s_in.joy_y;
+    const uint32_t dz_lo_x = s_cfg.joy_dz_lo[0], dz_hi_x = s_cfg.joy_dz_hi[0];
+    const uint32_t dz_lo_y = s_cfg.joy_dz_lo[1], dz_hi_y = s_cfg.joy_dz_hi[1];
+    int32_t duty_x = fixq_joy_duty(&s_joy_x, (int32_t)joy_x); // 负值: 低于死区
+    int32_t duty_y = fixq_joy_duty(&s_joy_y, (int32_t)joy_y);
+    bool stab_key = input_key_down(&s_in, 4);
+    bool stab_toggle = stab_key && !s_stab_key_prev;
+    s_stab_key_prev = stab_key;
+
+    // 失效保护期间不响应按键和摇杆
+    bool failsafe = input_failsafe(&s_in);
+    if (failsafe != s_failsafe) core_event_emit(CORE_EVT_FAILSAFE, failsafe, 0);
+    if (failsafe && !s_failsafe) failsafe_enter();
+    if (!failsafe && s_failsafe) ESP_LOGI(TAG, "失效保护解除");
+    s_failsafe = failsafe;
+    if (failsafe) return;
+
+    switch (s_state)
+    {
+    case STATE_HOMING:
+        // 回零期间不响应按键和摇杆
+        if (!axis_homing_busy())
+        {
+            s_state = STATE_IDLE;
+            ESP_LOGI(TAG, "state change: HOMING -> IDLE");
+        }
+        break;
+
+    case STATE_IDLE:
+        axis_homing_poll();
+        if (input_key_down(&s_in, 1)) // 按键KEY1按下
+        {
+            ESP_LOGI(TAG, "KEY1按下, 重新回零...");
+            coop_sched_post(&s_sched, EVT_REHOME);
+            s_state = STATE_HOMING;
+            ESP_LOGI(TAG, "state change: IDLE -> HOMING");
+        }
+        else if (input_key_down(&s_in, 2) && input_limit_hit(&s_in, 1)) // 按键1按下且限位器1触发
+        {
+            ESP_LOGI(TAG, "按键1按下, 触发发射任务...");
+            lat_hist_mark(LAT_KEY_LAUNCH, s_in.t_us);
+            coop_sched_post(&s_sched, EVT_LAUNCH);
+        }
+        else if (input_key_down(&s_in, 3) && s_cfg.key3_prog != MOTION_PROG_NONE) // 按键3按下, 配置了动作程序
+        {
+            coop_sched_post(&s_sched, EVT_PROGRAM);
+        }
+        else if (input_key_down(&s_in, 3)) // 按键2按下
+        {
+            ESP_LOGI(TAG, "按键2按下, 触发随机任务...");
+            coop_sched_post(&s_sched, EVT_RANDOM);
+        }
+        else if (stab_toggle && input_stab_ready(&s_in)) // 按键4按下, 保持当前姿态
+        {
+            stabilizer_set_limits(s_in.gpio);
+            stabilizer_enable(true);
+            s_state = STATE_STABILIZE;
+            ESP_LOGI(TAG, "state change: IDLE -> STABILIZE");
+        }
+        else if ((joy_x < dz_lo_x) || (joy_x > dz_hi_x) ||
+                 (joy_y < dz_lo_y) || (joy_y > dz_hi_y))
+        {
+            s_state = STATE_MANUAL_AIM; // 摇杆被触动
+            ESP_LOGI(TAG, "state change: IDLE -> MANUAL_AIM");
+        }
+        break;
+
+    case STATE_MANUAL_AIM:
+        axis_homing_poll();
+        // --- 摇杆X轴控制电机2, 速度随偏移量增大 ---
+        if ((joy_x < dz_lo_x) && !input_limit_hit(&s_in, 3))
+        {
+            aim_cmd_mark(0, -duty_x, false);
+            motor_start_duty(1, 1, (uint32_t)-duty_x); // X轴向一侧
+        }
+        else if ((joy_x > dz_hi_x) && !input_limit_hit(&s_in, 4))
+        {
+            aim_cmd_mark(0, -duty_x, false);
+            motor_start_duty(1, -1, (uint32_t)duty_x); // X轴向另一侧
+        }
+        else if ((joy_x < dz_lo_x) || (joy_x > dz_hi_x))
+        {
+            aim_cmd_mark(0, 0, true);
+            motor_stop_mode(1, MOTOR_STOP_BRAKE); // 已到限位, 立即刹车
+        }
+        else
+        {
+            aim_cmd_mark(0, 0, false);
+            motor_stop(1); // X轴回中则斜坡停止
+        }
+
+        // --- 摇杆Y轴控制电机3, 速度随偏移量增大 ---
+        if ((joy_y < dz_lo_y) && !input_limit_hit(&s_in, 5))
+        {
+            aim_cmd_mark(1, -duty_y, false);
+            motor_start_duty(2, 1, (uint32_t)-duty_y); // Y轴向一侧
+        }
+        else if ((joy_y > dz_hi_y) && !input_limit_hit(&s_in, 6))
+        {
+            aim_cmd_mark(1, -duty_y, false);
+            motor_start_duty(2, -1, (uint32_t)duty_y); // Y轴向另一侧
+        }
+        else if ((joy_y < dz_lo_y) || (joy_y > dz_hi_y))
+        {
+            aim_cmd_mark(1, 0, true);
+            motor_stop_mode(2, MOTOR_STOP_BRAKE); // 已到限位, 立即刹车
+        }
+        else
+        {
+            aim_cmd_mark(1, 0, false);
+            motor_stop(2); // Y轴回中则斜坡停止
+        }
+
+        // --- 如果摇杆完全回中，则返回IDLE状态 ---
+        if ((joy_x >= dz_lo_x) && (joy_x <= dz_hi_x) &&
+            (joy_y >= dz_lo_y) && (joy_y <= dz_hi_y))
+        {
+            s_state = STATE_IDLE;
+            ESP_LOGI(TAG, "state change: MANUAL_AIM -> IDLE");
+        }
+        break;
+
+    case STATE_STABILIZE:
+        // 电机由稳定环驱动, 摇杆偏移换算为目标转动速度 (与手动瞄准同方向)
+        if (stab_toggle || input_key_down(&s_in, 1))
+        {
+            stabilizer_enable(false); // 返回后稳定环不再发电机命令
+            motor_stop_mode(1, MOTOR_STOP_BRAKE);
+            motor_stop_mode(2, MOTOR_STOP_BRAKE);
+            s_state = STATE_IDLE;
+            ESP_LOGI(TAG, "state change: STABILIZE -> IDLE");
+            break;
+        }
+        stabilizer_set_limits(s_in.gpio); // 限位器状态取自输入帧, 记录和回放一致
+        stabilizer_set_rate(-duty_x * STAB_RATE_MAX_MDPS / (int32_t)s_cfg.joy_duty_max,
+                            -duty_y * STAB_RATE_MAX_MDPS / (int32_t)s_cfg.joy_duty_max);
+        break;
+    }
+
+    ESP_LOGD(TAG, "JoyX: %d, JoyY: %d", (int)joy_x, (int)joy_y);
+}
+
+static coop_status_t control_job(coop_job_t *job, int64_t now)
+{
+    COOP_BEGIN(job);
+    while (1)
+    {
+        COOP_WAIT_EVENT(job, EVT_TICK);
+        control_step();
+    }
+    COOP_END(job);
+}
+
+//================================================================================
+// 作业 5: 按键3的动作程序
+//================================================================================
+// 发射阶段的事件只属于发射程序
+static bool program_emit(motion_vm_t *vm, uint8_t code, uint16_t arg, int64_t now, void *ctx)
+{
+    if (code != MOTION_EMIT_MARK)
+    {
+        ESP_LOGW(TAG, "程序 %s: 事件 %u 只能用于发射程序", vm->prog->name, code);
+        return false;
+    }
+    ESP_LOGI(TAG, "程序 %s: 标记 %u", vm->prog->name, arg);
+    return true;
+}
+
+static bool program_begin(void)
+{
+    const motion_prog_t *prog = motion_prog_get((uint8_t)s_cfg.key3_prog);
+    if (prog == NULL)
+    {
+        ESP_LOGW(TAG, "动作程序 %d 不存在", (int)s_cfg.key3_prog);
+        return false;
+    }
+    if (!motion_motors_free(prog, &s_launch_vm)) return false;
+    ESP_LOGI(TAG, "动作程序 %s 开始", prog->name);
+    motion_start(&s_program_vm, prog, program_emit, NULL);
+    return true;
+}
+
+// 与随机模式相同: 电机运动中到达该方向的限位立即刹车; 发射电机正转到限位器2, 反转到限位器1
+static void program_limit_guard(void)
+{
+    static const uint8_t limit_fwd[3] = {2, 3, 5}, limit_rev[3] = {1, 4, 6};
+    static const lat_path_t path_fwd[3] = {LAT_LIMIT2_BRAKE, LAT_LIMIT_AIM_X, LAT_LIMIT_AIM_Y};
+    static const lat_path_t path_rev[3] = {LAT_LIMIT1_BRAKE, LAT_LIMIT_AIM_X, LAT_LIMIT_AIM_Y};
+    for (uint8_t m = 0; m < 3; m++)
+    {
+        if ((s_program_vm.driving & (1u << m)) == 0) continue;
+        bool fwd = s_program_vm.dir[m] > 0;
+        if (!input_limit_hit(&s_in, fwd ? limit_fwd[m] : limit_rev[m])) continue;
+        lat_hist_mark(fwd ? path_fwd[m] : path_rev[m], s_in.t_us);
+        motor_stop_mode(m, MOTOR_STOP_BRAKE);
+        s_program_vm.driving &= ~(1u << m);
+    }
+}
+
+// 回零、手动瞄准或稳定模式接管电机时中止程序 (失效保护由 failsafe_enter() 中止)
+static bool program_done(int64_t now)
+{
+    if (s_state != STATE_IDLE && motion_running(&s_program_vm))
+    {
+        ESP_LOGI(TAG, "动作程序 %s 被中断", s_program_vm.prog->name);
+        motion_abort(&s_program_vm);
+    }
+    motion_status_t status = motion_step(&s_program_vm, &s_in, now);
+    program_limit_guard();
+    if (status == MOTION_DONE) ESP_LOGI(TAG, "动作程序 %s 结束", s_program_vm.prog->name);
+    return status != MOTION_RUNNING;
+}
+
+static coop_status_t program_job(coop_job_t *job, int64_t now)
+{
+    COOP_BEGIN(job);
+    while (1)
+    {
+        COOP_WAIT_EVENT(job, EVT_PROGRAM);
+        if (!program_begin()) continue;
+        COOP_WAIT_UNTIL(job, now, program_done(now), LIMIT_POLL_MS);
+    }
+    COOP_END(job);
+}
+
+void control_core_init(void)
+{
+    const input_frame_t idle = INPUT_FRAME_INIT;
+    s_state = STATE_HOMING;
+    s_in = idle;
+    s_stab_key_prev = false;
+    s_failsafe = false;
+    s_limit2_edge_us = 0;
+    memset(s_aim_cmd, 0, sizeof(s_aim_cmd));
+    s_random_start_us = 0;
+    s_random_step = 0;
+    memset(s_random_dir, 0, sizeof(s_random_dir));
+    memset(s_random_duty, 0, sizeof(s_random_duty));
+    random_pcg_seed(&s_session_rng, 0);
+    s_cfg.version = 0;
+    control_core_set_cfg(tune_cfg_defaults());
+    s_key_raw = s_key_stable = INPUT_GPIO_IDLE & KEY_BITS;
+    s_key_raw_us = 0;
+    fixq_lpf_init(&s_pot_lpf, POT_FILTER_SHIFT);
+    launch_ctrl_reset();
+    memset(&s_launch_vm, 0, sizeof(s_launch_vm));
+    memset(&s_program_vm, 0, sizeof(s_program_vm));
+    s_stroke_armed = false;
+    s_shots = 0;
+
+    // --- 注册作业 (同一节拍内按注册顺序执行) ---
+    // 作业只在 control_core_step() 中运行, 不需要唤醒回调
+    coop_sched_init(&s_sched, NULL, NULL);
+    coop_sched_add(&s_sched, &s_control_job, "control", control_job, NULL, EVT_TICK);
+    coop_sched_add(&s_sched, &s_launch_job, "launch", launch_job, NULL, EVT_LAUNCH);
+    coop_sched_add(&s_sched, &s_random_job, "random", random_job, NULL, EVT_RANDOM);
+    coop_sched_add(&s_sched, &s_display_job, "display", display_job, NULL, EVT_DISPLAY);
+    coop_sched_add(&s_sched, &s_program_job, "program", program_job, NULL, EVT_PROGRAM);
+    axis_homing_init(&s_sched, &s_in, EVT_REHOME); // 回零作业立即开始运行
+    display_service_post(DISPLAY_SRC_STATE, s_state);
+}
+
+// 按键电平保持 key_debounce_ms 不变后才生效, 0 = 每次采样直接生效
+static void key_debounce(void)
+{
+    uint16_t raw = s_in.gpio & KEY_BITS;
+    if (raw != s_key_raw)
+    {
+        s_key_raw = raw;
+        s_key_raw_us = s_in.t_us;
+    }
+    if (s_in.t_us - s_key_raw_us >= (int64_t)s_cfg.key_debounce_ms * 1000) s_key_stable = raw;
+    s_in.gpio = (uint16_t)((s_in.gpio & ~KEY_BITS) | s_key_stable);
+}
+
+// 新参数在下一节拍开始生效; 运行时在采样和记录之后调用, 回放时按记录调用
+void control_core_set_cfg(const tune_cfg_t *cfg)
+{
+    if (cfg->version == s_cfg.version) return;
+    s_cfg = *cfg;
+    motor_set_default_duty(s_cfg.duty_pct * MOTOR_DUTY_SCALE / 100);
+    fixq_joy_init(&s_joy_x, JOYSTICK_ADC_MAX, s_cfg.joy_dz_lo[0], s_cfg.joy_dz_hi[0], s_cfg.joy_duty_min, s_cfg.joy_duty_max);
+    fixq_joy_init(&s_joy_y, JOYSTICK_ADC_MAX, s_cfg.joy_dz_lo[1], s_cfg.joy_dz_hi[1], s_cfg.joy_duty_min, s_cfg.joy_duty_max);
+}
+
+int64_t control_core_step(const input_frame_t *in)
+{
+    s_in = *in;
+    key_debounce();
+    launch_ctrl_on_frame(&s_in);
+    if (s_in.t_edge_us[INPUT_EDGE_LIMIT2_HIT] != 0) s_limit2_edge_us = s_in.t_edge_us[INPUT_EDGE_LIMIT2_HIT];
+
+    if (input_adc_fresh(&s_in))
+    {
+        launch_ctrl_set_setpoint(fixq_lpf_update(&s_pot_lpf, s_in.pot));
+        coop_sched_post(&s_sched, EVT_DISPLAY);
+    }
+
+    coop_sched_post(&s_sched, EVT_TICK);
+    system_state_t prev = s_state;
+    int64_t next = coop_sched_run(&s_sched, s_in.t_us);
+    if (s_state != prev)
+    {
+        core_event_emit(CORE_EVT_STATE, prev, s_state);
+        display_service_post(DISPLAY_SRC_STATE, s_state);
+    }
+    return next;
+}
+
+// 随机模式的会话种子, 在 control_core_init() 之后设置; 相同种子产生相同的动作序列
+void control_core_set_seed(uint32_t seed)
+{
+    random_pcg_seed(&s_session_rng, seed);
+}
+
+system_state_t control_core_state(void)
+{
+    return s_state;
+}
+
+// 没有进行中的动作: 发射和按键3的程序未运行, 随机模式在等待触发, 没有未处理的触发事件, 电机全部停止
+bool control_core_quiescent(void)
+{
+    const uint32_t start = EVT_LAUNCH | EVT_RANDOM | EVT_PROGRAM;
+    uint32_t queued = atomic_load(&s_sched.pending) | s_launch_job.events | s_random_job.events | s_program_job.events;
+    if (motion_running(&s_launch_vm) || motion_running(&s_program_vm) || s_stroke_armed) return false;
+    if (s_random_job.wait_mask != EVT_RANDOM || (queued & start) != 0) return false;
+    return !motor_busy();
+}
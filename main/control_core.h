@@ -0,0 +1,31 @@
+#ifndef _CONTROL_CORE_H_
+#define _CONTROL_CORE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "input_frame.h"
+#include "tune_cfg.h"
+
+/*
+ * Control logic: the system state machine and the launch / random / display jobs.
+ * It never touches the input hardware; every decision is made from the frame passed
+ * to control_core_step(), so the same code runs on the device, under replay of a
+ * recording and in host builds.
+ */
+
+typedef enum
+{
+    STATE_IDLE,       // 空闲状态
+    STATE_MANUAL_AIM, // 手动摇杆控制状态
+    STATE_HOMING,     // 瞄准轴回零中
+    STATE_STABILIZE,  // 瞄准轴由稳定环保持, 摇杆给出转动速度
+} system_state_t;
+
+void control_core_init(void);
+void control_core_set_seed(uint32_t seed);          // random mode session seed
+void control_core_set_cfg(const tune_cfg_t *cfg);   // copied when the version changes
+int64_t control_core_step(const input_frame_t *in); // one control tick, returns next job deadline
+system_state_t control_core_state(void);
+bool control_core_quiescent(void); // nothing running or queued, all motors stopped: flash and sleep cannot stall a motion
+
+#endif // !_CONTROL_CORE_H_
@@ -0,0 +1,86 @@
+#include "coop_sched.h"
+#include <string.h>
+
+// Upper bound of back-to-back passes when jobs keep posting to each other.
+#define COOP_MAX_PASSES_PER_RUN     4
+
+void coop_sched_init(coop_sched_t *sched, void (*wake)(void *arg), void *wake_arg)
+{
+    memset(sched, 0, sizeof(*sched));
+    atomic_init(&sched->pending, 0);
+    sched->wake = wake;
+    sched->wake_arg = wake_arg;
+}
+
+bool coop_sched_add(coop_sched_t *sched, coop_job_t *job, const char *name, coop_job_fn_t fn, void *ctx, uint32_t listen)
+{
+    if (sched->num_jobs >= COOP_MAX_JOBS) return false;
+
+    memset(job, 0, sizeof(*job));
+    job->name = name;
+    job->fn = fn;
+    job->ctx = ctx;
+    job->listen = listen;
+    job->wake_us = COOP_NEVER;
+    sched->jobs[sched->num_jobs++] = job;
+    return true;
+}
+
+void coop_sched_post(coop_sched_t *sched, uint32_t events)
+{
+    atomic_fetch_or(&sched->pending, events);
+    if (sched->wake)
+    {
+        sched->wake(sched->wake_arg);
+    }
+}
+
+static bool job_ready(const coop_job_t *job, int64_t now_us)
+{
+    if (job->lc == 0) return true;                       // fresh or restarted
+    if (job->events & job->wait_mask) return true;       // event arrived
+    return (job->wake_us != COOP_NEVER) && (now_us >= job->wake_us);
+}
+
+int64_t coop_sched_run(coop_sched_t *sched, int64_t now_us)
+{
+    for (int pass = 0; pass < COOP_MAX_PASSES_PER_RUN; pass++)
+    {
+        uint32_t posted = atomic_exchange(&sched->pending, 0);
+        for (int i = 0; i < sched->num_jobs; i++)
+        {
+            sched->jobs[i]->events |= posted & sched->jobs[i]->listen;
+        }
+
+        sched->passes++;
+        for (int i = 0; i < sched->num_jobs; i++)
+        {
+            coop_job_t *job = sched->jobs[i];
+            if (job_ready(job, now_us))
+            {
+                job->resumes++;
+                job->fn(job, now_us);
+            }
+        }
+
+        // events posted by a job during this pass are handled within the same tick
+        if (atomic_load(&sched->pending) == 0) break;
+    }
+
+    if (atomic_load(&sched->pending) != 0) return now_us;
+
+    int64_t next = COOP_NEVER;
+    for (int i = 0; i < sched->num_jobs; i++)
+    {
+        const coop_job_t *job = sched->jobs[i];
+        if (job->lc == 0 || (job->events & job->wait_mask))
+        {
+            return now_us;
+        }
+        if (job->wake_us < next)
+        {
+            next = job->wake_us;
+        }
+    }
+    return next;
+}
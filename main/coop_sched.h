@@ -0,0 +1,92 @@
+#ifndef _COOP_SCHED_H_
+#define _COOP_SCHED_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/*
+ * Cooperative executor: stackless jobs (protothreads) that run inside one task.
+ * A job keeps its resume point in `lc` and its state in `ctx`, so locals do not
+ * survive a wait. Jobs are resumed in registration order when an event they wait
+ * for is posted or their deadline expires.
+ */
+
+#define COOP_MAX_JOBS   8
+#define COOP_NEVER      INT64_MAX
+
+typedef enum
+{
+    COOP_WAITING, // job is parked on an event or deadline
+    COOP_DONE,    // job returned, restarts from the top on next pass
+} coop_status_t;
+
+typedef struct coop_job coop_job_t;
+typedef coop_status_t (*coop_job_fn_t)(coop_job_t *job, int64_t now_us);
+
+struct coop_job
+{
+    const char *name;
+    coop_job_fn_t fn;
+    void *ctx;
+    uint16_t lc;        // resume point (source line), 0 = start
+    uint32_t listen;    // events latched for this job
+    uint32_t wait_mask; // events the job is currently blocked on
+    uint32_t events;    // latched, not yet consumed events
+    int64_t wake_us;    // deadline, COOP_NEVER when none
+    uint32_t resumes;
+};
+
+typedef struct
+{
+    coop_job_t *jobs[COOP_MAX_JOBS];
+    uint8_t num_jobs;
+    atomic_uint pending;       // posted events, drained at the start of a pass
+    void (*wake)(void *arg);   // called after post, e.g. to notify the runner task
+    void *wake_arg;
+    uint32_t passes;
+} coop_sched_t;
+
+void coop_sched_init(coop_sched_t *sched, void (*wake)(void *arg), void *wake_arg);
+bool coop_sched_add(coop_sched_t *sched, coop_job_t *job, const char *name, coop_job_fn_t fn, void *ctx, uint32_t listen);
+void coop_sched_post(coop_sched_t *sched, uint32_t events); // task and ISR safe
+int64_t coop_sched_run(coop_sched_t *sched, int64_t now_us); // returns next deadline
+
+// --- job body helpers (Duff's device, one resume point per line) ---
+#define COOP_BEGIN(job)             switch ((job)->lc) { case 0:
+#define COOP_END(job)               } (job)->lc = 0; return COOP_DONE
+#define COOP_MARK_(job)             (job)->lc = __LINE__; case __LINE__:
+
+// Park until `cond` holds, re-checking every poll_ms.
+#define COOP_WAIT_UNTIL(job, now, cond, poll_ms)                            \
+    do {                                                                    \
+        COOP_MARK_(job)                                                     \
+        if (!(cond))                                                        \
+        {                                                                   \
+            (job)->wake_us = (now) + (int64_t)(poll_ms) * 1000;             \
+            return COOP_WAITING;                                            \
+        }                                                                   \
+        (job)->wake_us = COOP_NEVER;                                        \
+    } while (0)
+
+// Park for `ms` milliseconds.
+#define COOP_DELAY_MS(job, now, ms)                                         \
+    do {                                                                    \
+        (job)->wake_us = (now) + (int64_t)(ms) * 1000;                      \
+        COOP_MARK_(job)                                                     \
+        if ((now) < (job)->wake_us) return COOP_WAITING;                    \
+        (job)->wake_us = COOP_NEVER;                                        \
+    } while (0)
+
+// Park until one of `mask` is posted; consumed bits are cleared.
+#define COOP_WAIT_EVENT(job, mask)                                          \
+    do {                                                                    \
+        (job)->wait_mask = (mask);                                          \
+        COOP_MARK_(job)                                                     \
+        if (((job)->events & (mask)) == 0) return COOP_WAITING;             \
+        (job)->events &= ~(uint32_t)(mask);                                 \
+        (job)->wait_mask = 0;                                               \
+    } while (0)
+
+#endif // !_COOP_SCHED_H_
@@ -0,0 +1,33 @@
+#include "core_event.h"
+#include <stddef.h>
+#include "core_local.h"
+
+static CORE_LOCAL core_event_hook_t s_hook = NULL;
+static CORE_LOCAL void *s_hook_arg = NULL;
+
+static const char *const s_names[CORE_EVT_COUNT] = {
+    [CORE_EVT_STATE]          = "state",
+    [CORE_EVT_FAILSAFE]       = "failsafe",
+    [CORE_EVT_LAUNCH_BLOCKED] = "launch blocked",
+    [CORE_EVT_LAUNCH_TIMEOUT] = "launch timeout",
+    [CORE_EVT_LIMIT_STUCK]    = "limit stuck",
+    [CORE_EVT_HOME_TIMEOUT]   = "homing timeout",
+    [CORE_EVT_HOME_STUCK]     = "homing stuck",
+    [CORE_EVT_HOME_SHORT]     = "travel short",
+};
+
+void core_event_set_hook(core_event_hook_t hook, void *arg)
+{
+    s_hook = hook;
+    s_hook_arg = arg;
+}
+
+void core_event_emit(core_event_t evt, uint32_t a, uint32_t b)
+{
+    if (s_hook != NULL) s_hook(evt, a, b, s_hook_arg);
+}
+
+const char *core_event_name(core_event_t evt)
+{
+    return ((unsigned)evt < CORE_EVT_COUNT) ? s_names[evt] : "?";
+}
@@ -0,0 +1,37 @@
+#ifndef _CORE_EVENT_H_
+#define _CORE_EVENT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+/*
+ * Notable events of the control logic: state transitions and the faults it detects
+ * (launch legs that never reach their switch, switches stuck closed, homing
+ * failures, failsafe). The control core and homing report them here next to their
+ * log lines; the device runtime installs a hook that journals them to flash
+ * (journal.h) and shows fault codes on the display (display_service.h). Without a
+ * hook, as on the host, reporting costs a null check.
+ *
+ * The hook runs inside control_core_step() and must not block.
+ */
+
+typedef enum
+{
+    CORE_EVT_STATE,             // a = previous system_state_t, b = new state
+    CORE_EVT_FAILSAFE,          // a = 1 entered (all motors braked), 0 cleared
+    CORE_EVT_LAUNCH_BLOCKED,    // launch requested off the start position: a = limit 1/2 gpio bits
+    CORE_EVT_LAUNCH_TIMEOUT,    // a = limit switch never reached (2 or 1), b = ms driven
+    CORE_EVT_LIMIT_STUCK,       // a = limit switch still closed after the move away
+    CORE_EVT_HOME_TIMEOUT,      // a = motor, b = ms driven without reaching the switch
+    CORE_EVT_HOME_STUCK,        // a = motor, both of its limit switches closed
+    CORE_EVT_HOME_SHORT,        // a = motor, b = measured travel (us) below the minimum
+    CORE_EVT_COUNT,
+} core_event_t;
+
+typedef void (*core_event_hook_t)(core_event_t evt, uint32_t a, uint32_t b, void *arg);
+
+void core_event_set_hook(core_event_hook_t hook, void *arg);
+void core_event_emit(core_event_t evt, uint32_t a, uint32_t b);
+const char *core_event_name(core_event_t evt);
+
+#endif // !_CORE_EVENT_H_
@@ -0,0 +1,16 @@
+#ifndef _CORE_LOCAL_H_
+#define _CORE_LOCAL_H_
+
+/*
+ * Storage class for module state of the control logic. The host scenario runner
+ * runs one control core per thread, so there the state is thread-local; on the
+ * device it is ordinary static storage.
+ */
+
+#ifdef CORE_THREAD_LOCAL
+#define CORE_LOCAL  _Thread_local
+#else
+#define CORE_LOCAL
+#endif
+
+#endif // !_CORE_LOCAL_H_
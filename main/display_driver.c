@@ -5,7 +5,6 @@
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "esp_rom_sys.h"
-#include <math.h>
 #include "esp_timer.h"
 
 const static char *TAG = "DISPLAY_DRIVER";
@@ -26,27 +25,13 @@ const static char *TAG = "DISPLAY_DRIVER";
 //Display Control Command Settings
 #define TM1637_CMD_SET_DISPLAY      0x80
 #define TM1637_DISPLAY_ON           0x08
-#define TM1637_BRIGHTNESS_10_16     0x03 // (0x00 - 0x07)
-
-static const uint8_t segment_map[] = {
-    0x3f, // 0
-    0x06, // 1
-    0x5b, // 2
-    0x4f, // 3
-    0x66, // 4
-    0x6d, // 5
-    0x7d, // 6
-    0x07, // 7
-    0x7f, // 8
-    0x6f  // 9
-};
-
-
-/*ʾģʽ (дݣַԶ)*/
+#define TM1637_BRIGHTNESS_10_16     0x03 //亮度设置 (0x00 - 0x07)
+
+/*设置显示模式 (写数据，地址自动增加)*/
 const uint8_t data_cmd = TM1637_CMD_SET_DATA | TM1637_MODE_WRITE_TO_REG | TM1637_ADDR_MODE_AUTO_INC;
-/*ʼַ (GRID1ʼ)*/
+/*设置起始地址 (从GRID1开始)*/
 const uint8_t addr_cmd = TM1637_CMD_SET_ADDR;
-/*ʾ (е)*/
+/*打开显示并设置亮度 (中等亮度)*/
 const uint8_t display_cmd = TM1637_CMD_SET_DISPLAY | TM1637_DISPLAY_ON | TM1637_BRIGHTNESS_10_16;
 
 static void tm1637_start(void)
@@ -96,58 +81,8 @@ static void tm1637_write_byte(uint8_t byte)
     gpio_set_level(TM1637_SCL, 0);
 }
 
-static void display_set_number_dot(uint16_t number, uint8_t dot_mask)
+void display_write_segments(const uint8_t seg[4])
 {
-    if (number > 9999) return; 
-
-    uint8_t display_data[4];
-    display_data[0] = segment_map[number / 1000];
-    display_data[1] = segment_map[(number / 100) % 10];
-    display_data[2] = segment_map[(number / 10) % 10];
-    display_data[3] = segment_map[number % 10];
-
-
-    bool needs_leading_zero = false;
-    if (((dot_mask & 0x08) && number < 1000) || ((dot_mask & 0x04) && number < 100)  || ((dot_mask & 0x02) && number < 10)) 
-    {  
-        needs_leading_zero = true;
-    }
-
-    if (number < 1000) 
-    {
-        display_data[0] = 0x00;
-        if (needs_leading_zero && number >= 100) 
-        {
-            display_data[0] = segment_map[0];
-        }
-    }
-
-    if (number < 100)
-    {
-        display_data[0] = 0x00;
-        display_data[1] = 0x00;
-        if (needs_leading_zero && number >= 10)
-        {
-            display_data[1] = segment_map[0];
-        }
-    }
-
-    if (number < 10)
-    {
-        display_data[0] = 0x00;
-        display_data[1] = 0x00;
-        display_data[2] = 0x00;
-        if (needs_leading_zero)
-        {
-            display_data[2] = segment_map[0];
-        }
-    }
-
-    if (dot_mask & 0x08) display_data[0] |= 0x80; 
-    if (dot_mask & 0x04) display_data[1] |= 0x80;
-    if (dot_mask & 0x02) display_data[2] |= 0x80;
-    if (dot_mask & 0x01) display_data[3] |= 0x80;
-
     // Set data mode
     tm1637_start();
     tm1637_write_byte(data_cmd);
@@ -157,50 +92,11 @@ static void display_set_number_dot(uint16_t number, uint8_t dot_mask)
     tm1637_start();
     tm1637_write_byte(addr_cmd);
     for (int i = 0; i < 4; i++) {
-        tm1637_write_byte(display_data[i]);
+        tm1637_write_byte(seg[i]);
     }
     tm1637_stop();
 }
 
-void display_set_float(float number)
-{
-    if (number > 9999.0f) 
-    {
-        number = 9999.0f;
-    }
-    if (number < 0) 
-    {
-        display_clear(); 
-        return;
-    }
-
-    uint16_t display_num;
-    uint8_t dot_mask = 0x00;
-
-    if (number < 10.0f) 
-    {
-        dot_mask = 0x08;
-        display_num = (uint16_t)round(number * 1000.0f);
-    } 
-    else if (number < 100.0f) 
-    {
-        dot_mask = 0x04;
-        display_num = (uint16_t)round(number * 100.0f);
-    } 
-    else if (number < 1000.0f) 
-    {
-        dot_mask = 0x02;
-        display_num = (uint16_t)round(number * 10.0f);
-    } 
-    else 
-    {
-        dot_mask = 0x00;
-        display_num = (uint16_t)round(number);
-    }
-    display_set_number_dot(display_num, dot_mask);
-}
-
-
 void display_clear(void)
 { 
     tm1637_start();
@@ -236,3 +132,12 @@ void display_init(void)
     ESP_LOGI(TAG, "TM1637 initialized successfully.");
 }
 
+// 设置亮度 (0-7) 和显示开关, 显示内容不变 (闪烁只切换开关)
+void display_set_control(bool on, uint8_t level)
+{
+    if (level > 7) level = 7;
+    tm1637_start();
+    tm1637_write_byte(TM1637_CMD_SET_DISPLAY | (on ? TM1637_DISPLAY_ON : 0) | level);
+    tm1637_stop();
+}
+
@@ -1,9 +1,14 @@
 #ifndef _DISPLAY_DRIVER_H_
 #define _DISPLAY_DRIVER_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
+// TM1637 bus access; after init only the display service (display_service.h) calls these
 void display_init(void);
 void display_clear(void);
-void display_set_float(float number);
+void display_write_segments(const uint8_t seg[4]);
+void display_set_control(bool on, uint8_t level); // level 0-7
 
 #endif // !_DISPLAY_DRIVER_H_
 
@@ -0,0 +1,216 @@
+#include "display_service.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "esp_timer.h"
+
+#include "display_driver.h"
+#include "fixq.h"
+#include "core_local.h"
+
+#define DISPLAY_ROTATE_PAGES    3   // the fault page only shows while a fault overrides
+#define DISPLAY_BRIGHTNESS_MAX  7
+#define DISPLAY_BRIGHTNESS_INIT 3   // until the tuning parameter is applied
+
+// letters, for the page prefixes
+#define GLYPH_E     0x79
+#define GLYPH_T     0x78
+#define GLYPH_DASH  0x40
+
+typedef struct
+{
+    uint8_t page;       // page the source is part of, shown while it overrides
+    uint8_t prio;       // higher wins among overriding sources
+    uint16_t hold_ms;   // a changed non-zero value overrides the rotation this long, 0 = never
+    bool blink;         // blink while overriding
+    bool retrigger;     // posting the same value again restarts the override
+    uint16_t min_change; // smaller moves from the value that started the override only update the digits
+} display_src_cfg_t;
+
+static const display_src_cfg_t s_src_cfg[DISPLAY_SRC_COUNT] = {
+    [DISPLAY_SRC_SPEED] = {.page = 0, .prio = 1, .hold_ms = 1500, .min_change = 100}, // 0.1 m/s, above pot jitter
+    [DISPLAY_SRC_STROKE] = {.page = 1, .prio = 2, .hold_ms = 2000},
+    [DISPLAY_SRC_STATE] = {.page = 2, .prio = 0, .hold_ms = 0},
+    [DISPLAY_SRC_SHOTS] = {.page = 2, .prio = 0, .hold_ms = 0},
+    [DISPLAY_SRC_FAULT] = {.page = 3, .prio = 3, .hold_ms = 5000, .blink = true, .retrigger = true},
+};
+
+// producers: one encoded word per source, digit i in byte i
+static CORE_LOCAL atomic_uint s_word[DISPLAY_SRC_COUNT];
+static CORE_LOCAL atomic_uint s_value[DISPLAY_SRC_COUNT];  // raw value behind the word
+static CORE_LOCAL atomic_uint s_seq[DISPLAY_SRC_COUNT];   // posts per source
+static CORE_LOCAL atomic_uint s_posts;
+static CORE_LOCAL atomic_uint s_rotate_ms;
+static CORE_LOCAL atomic_uint s_brightness;
+static CORE_LOCAL atomic_bool s_blink;
+
+// poll only
+static CORE_LOCAL uint32_t s_seen[DISPLAY_SRC_COUNT];   // word at the previous poll
+static CORE_LOCAL uint32_t s_seen_seq[DISPLAY_SRC_COUNT];
+static CORE_LOCAL uint32_t s_held[DISPLAY_SRC_COUNT];   // value that last started an override
+static CORE_LOCAL int64_t s_until_us[DISPLAY_SRC_COUNT]; // override end
+static CORE_LOCAL uint32_t s_shown_frame;
+static CORE_LOCAL uint8_t s_shown_ctrl;                  // bit 3 on, bits 0-2 brightness; 0xff = unknown
+static CORE_LOCAL bool s_shown_valid;
+static CORE_LOCAL int64_t s_write_us;
+static CORE_LOCAL display_stats_t s_stats;
+
+static uint32_t pack(const uint8_t seg[4])
+{
+    return (uint32_t)seg[0] | ((uint32_t)seg[1] << 8) | ((uint32_t)seg[2] << 16) | ((uint32_t)seg[3] << 24);
+}
+
+// Each source fills only its own digits, so a page is the OR of its sources.
+static uint32_t encode(display_src_t src, uint32_t value)
+{
+    uint8_t seg[4];
+    switch (src)
+    {
+    case DISPLAY_SRC_SPEED:
+        fixq_segments_milli(value, seg);
+        return pack(seg);
+    case DISPLAY_SRC_STROKE:
+        fixq_segments((uint16_t)(value > 999 ? 999 : value), 0x00, seg);
+        seg[0] = GLYPH_T;
+        return pack(seg);
+    case DISPLAY_SRC_STATE:
+        fixq_segments((uint16_t)(value % 10), 0x01, seg); // units digit with its point
+        return seg[3];
+    case DISPLAY_SRC_SHOTS:
+        fixq_segments((uint16_t)(value % 1000), 0x00, seg);
+        seg[0] = 0x00;
+        return pack(seg);
+    case DISPLAY_SRC_FAULT:
+        if (value == 0) return 0;
+        fixq_segments((uint16_t)(100 + value % 100), 0x00, seg); // the 1 keeps the leading zero: E-03
+        seg[0] = GLYPH_E;
+        seg[1] = GLYPH_DASH;
+        return pack(seg);
+    default:
+        return 0;
+    }
+}
+
+void display_service_init(void)
+{
+    for (int i = 0; i < DISPLAY_SRC_COUNT; i++)
+    {
+        atomic_store(&s_word[i], 0);
+        atomic_store(&s_value[i], 0);
+        atomic_store(&s_seq[i], 0);
+        s_seen[i] = 0;
+        s_seen_seq[i] = 0;
+        s_held[i] = 0;
+        s_until_us[i] = 0;
+    }
+    atomic_store(&s_posts, 0);
+    atomic_store(&s_rotate_ms, 0);
+    atomic_store(&s_brightness, DISPLAY_BRIGHTNESS_INIT);
+    atomic_store(&s_blink, false);
+    s_shown_valid = false;
+    s_shown_ctrl = 0xff;
+    s_write_us = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+void display_service_post(display_src_t src, uint32_t value)
+{
+    if (src >= DISPLAY_SRC_COUNT) return;
+    atomic_store_explicit(&s_word[src], encode(src, value), memory_order_relaxed);
+    atomic_store_explicit(&s_value[src], value, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_seq[src], 1, memory_order_release);
+    atomic_fetch_add_explicit(&s_posts, 1, memory_order_relaxed);
+}
+
+void display_service_set_rotation(uint32_t page_ms)
+{
+    atomic_store_explicit(&s_rotate_ms, page_ms, memory_order_relaxed);
+}
+
+void display_service_set_brightness(uint8_t level)
+{
+    atomic_store_explicit(&s_brightness, level > DISPLAY_BRIGHTNESS_MAX ? DISPLAY_BRIGHTNESS_MAX : level, memory_order_relaxed);
+}
+
+void display_service_set_blink(bool on)
+{
+    atomic_store_explicit(&s_blink, on, memory_order_relaxed);
+}
+
+// Picks the page and whether it blinks; starts or ends overrides on changed values.
+static uint32_t compose(int64_t now, bool *blink)
+{
+    uint32_t words[DISPLAY_SRC_COUNT];
+    int top = -1;
+    for (int i = 0; i < DISPLAY_SRC_COUNT; i++)
+    {
+        uint32_t seq = atomic_load_explicit(&s_seq[i], memory_order_acquire);
+        words[i] = atomic_load_explicit(&s_word[i], memory_order_relaxed);
+        if (words[i] != s_seen[i] || (s_src_cfg[i].retrigger && seq != s_seen_seq[i]))
+        {
+            // a value wandering within min_change (ADC jitter) keeps the digits live
+            // but must not hold the page forever
+            uint32_t value = atomic_load_explicit(&s_value[i], memory_order_relaxed);
+            uint32_t moved = (value > s_held[i]) ? value - s_held[i] : s_held[i] - value;
+            bool restart = (words[i] == 0) || (moved >= s_src_cfg[i].min_change) || (s_seen[i] == 0);
+            s_seen[i] = words[i];
+            s_seen_seq[i] = seq;
+            if (restart)
+            {
+                s_held[i] = value;
+                s_until_us[i] = (words[i] != 0 && s_src_cfg[i].hold_ms) ? now + (int64_t)s_src_cfg[i].hold_ms * 1000 : 0;
+            }
+        }
+        if (now < s_until_us[i] && (top < 0 || s_src_cfg[i].prio > s_src_cfg[top].prio)) top = i;
+    }
+
+    uint8_t page = 0;
+    uint32_t rotate_ms = atomic_load_explicit(&s_rotate_ms, memory_order_relaxed);
+    if (top >= 0) page = s_src_cfg[top].page;
+    else if (rotate_ms) page = (uint8_t)((now / 1000 / rotate_ms) % DISPLAY_ROTATE_PAGES);
+    *blink = (top >= 0 && s_src_cfg[top].blink) || atomic_load_explicit(&s_blink, memory_order_relaxed);
+
+    uint32_t frame = 0;
+    for (int i = 0; i < DISPLAY_SRC_COUNT; i++)
+    {
+        if (s_src_cfg[i].page == page) frame |= words[i];
+    }
+    return frame;
+}
+
+void display_service_poll(int64_t now_us)
+{
+    if (s_shown_valid && now_us - s_write_us < (int64_t)DISPLAY_REFRESH_MS * 1000) return;
+
+    bool blink;
+    uint32_t frame = compose(now_us, &blink);
+    bool on = !blink || ((now_us / 1000 / DISPLAY_BLINK_MS) & 1) == 0;
+    uint8_t ctrl = (uint8_t)((on ? 0x08 : 0x00) | atomic_load_explicit(&s_brightness, memory_order_relaxed));
+    bool write_frame = !s_shown_valid || frame != s_shown_frame;
+    bool write_ctrl = ctrl != s_shown_ctrl;
+    if (!write_frame && !write_ctrl) return;
+
+    int64_t t0 = esp_timer_get_time();
+    if (write_frame)
+    {
+        const uint8_t seg[4] = {(uint8_t)frame, (uint8_t)(frame >> 8), (uint8_t)(frame >> 16), (uint8_t)(frame >> 24)};
+        display_write_segments(seg);
+        s_shown_frame = frame;
+        s_shown_valid = true;
+        s_stats.frames++;
+    }
+    if (write_ctrl)
+    {
+        display_set_control(on, ctrl & 0x07);
+        s_shown_ctrl = ctrl;
+        s_stats.controls++;
+    }
+    uint32_t bus_us = (uint32_t)(esp_timer_get_time() - t0);
+    if (bus_us > s_stats.bus_max_us) s_stats.bus_max_us = bus_us;
+    s_write_us = now_us;
+}
+
+void display_service_get_stats(display_stats_t *stats)
+{
+    *stats = s_stats;
+    stats->posts = atomic_load_explicit(&s_posts, memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+#ifndef _DISPLAY_SERVICE_H_
+#define _DISPLAY_SERVICE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Display service: the only user of the TM1637 bus. Producers post values per
+ * source; a post encodes the value through the segment pair table (fixq.c) into one
+ * 32-bit word and stores it atomically, O(1) from any task, no GPIO.
+ *
+ * display_service_poll() runs once per control tick after the control core and
+ * composes the frame: the page of the overriding source with the highest priority,
+ * else the rotation page. A source with a hold time overrides the rotation for that
+ * long each time its value changes (a fresh stroke time, a new fault); the speed
+ * source only restarts it for changes of 0.1 m/s or more, so pot jitter does not
+ * pin the speed page. Several sources can share a page when their digits do not
+ * overlap.
+ *
+ *   page 0  speed     2.345   m/s: set point until the first shot, then measured
+ *   page 1  stroke    t 86    last stroke time in ms
+ *   page 2  status    1. 42   state id, shots since boot
+ *   page 3  fault     E-03    core_event_t, blinking; not part of the rotation
+ *
+ * Bus writes are rate limited: at most one frame and one display control command
+ * per DISPLAY_REFRESH_MS, and only when they differ from what the chip shows. A frame
+ * takes about 1 ms of bit-banging, so the display never costs more than ~2% of the
+ * control task however often producers post. Blinking toggles the display-on bit,
+ * one byte per blink phase.
+ */
+
+#define DISPLAY_REFRESH_MS  50
+#define DISPLAY_BLINK_MS    250
+
+typedef enum
+{
+    DISPLAY_SRC_SPEED,      // mm/s, shown as m/s
+    DISPLAY_SRC_STROKE,     // last stroke time, ms
+    DISPLAY_SRC_STATE,      // system_state_t
+    DISPLAY_SRC_SHOTS,      // launches since boot, last 3 digits
+    DISPLAY_SRC_FAULT,      // core_event_t, 0 = none
+    DISPLAY_SRC_COUNT,
+} display_src_t;
+
+typedef struct
+{
+    uint32_t posts;         // values posted
+    uint32_t frames;        // frames written to the chip
+    uint32_t controls;      // brightness / on-off commands written
+    uint32_t bus_max_us;    // longest poll that wrote to the bus
+} display_stats_t;
+
+void display_service_init(void);   // after display_init(), before the first post
+void display_service_post(display_src_t src, uint32_t value);
+void display_service_set_rotation(uint32_t page_ms); // 0 = stay on the speed page
+void display_service_set_brightness(uint8_t level);  // 0-7
+void display_service_set_blink(bool on);             // blink the whole display, e.g. while locating the board
+void display_service_poll(int64_t now_us);
+void display_service_get_stats(display_stats_t *stats);
+
+#endif // !_DISPLAY_SERVICE_H_
@@ -0,0 +1,148 @@
+#include "fixq.h"
+
+// Segment glyphs of 0..9, and of every two-digit pair (tens in the high byte), so a
+// 4-digit number is two table reads
+#define SEG_0   0x3f
+#define SEG_1   0x06
+#define SEG_2   0x5b
+#define SEG_3   0x4f
+#define SEG_4   0x66
+#define SEG_5   0x6d
+#define SEG_6   0x7d
+#define SEG_7   0x07
+#define SEG_8   0x7f
+#define SEG_9   0x6f
+#define SEG_PAIR(t, u)  (uint16_t)((SEG_##t << 8) | SEG_##u)
+#define SEG_ROW(t)      SEG_PAIR(t, 0), SEG_PAIR(t, 1), SEG_PAIR(t, 2), SEG_PAIR(t, 3), SEG_PAIR(t, 4), \
+                        SEG_PAIR(t, 5), SEG_PAIR(t, 6), SEG_PAIR(t, 7), SEG_PAIR(t, 8), SEG_PAIR(t, 9)
+
+static const uint16_t s_segment_pairs[100] = {
+    SEG_ROW(0), SEG_ROW(1), SEG_ROW(2), SEG_ROW(3), SEG_ROW(4),
+    SEG_ROW(5), SEG_ROW(6), SEG_ROW(7), SEG_ROW(8), SEG_ROW(9),
+};
+
+#define FIXQ_SEG_DOT    0x80
+
+void fixq_map_init(fixq_map_t *map, int32_t in_lo, int32_t in_hi, int32_t out_lo, int32_t out_hi)
+{
+    map->in_lo = in_lo;
+    map->in_hi = in_hi;
+    map->out_lo = out_lo;
+    map->out_hi = out_hi;
+    int64_t span = (in_hi > in_lo) ? (in_hi - in_lo) : 1;
+    int64_t num = (int64_t)(out_hi - out_lo) * FIXQ_ONE;
+    // round half away from zero so the far end lands on out_hi
+    map->slope = (q16_t)((num + (num >= 0 ? span / 2 : -span / 2)) / span);
+}
+
+int32_t fixq_map(const fixq_map_t *map, int32_t x)
+{
+    if (x <= map->in_lo) return map->out_lo;
+    if (x >= map->in_hi) return map->out_hi;
+    int64_t d = (int64_t)(x - map->in_lo) * map->slope;
+    return map->out_lo + (int32_t)((d + (FIXQ_ONE >> 1)) >> FIXQ_SHIFT);
+}
+
+void fixq_lpf_init(fixq_lpf_t *lpf, uint8_t shift)
+{
+    lpf->y_q8 = 0;
+    lpf->shift = shift;
+    lpf->primed = false;
+}
+
+uint16_t fixq_lpf_update(fixq_lpf_t *lpf, uint16_t x)
+{
+    int32_t x_q8 = (int32_t)x << 8;
+    if (!lpf->primed)
+    {
+        lpf->y_q8 = x_q8; // start from the first sample instead of ramping up from 0
+        lpf->primed = true;
+    }
+    else
+    {
+        lpf->y_q8 += (x_q8 - lpf->y_q8) >> lpf->shift;
+    }
+    return (uint16_t)((lpf->y_q8 + 0x80) >> 8);
+}
+
+void fixq_joy_init(fixq_joy_t *joy, int32_t raw_max, int32_t dz_lo, int32_t dz_hi, int32_t duty_min, int32_t duty_max)
+{
+    joy->dz_lo = dz_lo;
+    joy->dz_hi = dz_hi;
+    fixq_map_init(&joy->low, 0, dz_lo, -duty_max, -duty_min);
+    fixq_map_init(&joy->high, dz_hi, raw_max, duty_min, duty_max);
+}
+
+int32_t fixq_joy_duty(const fixq_joy_t *joy, int32_t raw)
+{
+    if (raw < joy->dz_lo) return fixq_map(&joy->low, raw);
+    if (raw > joy->dz_hi) return fixq_map(&joy->high, raw);
+    return 0;
+}
+
+// Octant reduction plus atan(z) ~ 45 z + z (1 - z)(14.02 + 3.80 z) degrees for
+// z = min/max in [0, 1]; max error about 0.09 deg.
+int32_t fixq_atan2_mdeg(int32_t y, int32_t x)
+{
+    if (x == 0 && y == 0) return 0;
+    int64_t ax = (x < 0) ? -(int64_t)x : x;
+    int64_t ay = (y < 0) ? -(int64_t)y : y;
+    bool swap = ay > ax;
+    int64_t z = swap ? (ax << FIXQ_SHIFT) / ay : (ay << FIXQ_SHIFT) / ax;
+    int64_t zz = (z * (FIXQ_ONE - z)) >> FIXQ_SHIFT;
+    int64_t a = (45000 * z + zz * (14020 + ((3799 * z) >> FIXQ_SHIFT)) + (FIXQ_ONE >> 1)) >> FIXQ_SHIFT;
+    if (swap) a = 90000 - a;
+    if (x < 0) a = 180000 - a;
+    return (int32_t)((y < 0) ? -a : a);
+}
+
+void fixq_segments(uint16_t number, uint8_t dot_mask, uint8_t seg[4])
+{
+    if (number > 9999) number = 9999;
+    uint16_t hi = s_segment_pairs[number / 100];
+    uint16_t lo = s_segment_pairs[number % 100];
+    seg[0] = (uint8_t)(hi >> 8);
+    seg[1] = (uint8_t)hi;
+    seg[2] = (uint8_t)(lo >> 8);
+    seg[3] = (uint8_t)lo;
+
+    // leading zeros are blanked up to the units digit (the one with the point, or the last)
+    int units = 3;
+    for (int i = 0; i < 4; i++)
+    {
+        if (dot_mask & (0x08 >> i))
+        {
+            units = i;
+            break;
+        }
+    }
+    int blank = (number >= 1000) ? 0 : (number >= 100) ? 1 : (number >= 10) ? 2 : 3;
+    for (int i = 0; i < blank && i < units; i++) seg[i] = 0x00;
+    for (int i = 0; i < 4; i++)
+    {
+        if (dot_mask & (0x08 >> i)) seg[i] |= FIXQ_SEG_DOT;
+    }
+}
+
+void fixq_segments_milli(uint32_t milli, uint8_t seg[4])
+{
+    // range limits sit half a display step below the next decade, so rounding up
+    // moves to the next format instead of overflowing 4 digits
+    if (milli < 10000)
+    {
+        fixq_segments((uint16_t)milli, 0x08, seg);              // x.xxx
+    }
+    else if (milli < 99995)
+    {
+        fixq_segments((uint16_t)((milli + 5) / 10), 0x04, seg);   // xx.xx
+    }
+    else if (milli < 999950)
+    {
+        fixq_segments((uint16_t)((milli + 50) / 100), 0x02, seg); // xxx.x
+    }
+    else
+    {
+        uint32_t n = (milli + 500) / 1000;
+        fixq_segments((uint16_t)(n > 9999 ? 9999 : n), 0x00, seg); // xxxx
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef _FIXQ_H_
+#define _FIXQ_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Fixed-point helpers for the signal path from ADC counts to motor duty and the
+ * 7-segment display. Everything is integer only (no FPU), holds no hidden state and
+ * is safe to call from an ISR. Gains and slopes are Q16.16. The per-sample path
+ * divides only by constants, which compile to multiplies; the *_init functions and
+ * fixq_atan2_mdeg() do one real (64-bit) divide per call.
+ */
+
+#define FIXQ_SHIFT      16
+#define FIXQ_ONE        (1 << FIXQ_SHIFT)
+
+typedef int32_t q16_t;
+
+// Linear map from [in_lo, in_hi] to [out_lo, out_hi], clamped at both ends.
+typedef struct
+{
+    int32_t in_lo;
+    int32_t in_hi;
+    int32_t out_lo;
+    int32_t out_hi;
+    q16_t slope;
+} fixq_map_t;
+
+// First order low-pass: y += (x - y) / 2^shift, state kept in Q8 input units.
+typedef struct
+{
+    int32_t y_q8;
+    uint8_t shift;
+    bool primed;
+} fixq_lpf_t;
+
+void fixq_map_init(fixq_map_t *map, int32_t in_lo, int32_t in_hi, int32_t out_lo, int32_t out_hi);
+int32_t fixq_map(const fixq_map_t *map, int32_t x);
+
+void fixq_lpf_init(fixq_lpf_t *lpf, uint8_t shift);
+uint16_t fixq_lpf_update(fixq_lpf_t *lpf, uint16_t x);
+
+// Joystick axis to signed duty: 0 inside [dz_lo, dz_hi], duty_min..duty_max at the
+// deadzone edge .. the end of travel, negative below the deadzone.
+typedef struct
+{
+    int32_t dz_lo;
+    int32_t dz_hi;
+    fixq_map_t low;
+    fixq_map_t high;
+} fixq_joy_t;
+
+void fixq_joy_init(fixq_joy_t *joy, int32_t raw_max, int32_t dz_lo, int32_t dz_hi, int32_t duty_min, int32_t duty_max);
+int32_t fixq_joy_duty(const fixq_joy_t *joy, int32_t raw);
+
+// atan2(y, x) in millidegrees, -180000..180000.
+int32_t fixq_atan2_mdeg(int32_t y, int32_t x);
+
+// 4 TM1637 segment bytes for a value in thousandths (0 .. 9999499), with the decimal
+// point placed for the most digits: x.xxx, xx.xx, xxx.x or xxxx.
+void fixq_segments_milli(uint32_t milli, uint8_t seg[4]);
+// 4 segment bytes for number (0..9999) with decimal points from dot_mask (bit 3 = digit 0)
+void fixq_segments(uint16_t number, uint8_t dot_mask, uint8_t seg[4]);
+
+static inline q16_t fixq_mul(q16_t a, q16_t b)
+{
+    return (q16_t)(((int64_t)a * b + (FIXQ_ONE >> 1)) >> FIXQ_SHIFT);
+}
+
+#endif // !_FIXQ_H_
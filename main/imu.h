@@ -0,0 +1,51 @@
+#ifndef _IMU_H_
+#define _IMU_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * Inertial sensor for the aim platform. The sensor samples into its own FIFO at
+ * IMU_RATE_HZ and the reader empties it in one burst per control period, so no
+ * sample is lost when the reader runs late. Samples are raw sensor counts; the
+ * ranges below are fixed at init.
+ */
+
+#define IMU_RATE_HZ             1000
+#define IMU_GYRO_LSB_PER_DPS_X10 655    // +-500 dps range: 65.5 LSB per deg/s
+#define IMU_ACCEL_LSB_PER_G     8192    // +-4 g range
+
+// Gyro counts to millidegrees per second.
+#define IMU_GYRO_MDPS(raw)      ((int32_t)(raw) * 10000 / IMU_GYRO_LSB_PER_DPS_X10)
+
+typedef struct
+{
+    int16_t accel[3]; // x, y, z
+    int16_t gyro[3];  // about x (roll), y (pitch), z (yaw)
+} imu_sample_t;
+
+typedef struct
+{
+    const char *name;
+    esp_err_t (*init)(void);
+    int (*read_fifo)(imu_sample_t *out, int max); // samples read, < 0 on a bus error or FIFO overflow
+} imu_backend_t;
+
+extern const imu_backend_t imu_backend_mpu6050;
+extern const imu_backend_t imu_backend_sim;
+
+// Simulated IMU: true motion in, sensor counts out (noise and gyro bias added).
+typedef struct
+{
+    float rate_dps[3];  // body rates about x, y, z
+    float pitch_deg;    // tilt that the accelerometer sees
+} imu_sim_truth_t;
+
+void imu_sim_seed(uint32_t seed);
+void imu_sim_set_bias(const float bias_dps[3]);
+void imu_sim_encode(const imu_sim_truth_t *truth, imu_sample_t *out);
+void imu_sim_set_truth(const imu_sim_truth_t *truth); // what the sim backend reports
+
+#endif // !_IMU_H_
@@ -0,0 +1,123 @@
+#include "imu.h"
+#include "esp_log.h"
+#include "driver/i2c_master.h"
+
+static const char *TAG = "MPU6050";
+
+// The MPU6050 shares no pins with the rest of the board yet; like the angle
+// sensors these are placeholders for the next board revision.
+#define MPU6050_PORT            I2C_NUM_1
+#define MPU6050_SDA             GPIO_NUM_NC
+#define MPU6050_SCL             GPIO_NUM_NC
+#define MPU6050_ADDR            0x68
+#define MPU6050_SCL_HZ          400000
+
+#define MPU_REG_SMPLRT_DIV      0x19
+#define MPU_REG_CONFIG          0x1a
+#define MPU_REG_GYRO_CONFIG     0x1b
+#define MPU_REG_ACCEL_CONFIG    0x1c
+#define MPU_REG_FIFO_EN         0x23
+#define MPU_REG_USER_CTRL       0x6a
+#define MPU_REG_PWR_MGMT_1      0x6b
+#define MPU_REG_FIFO_COUNT_H    0x72
+#define MPU_REG_FIFO_R_W        0x74
+
+#define MPU_FIFO_SIZE           1024
+#define MPU_FRAME_SIZE          12      // accel xyz + gyro xyz, big endian
+#define MPU_BURST_MAX           8       // frames per bus transfer
+
+static i2c_master_dev_handle_t s_dev = NULL;
+
+static esp_err_t mpu_write(uint8_t reg, uint8_t val)
+{
+    uint8_t buf[2] = {reg, val};
+    return i2c_master_transmit(s_dev, buf, sizeof(buf), 10);
+}
+
+static esp_err_t mpu_read(uint8_t reg, uint8_t *buf, size_t len)
+{
+    return i2c_master_transmit_receive(s_dev, &reg, 1, buf, len, 10);
+}
+
+static void mpu_fifo_reset(void)
+{
+    mpu_write(MPU_REG_USER_CTRL, 0x04); // FIFO_RESET
+    mpu_write(MPU_REG_USER_CTRL, 0x40); // FIFO_EN
+}
+
+static esp_err_t mpu6050_init(void)
+{
+    if (MPU6050_SDA == GPIO_NUM_NC || MPU6050_SCL == GPIO_NUM_NC)
+    {
+        ESP_LOGW(TAG, "no I2C pins assigned");
+        return ESP_ERR_NOT_FOUND;
+    }
+    i2c_master_bus_config_t bus_cfg = {
+        .i2c_port = MPU6050_PORT,
+        .sda_io_num = MPU6050_SDA,
+        .scl_io_num = MPU6050_SCL,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    };
+    i2c_master_bus_handle_t bus;
+    ESP_ERROR_CHECK(i2c_new_master_bus(&bus_cfg, &bus));
+    i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = MPU6050_ADDR,
+        .scl_speed_hz = MPU6050_SCL_HZ,
+    };
+    ESP_ERROR_CHECK(i2c_master_bus_add_device(bus, &dev_cfg, &s_dev));
+
+    esp_err_t ret = mpu_write(MPU_REG_PWR_MGMT_1, 0x01);     // wake, clock from gyro X PLL
+    if (ret != ESP_OK) return ret;
+    mpu_write(MPU_REG_CONFIG, 0x03);        // DLPF 42/44 Hz, 1 kHz internal rate
+    mpu_write(MPU_REG_SMPLRT_DIV, 1000 / IMU_RATE_HZ - 1);
+    mpu_write(MPU_REG_GYRO_CONFIG, 0x08);   // +-500 dps
+    mpu_write(MPU_REG_ACCEL_CONFIG, 0x08);  // +-4 g
+    mpu_write(MPU_REG_FIFO_EN, 0x78);       // gyro xyz + accel
+    mpu_fifo_reset();
+    return ESP_OK;
+}
+
+static int mpu6050_read_fifo(imu_sample_t *out, int max)
+{
+    uint8_t cnt[2];
+    if (mpu_read(MPU_REG_FIFO_COUNT_H, cnt, sizeof(cnt)) != ESP_OK) return -1;
+    int count = (cnt[0] << 8) | cnt[1];
+    if (count > MPU_FIFO_SIZE - MPU_FRAME_SIZE)
+    {
+        // the FIFO wrapped and is no longer frame aligned
+        mpu_fifo_reset();
+        return -1;
+    }
+
+    int frames = count / MPU_FRAME_SIZE;
+    if (frames > max) frames = max;
+    int done = 0;
+    while (done < frames)
+    {
+        uint8_t buf[MPU_BURST_MAX * MPU_FRAME_SIZE];
+        int n = frames - done;
+        if (n > MPU_BURST_MAX) n = MPU_BURST_MAX;
+        if (mpu_read(MPU_REG_FIFO_R_W, buf, (size_t)n * MPU_FRAME_SIZE) != ESP_OK) return -1;
+        for (int f = 0; f < n; f++)
+        {
+            const uint8_t *p = buf + f * MPU_FRAME_SIZE;
+            imu_sample_t *s = &out[done + f];
+            for (int i = 0; i < 3; i++)
+            {
+                s->accel[i] = (int16_t)((p[2 * i] << 8) | p[2 * i + 1]);
+                s->gyro[i] = (int16_t)((p[6 + 2 * i] << 8) | p[7 + 2 * i]);
+            }
+        }
+        done += n;
+    }
+    return done;
+}
+
+const imu_backend_t imu_backend_mpu6050 = {
+    .name = "MPU6050 (I2C, FIFO)",
+    .init = mpu6050_init,
+    .read_fifo = mpu6050_read_fifo,
+};
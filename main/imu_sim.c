@@ -0,0 +1,88 @@
+#include "imu.h"
+#include <math.h>
+#include "esp_timer.h"
+#include "random_pattern.h"
+
+// Simulated IMU: converts true motion to sensor counts with the ranges of the
+// real part, plus white noise and a constant gyro bias.
+
+#define SIM_GYRO_NOISE_DPS      0.05f
+#define SIM_ACCEL_NOISE_G       0.004f
+#define SIM_DEG_TO_RAD          0.017453293f
+
+static random_pcg_t s_rng;
+static float s_bias_dps[3] = {0.3f, -0.2f, 0.15f};
+static imu_sim_truth_t s_truth;
+static int64_t s_next_us = 0;
+
+void imu_sim_seed(uint32_t seed)
+{
+    random_pcg_seed(&s_rng, seed);
+}
+
+void imu_sim_set_bias(const float bias_dps[3])
+{
+    for (int i = 0; i < 3; i++) s_bias_dps[i] = bias_dps[i];
+}
+
+// roughly normal, unit variance (Irwin-Hall with 4 draws)
+static float noise(void)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < 4; i++) sum += random_pcg_next(&s_rng) >> 16;
+    return ((float)sum / 65536.0f - 2.0f) * 1.7320508f;
+}
+
+static int16_t clamp16(float v)
+{
+    if (v > 32767.0f) return 32767;
+    if (v < -32768.0f) return -32768;
+    return (int16_t)lrintf(v);
+}
+
+void imu_sim_encode(const imu_sim_truth_t *truth, imu_sample_t *out)
+{
+    const float gyro_lsb = IMU_GYRO_LSB_PER_DPS_X10 / 10.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        float dps = truth->rate_dps[i] + s_bias_dps[i] + SIM_GYRO_NOISE_DPS * noise();
+        out->gyro[i] = clamp16(dps * gyro_lsb);
+    }
+    float p = truth->pitch_deg * SIM_DEG_TO_RAD;
+    out->accel[0] = clamp16((-sinf(p) + SIM_ACCEL_NOISE_G * noise()) * IMU_ACCEL_LSB_PER_G);
+    out->accel[1] = clamp16(SIM_ACCEL_NOISE_G * noise() * IMU_ACCEL_LSB_PER_G);
+    out->accel[2] = clamp16((cosf(p) + SIM_ACCEL_NOISE_G * noise()) * IMU_ACCEL_LSB_PER_G);
+}
+
+void imu_sim_set_truth(const imu_sim_truth_t *truth)
+{
+    s_truth = *truth;
+}
+
+static esp_err_t sim_init(void)
+{
+    random_pcg_seed(&s_rng, 1);
+    s_next_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
+// Hands out one sample per elapsed sample period, like the real FIFO.
+static int sim_read_fifo(imu_sample_t *out, int max)
+{
+    const int64_t period_us = 1000000 / IMU_RATE_HZ;
+    int64_t now = esp_timer_get_time();
+    int n = 0;
+    while (n < max && s_next_us <= now)
+    {
+        imu_sim_encode(&s_truth, &out[n++]);
+        s_next_us += period_us;
+    }
+    if (s_next_us <= now) s_next_us = now; // reader fell behind, drop the backlog
+    return n;
+}
+
+const imu_backend_t imu_backend_sim = {
+    .name = "simulated",
+    .init = sim_init,
+    .read_fifo = sim_read_fifo,
+};
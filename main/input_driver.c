@@ -72,6 +72,27 @@ uint8_t read_limitStop_IO_level(uint8_t limitStop_IO_num)
     return ESP_OK;
 }
 
+static gpio_num_t limitStop_IO_gpio(uint8_t limitStop_IO_num)
+{
+    static const gpio_num_t limitStop_IO[6] = {limitStop_IO1, limitStop_IO2, limitStop_IO3,
+                                               limitStop_IO4, limitStop_IO5, limitStop_IO6};
+    if (limitStop_IO_num < 1 || limitStop_IO_num > 6) return GPIO_NUM_NC;
+    return limitStop_IO[limitStop_IO_num - 1];
+}
+
+esp_err_t limitStop_IO_isr_add(uint8_t limitStop_IO_num, gpio_int_type_t intr_type, gpio_isr_t isr_handler, void *args)
+{
+    gpio_num_t gpio = limitStop_IO_gpio(limitStop_IO_num);
+    if (gpio == GPIO_NUM_NC) return ESP_ERR_INVALID_ARG;
+
+    // the ISR service may already be installed by another module
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err;
+
+    ESP_ERROR_CHECK(gpio_set_intr_type(gpio, intr_type));
+    return gpio_isr_handler_add(gpio, isr_handler, args);
+}
+
 uint8_t read_key_level(uint8_t key_num)
 {
     switch (key_num)
@@ -94,6 +115,119 @@ uint8_t read_key_level(uint8_t key_num)
     return ESP_OK;
 }
 
+// Edge timestamps captured in the GPIO ISR, collected by input_sample(). A stamp is
+// 64 bits, two stores on the Xtensa, so both sides hold s_edge_lock.
+static int64_t s_edge_us[INPUT_EDGE_COUNT] = {0};
+static portMUX_TYPE s_edge_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void IRAM_ATTR limitStop_edge_isr(void *arg)
+{
+    int edge = (int)(intptr_t)arg;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&s_edge_lock);
+    if (s_edge_us[edge] == 0) s_edge_us[edge] = now;
+    portEXIT_CRITICAL_ISR(&s_edge_lock);
+}
+
+esp_err_t input_edges_init(void)
+{
+    // switches are active low: release = rising edge, hit = falling edge
+    esp_err_t err = limitStop_IO_isr_add(1, GPIO_INTR_POSEDGE, limitStop_edge_isr, (void *)INPUT_EDGE_LIMIT1_RELEASE);
+    if (err == ESP_OK)
+    {
+        err = limitStop_IO_isr_add(2, GPIO_INTR_NEGEDGE, limitStop_edge_isr, (void *)INPUT_EDGE_LIMIT2_HIT);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to attach limit switch ISR: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+// Drain the ADC pool and latch GPIO levels and edge times into one frame.
+// ADC channels keep their previous value when no new conversion arrived.
+void input_sample(adc_continuous_handle_t adc_handle, input_frame_t *frame)
+{
+    static uint8_t result[ADC_READ_LEN] = {0};
+    uint32_t ret_num = 0;
+
+    frame->t_us = esp_timer_get_time();
+    adc_continuous_read(adc_handle, result, ADC_READ_LEN, &ret_num, 0);
+    for (int i = 0; i < ret_num; i += SOC_ADC_DIGI_RESULT_BYTES)
+    {
+        adc_digi_output_data_t *p = (void *)(&result[i]);
+        uint32_t chan = ADC_GET_CHANNEL(p);
+        uint16_t data = ADC_GET_DATA(p);
+
+        if (chan == ADC1_CHAN1) { frame->pot = data; }
+        else if (chan == ADC1_CHANx) { frame->joy_x = data; }
+        else if (chan == ADC1_CHANy) { frame->joy_y = data; }
+    }
+
+    uint16_t gpio = (ret_num > 0) ? INPUT_ADC_FRESH_BIT : 0;
+    for (uint8_t n = 1; n <= 6; n++)
+    {
+        if (read_limitStop_IO_level(n)) gpio |= INPUT_LIMIT_BIT(n);
+    }
+    for (uint8_t k = 1; k <= 4; k++)
+    {
+        if (read_key_level(k)) gpio |= INPUT_KEY_BIT(k);
+    }
+    frame->gpio = gpio;
+
+    // read and clear together: a stamp never tears and an edge in between is not lost
+    portENTER_CRITICAL(&s_edge_lock);
+    for (int i = 0; i < INPUT_EDGE_COUNT; i++)
+    {
+        frame->t_edge_us[i] = s_edge_us[i];
+        s_edge_us[i] = 0;
+    }
+    portEXIT_CRITICAL(&s_edge_lock);
+}
+
+static const gpio_num_t s_wake_gpio[] = {KEY1, KEY2, KEYX, KEYY, limitStop_IO3, limitStop_IO4, limitStop_IO5, limitStop_IO6};
+#define WAKE_GPIO_COUNT (sizeof(s_wake_gpio) / sizeof(s_wake_gpio[0]))
+static input_wake_cb_t s_wake_cb = NULL;
+static bool s_wake_isr_added = false;
+
+// level interrupts keep firing while the level holds: silence all wake pins at the first one
+static void IRAM_ATTR input_wake_isr(void *arg)
+{
+    for (int i = 0; i < WAKE_GPIO_COUNT; i++) gpio_intr_disable(s_wake_gpio[i]);
+    if (s_wake_cb) s_wake_cb();
+}
+
+esp_err_t input_wake_arm(input_wake_cb_t cb)
+{
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err;
+
+    s_wake_cb = cb;
+    for (int i = 0; i < WAKE_GPIO_COUNT; i++)
+    {
+        gpio_num_t gpio = s_wake_gpio[i];
+        if (!s_wake_isr_added)
+        {
+            err = gpio_isr_handler_add(gpio, input_wake_isr, NULL);
+            if (err != ESP_OK) return err;
+        }
+        err = gpio_wakeup_enable(gpio, gpio_get_level(gpio) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+        if (err != ESP_OK) return err;
+        gpio_intr_enable(gpio);
+    }
+    s_wake_isr_added = true;
+    return ESP_OK;
+}
+
+void input_wake_disarm(void)
+{
+    for (int i = 0; i < WAKE_GPIO_COUNT; i++)
+    {
+        gpio_wakeup_disable(s_wake_gpio[i]);
+        gpio_set_intr_type(s_wake_gpio[i], GPIO_INTR_DISABLE);
+    }
+}
+
 static TaskHandle_t s_task_handle;
 adc_channel_t adc_channel[4] = {ADC1_CHAN1, ADC1_CHAN2, ADC1_CHANx, ADC1_CHANy};
 bool  s_conv_done_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data)
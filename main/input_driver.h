@@ -10,6 +10,7 @@
 #include "freertos/task.h"
 #include "esp_timer.h"
 #include "esp_adc/adc_continuous.h"
+#include "input_frame.h"
 
 //ADC Definitions
 #define ADC1_CHAN1      ADC_CHANNEL_0 // GPIO36
@@ -28,9 +29,19 @@ extern adc_channel_t adc_channel[4];
 esp_err_t limitStop_IO_init(void);
 esp_err_t key_init(void);
 uint8_t read_limitStop_IO_level(uint8_t limitStop_IO_num);
+esp_err_t limitStop_IO_isr_add(uint8_t limitStop_IO_num, gpio_int_type_t intr_type, gpio_isr_t isr_handler, void *args);
 uint8_t read_key_level(uint8_t key_num);
 void continuous_adc_init(adc_channel_t *channel, uint8_t channel_num, adc_continuous_handle_t *out_handle);
 bool s_conv_done_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data);
+esp_err_t input_edges_init(void);
+void input_sample(adc_continuous_handle_t adc_handle, input_frame_t *frame);
+
+// Light-sleep wake: keys and limit switches 3-6 wake on the level opposite to the
+// current one; the callback runs in the ISR once, after which the pins are quiet
+// until the next arm. Limit switches 1/2 keep their edge ISRs and are not wake pins.
+typedef void (*input_wake_cb_t)(void);
+esp_err_t input_wake_arm(input_wake_cb_t cb);
+void input_wake_disarm(void);
 
 
 #endif // !_INPUT_DRIVER_H_
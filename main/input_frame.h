@@ -0,0 +1,68 @@
+#ifndef _INPUT_FRAME_H_
+#define _INPUT_FRAME_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * One sample of every input the control logic looks at. The runtime fills a frame
+ * once per control tick (from hardware, a recording or a simulation) and the control
+ * core only ever reads inputs from it, so a session can be replayed exactly.
+ */
+
+#define INPUT_LIMIT_BIT(n)      (1u << ((n) - 1))   // limit switch n (1..6), 1 = released
+#define INPUT_KEY_BIT(k)        (1u << ((k) + 7))   // key k (1..4), 1 = released
+#define INPUT_FAILSAFE_BIT      (1u << 13)          // remote link lost, brake and ignore commands
+#define INPUT_STAB_READY_BIT    (1u << 14)          // stabilizer running with a converged attitude
+#define INPUT_ADC_FRESH_BIT     (1u << 15)          // ADC values updated this tick
+#define INPUT_GPIO_IDLE         0x0f3fu             // all switches and keys released
+
+#define INPUT_EDGE_LIMIT1_RELEASE   0   // carriage left limit switch 1
+#define INPUT_EDGE_LIMIT2_HIT       1   // carriage reached limit switch 2
+#define INPUT_EDGE_COUNT            2
+
+#define INPUT_AIM_AXES      2       // motors 1 and 2
+
+#define INPUT_JOY_X_REST    1550    // joystick start-up values, inside the deadzone
+#define INPUT_JOY_Y_REST    1350
+
+typedef struct
+{
+    int64_t t_us;                           // sample time
+    uint16_t pot;                           // raw ADC counts (0-4095)
+    uint16_t joy_x;
+    uint16_t joy_y;
+    uint16_t gpio;                          // level bitmask, see INPUT_*_BIT
+    int64_t t_edge_us[INPUT_EDGE_COUNT];    // edge interrupt time since last frame, 0 = none
+    int8_t aim_pos[INPUT_AIM_AXES];         // aim axis position estimate, % of travel from the reverse end, -1 = unknown
+} input_frame_t;
+
+#define INPUT_FRAME_INIT    {.joy_x = INPUT_JOY_X_REST, .joy_y = INPUT_JOY_Y_REST, .gpio = INPUT_GPIO_IDLE, .aim_pos = {-1, -1}}
+
+static inline bool input_limit_hit(const input_frame_t *in, uint8_t n)
+{
+    return (in->gpio & INPUT_LIMIT_BIT(n)) == 0;
+}
+
+static inline bool input_key_down(const input_frame_t *in, uint8_t k)
+{
+    return (in->gpio & INPUT_KEY_BIT(k)) == 0;
+}
+
+static inline bool input_adc_fresh(const input_frame_t *in)
+{
+    return (in->gpio & INPUT_ADC_FRESH_BIT) != 0;
+}
+
+static inline bool input_failsafe(const input_frame_t *in)
+{
+    return (in->gpio & INPUT_FAILSAFE_BIT) != 0;
+}
+
+static inline bool input_stab_ready(const input_frame_t *in)
+{
+    return (in->gpio & INPUT_STAB_READY_BIT) != 0;
+}
+
+#endif // !_INPUT_FRAME_H_
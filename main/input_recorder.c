@@ -0,0 +1,227 @@
+#include "input_recorder.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "motor_control.h"
+#include "rec_log.h"
+
+static const char *TAG = "INPUT_REC";
+
+#define REC_PARTITION_SUBTYPE   0x40
+#define REC_PARTITION_LABEL     "reclog"
+#define REC_NVS_NAMESPACE       "rec"
+#define REC_RING_SIZE           8192    // about 12 s of frames at 50 Hz
+#define REC_FLUSH_CHUNK         1024
+#define REC_FLUSH_PERIOD_MS     200
+#define REC_SECTOR_SIZE         4096
+
+static uint8_t s_ring[REC_RING_SIZE];
+static size_t s_head = 0; // next byte to write
+static size_t s_tail = 0; // next byte to flush
+static portMUX_TYPE s_ring_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const esp_partition_t *s_part = NULL;
+static size_t s_base = 0;       // start of this session's half
+static size_t s_half_size = 0;
+static size_t s_wr = 0;         // write offset within the half
+static size_t s_erased = 0;     // bytes of the half erased so far
+static bool s_full = false;
+static uint32_t s_gap = 0;      // drops not yet marked in the log
+static int8_t s_aim_pos[INPUT_AIM_AXES] = {-1, -1}; // last REC_AIM written, as the reader starts
+static input_recorder_stats_t s_stats;
+
+static void rec_append(const uint8_t *data, size_t len)
+{
+    uint8_t gap[REC_MAX_SIZE];
+    size_t gap_len = 0;
+
+    taskENTER_CRITICAL(&s_ring_lock);
+    if (s_gap != 0)
+    {
+        gap_len = rec_log_put_gap(gap, s_gap);
+    }
+    size_t used = s_head - s_tail;
+    if (s_full || used + gap_len + len > REC_RING_SIZE)
+    {
+        s_gap++;
+        s_stats.dropped++;
+        taskEXIT_CRITICAL(&s_ring_lock);
+        return;
+    }
+    for (size_t i = 0; i < gap_len; i++)
+    {
+        s_ring[(s_head + i) % REC_RING_SIZE] = gap[i];
+    }
+    s_head += gap_len;
+    s_gap = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        s_ring[(s_head + i) % REC_RING_SIZE] = data[i];
+    }
+    s_head += len;
+    taskEXIT_CRITICAL(&s_ring_lock);
+}
+
+static void rec_motor_hook(const motor_cmd_t *cmd, void *arg)
+{
+    uint8_t rec[REC_MAX_SIZE];
+    size_t len = rec_log_put_motor(rec, cmd->motor, cmd->dir, (uint8_t)cmd->stop_mode, cmd->duty);
+    rec_append(rec, len);
+}
+
+static esp_err_t rec_flash_write(const uint8_t *data, size_t len)
+{
+    if (s_wr + len > s_half_size)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    while (s_wr + len > s_erased)
+    {
+        int64_t t0 = esp_timer_get_time();
+        esp_err_t err = esp_partition_erase_range(s_part, s_base + s_erased, REC_SECTOR_SIZE);
+        uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+        if (dt > s_stats.erase_max_us) s_stats.erase_max_us = dt;
+        if (err != ESP_OK) return err;
+        s_erased += REC_SECTOR_SIZE;
+    }
+    esp_err_t err = esp_partition_write(s_part, s_base + s_wr, data, len);
+    if (err == ESP_OK)
+    {
+        s_wr += len;
+        s_stats.bytes_written += len;
+    }
+    return err;
+}
+
+static void rec_flush_task(void *arg)
+{
+    static uint8_t chunk[REC_FLUSH_CHUNK];
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(REC_FLUSH_PERIOD_MS));
+
+        while (1)
+        {
+            taskENTER_CRITICAL(&s_ring_lock);
+            size_t len = s_head - s_tail;
+            if (len > REC_FLUSH_CHUNK) len = REC_FLUSH_CHUNK;
+            for (size_t i = 0; i < len; i++)
+            {
+                chunk[i] = s_ring[(s_tail + i) % REC_RING_SIZE];
+            }
+            s_tail += len;
+            taskEXIT_CRITICAL(&s_ring_lock);
+            if (len == 0) break;
+
+            esp_err_t err = rec_flash_write(chunk, len);
+            if (err != ESP_OK)
+            {
+                ESP_LOGW(TAG, "Recording stopped after %" PRIu32 " bytes: %s", s_stats.bytes_written, esp_err_to_name(err));
+                taskENTER_CRITICAL(&s_ring_lock);
+                s_full = true;
+                taskEXIT_CRITICAL(&s_ring_lock);
+                vTaskDelete(NULL);
+            }
+        }
+    }
+}
+
+static uint32_t rec_next_boot_count(void)
+{
+    uint32_t count = 0;
+    nvs_handle_t nvs;
+    if (nvs_open(REC_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK)
+    {
+        nvs_get_u32(nvs, "boot", &count);
+        count++;
+        nvs_set_u32(nvs, "boot", count);
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    return count;
+}
+
+esp_err_t input_recorder_init(void)
+{
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, REC_PARTITION_SUBTYPE, REC_PARTITION_LABEL);
+    if (s_part == NULL)
+    {
+        ESP_LOGW(TAG, "No '%s' partition, recording disabled", REC_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.boot_count = rec_next_boot_count();
+    s_half_size = (s_part->size / 2) & ~(size_t)(REC_SECTOR_SIZE - 1);
+    s_base = (s_stats.boot_count & 1) ? s_half_size : 0;
+
+    uint8_t hdr[REC_LOG_HDR_SIZE];
+    rec_append(hdr, rec_log_put_header(hdr, s_stats.boot_count));
+
+    if (xTaskCreate(rec_flush_task, "rec_flush", 3072, NULL, 2, NULL) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    motor_set_cmd_hook(rec_motor_hook, NULL);
+    ESP_LOGI(TAG, "Recording session %" PRIu32 " to %s +0x%x", s_stats.boot_count, REC_PARTITION_LABEL, (unsigned)s_base);
+    return ESP_OK;
+}
+
+// Travel times (and the duty they were measured at) loaded at boot, so a replay
+// starts homing from the same state.
+void input_recorder_boot(const uint32_t travel_us[4], const uint32_t travel_duty[2])
+{
+    if (s_part == NULL) return;
+    uint8_t rec[REC_MAX_SIZE];
+    rec_append(rec, rec_log_put_boot(rec, travel_us));
+    rec_append(rec, rec_log_put_duty(rec, travel_duty));
+}
+
+// Random mode seed, so a replay draws the same random patterns.
+void input_recorder_seed(uint32_t seed)
+{
+    if (s_part == NULL) return;
+    uint8_t rec[REC_MAX_SIZE];
+    rec_append(rec, rec_log_put_seed(rec, seed));
+}
+
+// Tuning parameter changed, recorded before the first frame it applies to.
+void input_recorder_param(uint8_t id, uint32_t value)
+{
+    if (s_part == NULL) return;
+    uint8_t rec[REC_MAX_SIZE];
+    rec_append(rec, rec_log_put_param(rec, id, value));
+}
+
+void input_recorder_frame(const input_frame_t *in)
+{
+    if (s_part == NULL) return;
+    uint8_t rec[3 * REC_MAX_SIZE];
+    size_t len = 0;
+    for (int i = 0; i < INPUT_EDGE_COUNT; i++)
+    {
+        if (in->t_edge_us[i] != 0)
+        {
+            len += rec_log_put_edge(rec + len, (uint8_t)i, in->t_edge_us[i]);
+        }
+    }
+    // aim positions change slowly (1 % steps), only write them when they do
+    if (memcmp(s_aim_pos, in->aim_pos, sizeof(s_aim_pos)) != 0)
+    {
+        memcpy(s_aim_pos, in->aim_pos, sizeof(s_aim_pos));
+        len += rec_log_put_aim(rec + len, in->aim_pos);
+    }
+    len += rec_log_put_input(rec + len, in);
+    rec_append(rec, len);
+}
+
+void input_recorder_get_stats(input_recorder_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_ring_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_ring_lock);
+}
@@ -0,0 +1,42 @@
+#ifndef _INPUT_RECORDER_H_
+#define _INPUT_RECORDER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "input_frame.h"
+
+/*
+ * Session recorder: every input frame, the limit-switch edge times and each motor
+ * command are encoded (rec_log.h) into a RAM ring, and a low-priority task drains
+ * the ring into the "reclog" data partition. The partition is split in two halves
+ * used alternately per boot, so the previous session survives a reset.
+ *
+ * Each 4 KB flash sector is erased when the writer first reaches it. While a sector
+ * erase runs (~40 ms on the ESP32) code executing from flash on both cores is held
+ * off, which delays the control tick and esp_timer callbacks; at the normal record
+ * rate this happens about once every 6 seconds. If the ring overflows, records are
+ * dropped and a REC_GAP record marks the spot. Because of these stalls the recorder
+ * is off by default (INPUT_RECORD_ENABLE in app_runtime.h); turn it on for capture
+ * sessions, not for normal operation.
+ *
+ * Read a recording back with:
+ *   parttool.py read_partition --partition-name reclog --output reclog.bin
+ */
+
+typedef struct
+{
+    uint32_t boot_count;
+    uint32_t bytes_written;   // bytes committed to flash this session
+    uint32_t dropped;         // records lost to a full ring or a full partition half
+    uint32_t erase_max_us;    // longest sector erase seen
+} input_recorder_stats_t;
+
+esp_err_t input_recorder_init(void);
+void input_recorder_boot(const uint32_t travel_us[4], const uint32_t travel_duty[2]);
+void input_recorder_seed(uint32_t seed);
+void input_recorder_param(uint8_t id, uint32_t value); // tune_param_t
+void input_recorder_frame(const input_frame_t *in);
+void input_recorder_get_stats(input_recorder_stats_t *stats);
+
+#endif // !_INPUT_RECORDER_H_
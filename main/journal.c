@@ -0,0 +1,374 @@
+#include "journal.h"
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "control_core.h"
+#include "core_event.h"
+
+static const char *TAG = "JOURNAL";
+
+#define JOURNAL_PARTITION_SUBTYPE   0x41
+#define JOURNAL_PARTITION_LABEL     "journal"
+#define JOURNAL_SECTOR_SIZE         4096
+#define JOURNAL_SECTOR_SLOTS        (JOURNAL_SECTOR_SIZE / JOURNAL_REC_SIZE)
+#define JOURNAL_SEQ_ERASED          0xffffffffu
+#define JOURNAL_PENDING             32      // records between two flushes
+#define JOURNAL_PENDING_MAGIC       0x4a524e31u // "JRN1"
+#define JOURNAL_BATCH               16      // records per flash write
+#define JOURNAL_BOOT_DUMP           8       // records logged at boot
+#define JOURNAL_DUMP_MAX            256
+
+_Static_assert(sizeof(journal_rec_t) == JOURNAL_REC_SIZE, "journal record layout");
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t head;      // next record to log (free running)
+    uint32_t tail;      // next record to flush
+    uint32_t dropped;   // lost to a full ring, not yet marked with JOURNAL_DROP
+    journal_rec_t rec[JOURNAL_PENDING];
+} journal_pending_t;
+
+// not cleared by software, panic or watchdog resets: journal_init() flushes what is left
+static RTC_NOINIT_ATTR journal_pending_t s_pend;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t s_flush_lock = NULL;
+static bool s_ready = false;
+
+static const esp_partition_t *s_part = NULL;
+static const journal_rec_t *s_map = NULL; // memory-mapped partition
+static uint32_t s_capacity = 0;           // slots in the partition
+static uint32_t s_wr = 0;                 // next slot to write
+static uint32_t s_seq = 0;                // sequence number of that slot
+static journal_stats_t s_stats;
+
+static uint16_t rec_crc(const journal_rec_t *rec)
+{
+    journal_rec_t r = *rec;
+    r.crc = 0;
+    const uint8_t *p = (const uint8_t *)&r;
+    uint16_t crc = 0xffff;
+    for (size_t i = 0; i < sizeof(r); i++)
+    {
+        crc ^= (uint16_t)p[i] << 8;
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+static bool rec_erased(const journal_rec_t *rec)
+{
+    const uint32_t *w = (const uint32_t *)rec;
+    for (size_t i = 0; i < JOURNAL_REC_SIZE / 4; i++)
+    {
+        if (w[i] != 0xffffffffu) return false;
+    }
+    return true;
+}
+
+static bool rec_valid(const journal_rec_t *rec)
+{
+    return rec->seq != JOURNAL_SEQ_ERASED && rec->type >= JOURNAL_BOOT && rec->type <= JOURNAL_DROP &&
+           rec->crc == rec_crc(rec);
+}
+
+//================================================================================
+// Pending ring (RTC memory)
+//================================================================================
+static bool pending_push_locked(journal_type_t type, uint8_t code, uint32_t a, uint32_t b, uint32_t c)
+{
+    if (s_pend.head - s_pend.tail >= JOURNAL_PENDING) return false;
+    journal_rec_t *rec = &s_pend.rec[s_pend.head % JOURNAL_PENDING];
+    rec->seq = 0;
+    rec->boot = s_stats.boot;
+    rec->t_us = esp_timer_get_time();
+    rec->type = (uint8_t)type;
+    rec->code = code;
+    rec->arg[0] = a;
+    rec->arg[1] = b;
+    rec->arg[2] = c;
+    rec->crc = rec_crc(rec);
+    s_pend.head++;
+    return true;
+}
+
+void journal_log(journal_type_t type, uint8_t code, uint32_t a, uint32_t b, uint32_t c)
+{
+    if (!s_ready) return;
+    taskENTER_CRITICAL(&s_lock);
+    if (!pending_push_locked(type, code, a, b, c))
+    {
+        s_pend.dropped++;
+        s_stats.dropped++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+// Copies up to max pending records, oldest first; the drop marker goes in first.
+static size_t pending_peek(journal_rec_t *out, size_t max)
+{
+    taskENTER_CRITICAL(&s_lock);
+    if (s_pend.dropped != 0 && pending_push_locked(JOURNAL_DROP, 0, s_pend.dropped, 0, 0)) s_pend.dropped = 0;
+    size_t n = s_pend.head - s_pend.tail;
+    if (n > max) n = max;
+    for (size_t i = 0; i < n; i++) out[i] = s_pend.rec[(s_pend.tail + i) % JOURNAL_PENDING];
+    taskEXIT_CRITICAL(&s_lock);
+    return n;
+}
+
+static void pending_pop(size_t n)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_pend.tail += n;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+// Keeps the intact records a previous session left; returns how many.
+static uint32_t pending_recover(void)
+{
+    if (s_pend.magic != JOURNAL_PENDING_MAGIC || s_pend.head - s_pend.tail > JOURNAL_PENDING)
+    {
+        memset(&s_pend, 0, sizeof(s_pend));
+        s_pend.magic = JOURNAL_PENDING_MAGIC;
+        return 0;
+    }
+    uint32_t kept = 0;
+    for (uint32_t i = s_pend.tail; i != s_pend.head; i++)
+    {
+        const journal_rec_t *rec = &s_pend.rec[i % JOURNAL_PENDING];
+        if (rec->crc == rec_crc(rec)) s_pend.rec[(s_pend.tail + kept++) % JOURNAL_PENDING] = *rec;
+    }
+    s_pend.head = s_pend.tail + kept;
+    return kept;
+}
+
+//================================================================================
+// Flash ring
+//================================================================================
+esp_err_t journal_flush(void)
+{
+    if (s_part == NULL) return ESP_ERR_INVALID_STATE;
+    xSemaphoreTake(s_flush_lock, portMAX_DELAY);
+    int64_t t0 = esp_timer_get_time();
+    bool wrote = false;
+    esp_err_t err = ESP_OK;
+    while (err == ESP_OK)
+    {
+        // one batch never crosses a sector boundary, the next sector is erased first
+        static journal_rec_t batch[JOURNAL_BATCH];
+        size_t room = JOURNAL_SECTOR_SLOTS - s_wr % JOURNAL_SECTOR_SLOTS;
+        size_t n = pending_peek(batch, (room < JOURNAL_BATCH) ? room : JOURNAL_BATCH);
+        if (n == 0) break;
+
+        if (s_wr % JOURNAL_SECTOR_SLOTS == 0)
+        {
+            err = esp_partition_erase_range(s_part, s_wr * JOURNAL_REC_SIZE, JOURNAL_SECTOR_SIZE);
+            if (err != ESP_OK) break;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            batch[i].seq = s_seq + i;
+            batch[i].crc = rec_crc(&batch[i]);
+        }
+        err = esp_partition_write(s_part, s_wr * JOURNAL_REC_SIZE, batch, n * JOURNAL_REC_SIZE);
+        if (err != ESP_OK) break;
+        pending_pop(n);
+        s_wr = (s_wr + n) % s_capacity;
+        s_seq += n;
+        s_stats.written += n;
+        wrote = true;
+    }
+    uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+    if (wrote && dt > s_stats.flush_max_us) s_stats.flush_max_us = dt;
+    xSemaphoreGive(s_flush_lock);
+    if (err != ESP_OK) ESP_LOGW(TAG, "Flush failed at slot %" PRIu32 ": %s", s_wr, esp_err_to_name(err));
+    return err;
+}
+
+size_t journal_read_last(journal_rec_t *out, size_t n)
+{
+    if (s_map == NULL) return 0;
+    xSemaphoreTake(s_flush_lock, portMAX_DELAY);
+    uint32_t slot = s_wr, seq = s_seq;
+    size_t count = 0;
+    // walk back slot by slot; a slot that is not the expected sequence (torn write) is skipped
+    for (uint32_t i = 0; i < s_capacity && count < n; i++)
+    {
+        slot = (slot + s_capacity - 1) % s_capacity;
+        seq--;
+        const journal_rec_t *rec = &s_map[slot];
+        if (rec_erased(rec)) break;
+        if (rec_valid(rec) && rec->seq == seq) out[count++] = *rec;
+    }
+    xSemaphoreGive(s_flush_lock);
+    return count;
+}
+
+// Newest sector by the sequence number of its first record, then the first erased slot in it.
+static void find_write_position(void)
+{
+    uint32_t sectors = s_capacity / JOURNAL_SECTOR_SLOTS;
+    bool found = false;
+    uint32_t newest = 0, newest_seq = 0;
+    for (uint32_t s = 0; s < sectors; s++)
+    {
+        const journal_rec_t *rec = &s_map[s * JOURNAL_SECTOR_SLOTS];
+        if (!rec_valid(rec)) continue;
+        if (!found || (int32_t)(rec->seq - newest_seq) > 0)
+        {
+            found = true;
+            newest = s;
+            newest_seq = rec->seq;
+        }
+    }
+    if (!found)
+    {
+        s_wr = 0;
+        s_seq = 0;
+        return;
+    }
+    const journal_rec_t *base = &s_map[newest * JOURNAL_SECTOR_SLOTS];
+    uint32_t lo = 1, hi = JOURNAL_SECTOR_SLOTS; // slot 0 is in use, find the first erased one
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        if (rec_erased(&base[mid])) hi = mid;
+        else lo = mid + 1;
+    }
+    s_wr = (newest * JOURNAL_SECTOR_SLOTS + lo) % s_capacity;
+    s_seq = newest_seq + lo;
+}
+
+//================================================================================
+// Printing
+//================================================================================
+static const char *reset_name(uint32_t reason)
+{
+    switch (reason)
+    {
+    case ESP_RST_POWERON:   return "power-on";
+    case ESP_RST_EXT:       return "external pin";
+    case ESP_RST_SW:        return "software";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:   return "interrupt watchdog";
+    case ESP_RST_TASK_WDT:  return "task watchdog";
+    case ESP_RST_WDT:       return "watchdog";
+    case ESP_RST_DEEPSLEEP: return "deep sleep";
+    case ESP_RST_BROWNOUT:  return "brown-out";
+    default:                return "unknown";
+    }
+}
+
+static const char *state_name(uint32_t state)
+{
+    static const char *const names[] = {"IDLE", "MANUAL_AIM", "HOMING", "STABILIZE"};
+    return (state < sizeof(names) / sizeof(names[0])) ? names[state] : "?";
+}
+
+static void rec_log_line(const journal_rec_t *rec)
+{
+    char text[80];
+    const uint32_t *a = rec->arg;
+    switch (rec->type)
+    {
+    case JOURNAL_BOOT:
+        snprintf(text, sizeof(text), "boot, reset by %s, %" PRIu32 " records recovered", reset_name(rec->code), a[0]);
+        break;
+    case JOURNAL_CORE:
+        if (rec->code == CORE_EVT_STATE)
+        {
+            snprintf(text, sizeof(text), "state %s -> %s", state_name(a[0]), state_name(a[1]));
+            break;
+        }
+        snprintf(text, sizeof(text), "%s %" PRIu32 " %" PRIu32 " in %s", core_event_name((core_event_t)rec->code), a[0], a[1],
+                 state_name(a[2]));
+        break;
+    case JOURNAL_LIMIT:
+        snprintf(text, sizeof(text), "limit switches %u and %u both closed, gpio 0x%04" PRIx32 " in %s", rec->code,
+                 rec->code + 1, a[0], state_name(a[1]));
+        break;
+    case JOURNAL_DROP:
+        snprintf(text, sizeof(text), "%" PRIu32 " records dropped", a[0]);
+        break;
+    default:
+        snprintf(text, sizeof(text), "type %u code %u", rec->type, rec->code);
+        break;
+    }
+    ESP_LOGI(TAG, "#%" PRIu32 " boot %" PRIu32 " +%" PRIu32 ".%03" PRIu32 " s: %s", rec->seq, rec->boot,
+             (uint32_t)(rec->t_us / 1000000), (uint32_t)(rec->t_us / 1000 % 1000), text);
+}
+
+void journal_dump(size_t n)
+{
+    if (n > JOURNAL_DUMP_MAX) n = JOURNAL_DUMP_MAX;
+    journal_rec_t *recs = malloc(n * sizeof(journal_rec_t));
+    if (recs == NULL) return;
+    size_t count = journal_read_last(recs, n);
+    ESP_LOGI(TAG, "last %u of %" PRIu32 " records:", (unsigned)count, s_capacity);
+    while (count > 0) rec_log_line(&recs[--count]);
+    free(recs);
+}
+
+//================================================================================
+// Init
+//================================================================================
+esp_err_t journal_init(void)
+{
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, JOURNAL_PARTITION_SUBTYPE, JOURNAL_PARTITION_LABEL);
+    if (s_part == NULL || s_part->size < 2 * JOURNAL_SECTOR_SIZE)
+    {
+        ESP_LOGW(TAG, "No '%s' partition, journal disabled", JOURNAL_PARTITION_LABEL);
+        s_part = NULL;
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_capacity = (s_part->size / JOURNAL_SECTOR_SIZE) * JOURNAL_SECTOR_SLOTS;
+    const void *map = NULL;
+    esp_partition_mmap_handle_t map_handle;
+    esp_err_t err = esp_partition_mmap(s_part, 0, s_capacity * JOURNAL_REC_SIZE, ESP_PARTITION_MMAP_DATA, &map, &map_handle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Cannot map '%s': %s, journal disabled", JOURNAL_PARTITION_LABEL, esp_err_to_name(err));
+        s_part = NULL;
+        return err;
+    }
+    s_map = (const journal_rec_t *)map;
+    s_flush_lock = xSemaphoreCreateMutex();
+    find_write_position();
+
+    // boot number follows the newest record, in flash or left over in RTC memory
+    memset(&s_stats, 0, sizeof(s_stats));
+    journal_rec_t last;
+    uint32_t boot = (journal_read_last(&last, 1) == 1) ? last.boot + 1 : 0;
+    uint32_t recovered = pending_recover();
+    for (uint32_t i = s_pend.tail; i != s_pend.head; i++)
+    {
+        uint32_t b = s_pend.rec[i % JOURNAL_PENDING].boot;
+        if ((int32_t)(b + 1 - boot) > 0) boot = b + 1;
+    }
+    s_stats.boot = boot;
+    s_stats.capacity = s_capacity;
+    s_ready = true;
+
+    journal_log(JOURNAL_BOOT, (uint8_t)esp_reset_reason(), recovered, 0, 0);
+    journal_flush(); // the control loop is not running yet
+    ESP_LOGI(TAG, "Boot %" PRIu32 ", journal at slot %" PRIu32 " of %" PRIu32, boot, s_wr, s_capacity);
+    journal_dump(JOURNAL_BOOT_DUMP);
+    return ESP_OK;
+}
+
+void journal_get_stats(journal_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    stats->pending = s_ready ? s_pend.head - s_pend.tail : 0;
+    taskEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,71 @@
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/*
+ * Persistent fault and event journal in the "journal" data partition, so the
+ * evidence of a hung launch or a stalled axis survives a reset: state transitions
+ * and faults of the control core (core_event.h), limit switch anomalies and the
+ * reset reason of every boot (brown-out, panic, watchdog).
+ *
+ * journal_log() only copies a record into a small pending ring in RTC memory, a few
+ * microseconds from any task. That memory is not cleared by software, panic or
+ * watchdog resets, so journal_init() still writes what a crashed session left behind.
+ *
+ * Flash is touched only by journal_flush(). While an erase or write runs, code
+ * executing from flash is held off on both cores (a sector erase takes ~40 ms), so
+ * the runtime calls it only where that cannot hurt: at boot before the control loop
+ * starts, and when the loop is idle and about to sleep. Pending records go out in
+ * batches of contiguous slots, one write per batch. If the ring fills up in between,
+ * new records are counted and a JOURNAL_DROP record marks the spot.
+ *
+ * The partition is a ring of 4 KB sectors holding 128 records each. The writer erases
+ * a sector when it reaches it, discarding its oldest records, so every sector is
+ * erased once per pass through the partition. At boot the write position is found
+ * from the first record of each sector plus a binary search in the newest one.
+ * Reads go through a memory mapping of the partition and never stop the cache.
+ */
+
+#define JOURNAL_REC_SIZE    32
+
+typedef enum
+{
+    JOURNAL_BOOT = 1,   // code = esp_reset_reason_t, a = records recovered from RTC memory
+    JOURNAL_CORE,       // code = core_event_t, a/b = event arguments, c = system state
+    JOURNAL_LIMIT,      // both switches of a pair closed: code = lower switch (1, 3, 5), a = gpio, b = state
+    JOURNAL_DROP,       // a = records lost to a full pending ring
+} journal_type_t;
+
+typedef struct
+{
+    uint32_t seq;       // position in the journal; 0xffffffff = erased slot
+    uint32_t boot;      // boot number, counted by the journal
+    int64_t t_us;       // time since that boot
+    uint8_t type;       // journal_type_t
+    uint8_t code;
+    uint16_t crc;       // CRC16 of the record with this field zero
+    uint32_t arg[3];
+} journal_rec_t;
+
+typedef struct
+{
+    uint32_t boot;
+    uint32_t capacity;      // records the partition holds
+    uint32_t pending;       // waiting for the next flush
+    uint32_t written;       // records written since boot
+    uint32_t dropped;       // records lost to a full pending ring since boot
+    uint32_t flush_max_us;  // longest flush (erase and write)
+} journal_stats_t;
+
+esp_err_t journal_init(void);   // finds the write position, writes the boot record and recovered ones
+void journal_log(journal_type_t type, uint8_t code, uint32_t a, uint32_t b, uint32_t c);
+esp_err_t journal_flush(void);  // only where a flash stall of tens of ms does no harm
+size_t journal_read_last(journal_rec_t *out, size_t n); // newest first, returns the count
+void journal_dump(size_t n);    // logs the last n records, oldest first
+void journal_get_stats(journal_stats_t *stats);
+
+#endif // !_JOURNAL_H_
@@ -0,0 +1,356 @@
+#include "joy_cal.h"
+#include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+#include "fixq.h"
+#include "input_frame.h"
+
+static const char *TAG = "JOY_CAL";
+
+#define JOY_CAL_NVS_NAMESPACE   "joycal"
+#define JOY_CAL_ADC_MAX         4095
+#define JOY_CAL_NOISE_DEFAULT   42      // with the margin: the fixed +-50 deadzone used before calibration
+#define JOY_CAL_REST_SPREAD_MAX 64      // larger spread at boot: the stick was moving
+#define JOY_CAL_REST_OFFSET_MAX 300     // largest accepted move from the stored center
+#define JOY_CAL_DRIFT_SHIFT     10      // center follows rest readings with a ~20 s time constant
+#define JOY_CAL_SWEEP_TRAVEL    300     // each end stop at least this far outside the deadzone
+#define JOY_CAL_EXTENT_TRIM     16      // full scale a little before the end stop
+
+typedef struct
+{
+    joy_cal_axis_t cal;
+    uint16_t anchor;        // center the drift is limited around
+    int32_t center_q16;
+    uint16_t half;          // raw half deadzone
+    uint16_t out_rest;      // calibrated scale: deadzone middle and edges
+    uint16_t out_lo;
+    uint16_t out_hi;
+    fixq_map_t low;
+    fixq_map_t high;
+    uint16_t out;           // last calibrated value, held while the ADC is not fresh
+    // boot rest measurement
+    uint32_t rest_sum;
+    uint16_t rest_min;
+    uint16_t rest_max;
+    // extents sweep
+    uint16_t sweep_min;
+    uint16_t sweep_max;
+} axis_state_t;
+
+static const joy_cal_t s_default = {
+    .axis = {
+        {.center = INPUT_JOY_X_REST, .noise = JOY_CAL_NOISE_DEFAULT, .min = 0, .max = JOY_CAL_ADC_MAX},
+        {.center = INPUT_JOY_Y_REST, .noise = JOY_CAL_NOISE_DEFAULT, .min = 0, .max = JOY_CAL_ADC_MAX},
+    },
+};
+
+// sampling task only
+static axis_state_t s_axis[2];
+static uint16_t s_rest_count = 0;
+static bool s_sweeping = false;
+static int64_t s_sweep_end_us = 0;
+
+// handed between tasks
+static _Atomic uint64_t s_published[2];     // joy_cal_axis_t packed, see pack()
+static atomic_uint s_dz_seq;                // odd while joy_cal_set_deadzone() writes
+static atomic_uint s_dz_edges[2];           // lo | hi << 16
+static atomic_uint s_sweep_req_ms;
+static atomic_uint s_sweep_done;
+static atomic_bool s_sweep_ok;
+
+static uint64_t pack(const joy_cal_axis_t *c)
+{
+    return c->center | ((uint64_t)c->noise << 16) | ((uint64_t)c->min << 32) | ((uint64_t)c->max << 48);
+}
+
+static joy_cal_axis_t unpack(uint64_t v)
+{
+    return (joy_cal_axis_t){(uint16_t)v, (uint16_t)(v >> 16), (uint16_t)(v >> 32), (uint16_t)(v >> 48)};
+}
+
+static bool axis_valid(const joy_cal_axis_t *c)
+{
+    uint32_t half = c->noise + JOY_CAL_DZ_MARGIN;
+    return c->max <= JOY_CAL_ADC_MAX && c->min + half < c->center && c->center + half < c->max;
+}
+
+// Recompute the maps after the center, noise, extents or deadzone changed (divides).
+static void axis_rebuild(axis_state_t *a)
+{
+    uint32_t half = a->cal.noise + JOY_CAL_DZ_MARGIN;
+    a->half = (uint16_t)((half < JOY_CAL_DZ_MIN) ? JOY_CAL_DZ_MIN : half);
+    int32_t c = a->cal.center;
+    int32_t lo = (a->out_lo > 0) ? a->out_lo - 1 : 0;
+    int32_t hi = (a->out_hi < JOY_CAL_ADC_MAX) ? a->out_hi + 1 : JOY_CAL_ADC_MAX;
+    fixq_map_init(&a->low, a->cal.min, c - a->half - 1, 0, lo);
+    fixq_map_init(&a->high, c + a->half + 1, a->cal.max, hi, JOY_CAL_ADC_MAX);
+}
+
+static void axis_publish(int i)
+{
+    atomic_store_explicit(&s_published[i], pack(&s_axis[i].cal), memory_order_relaxed);
+}
+
+static void axis_set(int i, const joy_cal_axis_t *cal)
+{
+    axis_state_t *a = &s_axis[i];
+    a->cal = *cal;
+    a->anchor = cal->center;
+    a->center_q16 = (int32_t)cal->center << 16;
+    axis_rebuild(a);
+    axis_publish(i);
+}
+
+void joy_cal_init(const joy_cal_t *stored)
+{
+    if (stored == NULL) stored = &s_default;
+    uint32_t lo[2], hi[2];
+    for (int i = 0; i < 2; i++)
+    {
+        axis_state_t *a = &s_axis[i];
+        memset(a, 0, sizeof(*a));
+        lo[i] = s_default.axis[i].center - 50;
+        hi[i] = s_default.axis[i].center + 50;
+        a->out_lo = (uint16_t)lo[i];
+        a->out_hi = (uint16_t)hi[i];
+        a->out_rest = (uint16_t)((lo[i] + hi[i]) / 2);
+        a->out = a->out_rest;
+        a->rest_min = UINT16_MAX;
+        axis_set(i, axis_valid(&stored->axis[i]) ? &stored->axis[i] : &s_default.axis[i]);
+    }
+    joy_cal_set_deadzone(lo, hi);
+    s_rest_count = 0;
+    s_sweeping = false;
+}
+
+void joy_cal_set_deadzone(const uint32_t dz_lo[2], const uint32_t dz_hi[2])
+{
+    atomic_fetch_add(&s_dz_seq, 1);
+    for (int i = 0; i < 2; i++) atomic_store(&s_dz_edges[i], (dz_lo[i] & 0xffffu) | (dz_hi[i] << 16));
+    atomic_fetch_add(&s_dz_seq, 1);
+}
+
+// Picks up a new control deadzone (seqlock, retried next tick if torn).
+static void follow_deadzone(void)
+{
+    static unsigned seen = 0;
+    unsigned seq = atomic_load(&s_dz_seq);
+    if (seq == seen || (seq & 1u)) return;
+    unsigned e[2] = {atomic_load(&s_dz_edges[0]), atomic_load(&s_dz_edges[1])};
+    if (atomic_load(&s_dz_seq) != seq) return;
+    seen = seq;
+    for (int i = 0; i < 2; i++)
+    {
+        axis_state_t *a = &s_axis[i];
+        a->out_lo = (uint16_t)e[i];
+        a->out_hi = (uint16_t)(e[i] >> 16);
+        a->out_rest = (uint16_t)((a->out_lo + a->out_hi) / 2);
+        axis_rebuild(a);
+    }
+}
+
+static void rest_sample(axis_state_t *a, uint16_t raw)
+{
+    a->rest_sum += raw;
+    if (raw < a->rest_min) a->rest_min = raw;
+    if (raw > a->rest_max) a->rest_max = raw;
+}
+
+static void rest_finish(int i)
+{
+    axis_state_t *a = &s_axis[i];
+    uint16_t mean = (uint16_t)((a->rest_sum + JOY_CAL_REST_SAMPLES / 2) / JOY_CAL_REST_SAMPLES);
+    uint16_t spread = a->rest_max - a->rest_min;
+    int offset = (int)mean - (int)a->cal.center;
+    if (spread > JOY_CAL_REST_SPREAD_MAX || offset > JOY_CAL_REST_OFFSET_MAX || offset < -JOY_CAL_REST_OFFSET_MAX)
+    {
+        ESP_LOGW(TAG, "Axis %c not at rest at boot (%u..%u), keeping center %u", "XY"[i], a->rest_min, a->rest_max,
+                 a->cal.center);
+        return;
+    }
+    joy_cal_axis_t cal = a->cal;
+    cal.center = mean;
+    cal.noise = (uint16_t)((mean - a->rest_min > a->rest_max - mean) ? mean - a->rest_min : a->rest_max - mean);
+    if (!axis_valid(&cal))
+    {
+        cal.min = s_default.axis[i].min; // stored extents do not fit around the new center
+        cal.max = s_default.axis[i].max;
+    }
+    axis_set(i, &cal);
+    ESP_LOGI(TAG, "Axis %c center %u, noise %u, deadzone +-%u", "XY"[i], cal.center, cal.noise, a->half);
+}
+
+static void sweep_finish(void)
+{
+    bool ok = true;
+    for (int i = 0; i < 2; i++)
+    {
+        const axis_state_t *a = &s_axis[i];
+        ok = ok && a->sweep_min + JOY_CAL_SWEEP_TRAVEL < a->cal.center - a->half &&
+             a->cal.center + a->half + JOY_CAL_SWEEP_TRAVEL < a->sweep_max;
+    }
+    for (int i = 0; ok && i < 2; i++)
+    {
+        axis_state_t *a = &s_axis[i];
+        a->cal.min = a->sweep_min + JOY_CAL_EXTENT_TRIM;
+        a->cal.max = a->sweep_max - JOY_CAL_EXTENT_TRIM;
+        axis_rebuild(a);
+        axis_publish(i);
+        ESP_LOGI(TAG, "Axis %c travel %u..%u", "XY"[i], a->cal.min, a->cal.max);
+    }
+    if (!ok) ESP_LOGW(TAG, "Extents sweep incomplete, keeping the previous travel");
+    atomic_store(&s_sweep_ok, ok);
+    atomic_fetch_add_explicit(&s_sweep_done, 1, memory_order_release);
+}
+
+// Rest readings pull the center along; the maps are rebuilt when it moves a whole count.
+static void drift(int i, uint16_t raw)
+{
+    axis_state_t *a = &s_axis[i];
+    a->center_q16 += (((int32_t)raw << 16) - a->center_q16) >> JOY_CAL_DRIFT_SHIFT;
+    int32_t lo = ((int32_t)a->anchor - JOY_CAL_DRIFT_MAX) << 16, hi = ((int32_t)a->anchor + JOY_CAL_DRIFT_MAX) << 16;
+    if (a->center_q16 < lo) a->center_q16 = lo;
+    if (a->center_q16 > hi) a->center_q16 = hi;
+    uint16_t center = (uint16_t)((a->center_q16 + 0x8000) >> 16);
+    if (center == a->cal.center) return;
+    joy_cal_axis_t cal = a->cal;
+    cal.center = center;
+    if (!axis_valid(&cal)) return;
+    a->cal.center = center;
+    axis_rebuild(a);
+    axis_publish(i);
+}
+
+static uint16_t map(int i, uint16_t raw)
+{
+    axis_state_t *a = &s_axis[i];
+    int32_t d = (int32_t)raw - a->cal.center;
+    if (d < -(int32_t)a->half) return (uint16_t)fixq_map(&a->low, raw);
+    if (d > (int32_t)a->half) return (uint16_t)fixq_map(&a->high, raw);
+    drift(i, raw);
+    return a->out_rest;
+}
+
+void joy_cal_apply(uint16_t *joy_x, uint16_t *joy_y, int64_t now_us, bool fresh)
+{
+    uint16_t *joy[2] = {joy_x, joy_y};
+    follow_deadzone();
+
+    unsigned req = atomic_exchange(&s_sweep_req_ms, 0);
+    if (req != 0 && s_rest_count >= JOY_CAL_REST_SAMPLES)
+    {
+        s_sweeping = true;
+        s_sweep_end_us = now_us + (int64_t)req * 1000;
+        for (int i = 0; i < 2; i++) s_axis[i].sweep_min = s_axis[i].sweep_max = s_axis[i].cal.center;
+    }
+    else if (req != 0)
+    {
+        atomic_store(&s_sweep_ok, false); // still measuring the rest position
+        atomic_fetch_add_explicit(&s_sweep_done, 1, memory_order_release);
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        axis_state_t *a = &s_axis[i];
+        if (!fresh)
+        {
+            *joy[i] = a->out;
+            continue;
+        }
+        uint16_t raw = *joy[i];
+        if (s_rest_count < JOY_CAL_REST_SAMPLES)
+        {
+            rest_sample(a, raw);
+            a->out = a->out_rest;
+        }
+        else if (s_sweeping)
+        {
+            if (raw < a->sweep_min) a->sweep_min = raw;
+            if (raw > a->sweep_max) a->sweep_max = raw;
+            a->out = a->out_rest;
+        }
+        else
+        {
+            a->out = map(i, raw);
+        }
+        *joy[i] = a->out;
+    }
+
+    if (fresh && s_rest_count < JOY_CAL_REST_SAMPLES && ++s_rest_count == JOY_CAL_REST_SAMPLES)
+    {
+        rest_finish(0);
+        rest_finish(1);
+    }
+    if (s_sweeping && now_us >= s_sweep_end_us)
+    {
+        s_sweeping = false;
+        sweep_finish();
+    }
+}
+
+bool joy_cal_active(void)
+{
+    return s_rest_count < JOY_CAL_REST_SAMPLES || s_sweeping || atomic_load(&s_sweep_req_ms) != 0;
+}
+
+void joy_cal_get(joy_cal_t *out)
+{
+    for (int i = 0; i < 2; i++) out->axis[i] = unpack(atomic_load_explicit(&s_published[i], memory_order_relaxed));
+}
+
+bool joy_cal_sweep(uint32_t duration_ms, uint32_t timeout_ms)
+{
+    unsigned done = atomic_load_explicit(&s_sweep_done, memory_order_acquire);
+    atomic_store(&s_sweep_req_ms, duration_ms ? duration_ms : 1);
+    TickType_t start = xTaskGetTickCount();
+    while (atomic_load_explicit(&s_sweep_done, memory_order_acquire) == done)
+    {
+        if (xTaskGetTickCount() - start > pdMS_TO_TICKS(duration_ms + timeout_ms))
+        {
+            atomic_store(&s_sweep_req_ms, 0);
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return atomic_load(&s_sweep_ok);
+}
+
+esp_err_t joy_cal_load(joy_cal_t *out)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(JOY_CAL_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) return err;
+    uint64_t v[2];
+    err = nvs_get_u64(nvs, "x", &v[0]);
+    if (err == ESP_OK) err = nvs_get_u64(nvs, "y", &v[1]);
+    nvs_close(nvs);
+    if (err != ESP_OK) return err;
+
+    for (int i = 0; i < 2; i++)
+    {
+        out->axis[i] = unpack(v[i]);
+        if (!axis_valid(&out->axis[i]))
+        {
+            ESP_LOGW(TAG, "Stored calibration for axis %c is inconsistent, using defaults", "XY"[i]);
+            out->axis[i] = s_default.axis[i];
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t joy_cal_save(const joy_cal_t *cal)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(JOY_CAL_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+    err = nvs_set_u64(nvs, "x", pack(&cal->axis[0]));
+    if (err == ESP_OK) err = nvs_set_u64(nvs, "y", pack(&cal->axis[1]));
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+    return err;
+}
@@ -0,0 +1,59 @@
+#ifndef _JOY_CAL_H_
+#define _JOY_CAL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * Joystick calibration in the input path. Raw ADC counts are mapped onto a fixed
+ * "calibrated" scale before anything else sees them: readings within the measured
+ * rest noise of the center become the middle of the control deadzone, the rest of
+ * the travel (up to the learned extents) is spread over the scale outside it. The
+ * control core, the remote overlay and recordings keep working in that scale, so
+ * replay needs nothing from the calibration.
+ *
+ *  - At boot the first JOY_CAL_REST_SAMPLES fresh samples measure the center and
+ *    the rest noise; the stick reads as centered meanwhile. A stick that moves
+ *    during the measurement keeps the stored calibration.
+ *  - The deadzone is the measured noise plus JOY_CAL_DZ_MARGIN on either side.
+ *  - While the stick rests inside the deadzone the center follows slow drift, at
+ *    most JOY_CAL_DRIFT_MAX counts away from where it started.
+ *  - joy_cal_sweep() learns the extents: move the stick to every end stop within
+ *    the given time. The stick reads as centered during the sweep.
+ *
+ * joy_cal_apply() runs in the sampling task only; the other calls may come from
+ * any task.
+ */
+
+#define JOY_CAL_REST_SAMPLES    32      // boot rest measurement
+#define JOY_CAL_DZ_MARGIN       8       // added to the measured noise (ADC counts)
+#define JOY_CAL_DZ_MIN          12      // narrowest half deadzone
+#define JOY_CAL_DRIFT_MAX       48
+
+typedef struct
+{
+    uint16_t center;
+    uint16_t noise;     // largest deviation seen at rest
+    uint16_t min;       // end of travel
+    uint16_t max;
+} joy_cal_axis_t;
+
+typedef struct
+{
+    joy_cal_axis_t axis[2]; // X, Y
+} joy_cal_t;
+
+void joy_cal_init(const joy_cal_t *stored); // NULL: defaults; starts the rest measurement
+void joy_cal_set_deadzone(const uint32_t dz_lo[2], const uint32_t dz_hi[2]); // control deadzone on the calibrated scale
+void joy_cal_apply(uint16_t *joy_x, uint16_t *joy_y, int64_t now_us, bool fresh); // raw in, calibrated out
+bool joy_cal_active(void); // rest measurement or sweep in progress (sampling task)
+
+void joy_cal_get(joy_cal_t *out);   // calibration in use, including drift
+bool joy_cal_sweep(uint32_t duration_ms, uint32_t timeout_ms); // blocks; false if the stick did not reach both ends of each axis
+
+esp_err_t joy_cal_load(joy_cal_t *out);
+esp_err_t joy_cal_save(const joy_cal_t *cal);
+
+#endif // !_JOY_CAL_H_
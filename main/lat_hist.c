@@ -0,0 +1,186 @@
+#include "lat_hist.h"
+#include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+
+#include "core_local.h"
+
+static const char *TAG = "LAT_HIST";
+
+typedef struct
+{
+    atomic_uint start;      // low 32 bits of the event time, 0 = no pending mark
+    atomic_uint superseded;
+    atomic_uint min_us;
+    atomic_uint max_us;
+    _Atomic uint64_t sum_us;
+    atomic_uint buckets[LAT_BUCKETS];
+} lat_path_state_t;
+
+typedef struct
+{
+    const char *name;
+    uint8_t motor;
+    lat_act_t act;
+} lat_path_def_t;
+
+static const lat_path_def_t s_defs[LAT_PATH_COUNT] = {
+    [LAT_KEY_LAUNCH] = {"key->launch", 0, LAT_ACT_DRIVE},
+    [LAT_LIMIT2_BRAKE] = {"limit2->brake", 0, LAT_ACT_STOP},
+    [LAT_LIMIT1_BRAKE] = {"limit1->brake", 0, LAT_ACT_STOP},
+    [LAT_JOY_AIM_X] = {"joy x->duty", 1, LAT_ACT_DRIVE},
+    [LAT_JOY_AIM_Y] = {"joy y->duty", 2, LAT_ACT_DRIVE},
+    [LAT_LIMIT_AIM_X] = {"limit3/4->brake", 1, LAT_ACT_STOP},
+    [LAT_LIMIT_AIM_Y] = {"limit5/6->brake", 2, LAT_ACT_STOP},
+    [LAT_WAKE_DRIVE] = {"wake->drive", LAT_ANY_MOTOR, LAT_ACT_DRIVE},
+};
+
+static CORE_LOCAL lat_path_state_t s_paths[LAT_PATH_COUNT] = {
+    [0 ... LAT_PATH_COUNT - 1] = {.min_us = UINT32_MAX},
+};
+
+// values below 4 have a bucket each, above that 4 per power of two
+static unsigned bucket_of(uint32_t us)
+{
+    if (us < 4) return us;
+    unsigned e = 31u - (unsigned)__builtin_clz(us);
+    unsigned b = 4u * (e - 1u) + ((us >> (e - 2u)) & 3u);
+    return (b < LAT_BUCKETS) ? b : LAT_BUCKETS - 1;
+}
+
+uint32_t lat_hist_bucket_floor_us(unsigned bucket)
+{
+    if (bucket < 4) return bucket;
+    unsigned e = bucket / 4u + 1u;
+    return (4u + bucket % 4u) << (e - 2u);
+}
+
+static void record(lat_path_state_t *p, uint32_t us)
+{
+    atomic_fetch_add_explicit(&p->buckets[bucket_of(us)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&p->sum_us, us, memory_order_relaxed);
+    unsigned v = atomic_load_explicit(&p->min_us, memory_order_relaxed);
+    while (us < v && !atomic_compare_exchange_weak(&p->min_us, &v, us)) {}
+    v = atomic_load_explicit(&p->max_us, memory_order_relaxed);
+    while (us > v && !atomic_compare_exchange_weak(&p->max_us, &v, us)) {}
+}
+
+void lat_hist_mark(lat_path_t path, int64_t t_event_us)
+{
+    if (path >= LAT_PATH_COUNT) return;
+    unsigned t = (uint32_t)t_event_us;
+    unsigned idle = 0;
+    atomic_compare_exchange_strong(&s_paths[path].start, &idle, t ? t : 1u);
+}
+
+void lat_hist_actuated(uint8_t motor, lat_act_t act, int64_t now_us)
+{
+    for (int i = 0; i < LAT_PATH_COUNT; i++)
+    {
+        bool any = (s_defs[i].motor == LAT_ANY_MOTOR);
+        if (any ? (s_defs[i].act != act) : (s_defs[i].motor != motor)) continue;
+        lat_path_state_t *p = &s_paths[i];
+        if (atomic_load_explicit(&p->start, memory_order_relaxed) == 0) continue;
+        unsigned start = atomic_exchange(&p->start, 0);
+        if (start == 0) continue; // closed by another context
+        if (s_defs[i].act == act)
+        {
+            record(p, (uint32_t)now_us - start);
+        }
+        else
+        {
+            atomic_fetch_add_explicit(&p->superseded, 1, memory_order_relaxed);
+        }
+    }
+}
+
+void lat_hist_cancel(lat_path_t path)
+{
+    if (path < LAT_PATH_COUNT) atomic_store(&s_paths[path].start, 0);
+}
+
+const char *lat_hist_name(lat_path_t path)
+{
+    return (path < LAT_PATH_COUNT) ? s_defs[path].name : "?";
+}
+
+uint32_t lat_hist_get_buckets(lat_path_t path, uint32_t counts[LAT_BUCKETS])
+{
+    uint32_t total = 0;
+    for (int b = 0; b < LAT_BUCKETS; b++)
+    {
+        counts[b] = atomic_load_explicit(&s_paths[path].buckets[b], memory_order_relaxed);
+        total += counts[b];
+    }
+    return total;
+}
+
+// upper bound of the bucket holding the given rank, capped by the largest value seen
+static uint32_t percentile(const uint32_t counts[LAT_BUCKETS], uint32_t total, uint32_t permille, uint32_t max_us)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)total * permille + 999) / 1000);
+    uint32_t seen = 0;
+    for (unsigned b = 0; b < LAT_BUCKETS; b++)
+    {
+        seen += counts[b];
+        if (seen >= rank && seen > 0)
+        {
+            uint32_t upper = (b + 1 < LAT_BUCKETS) ? lat_hist_bucket_floor_us(b + 1) - 1 : UINT32_MAX;
+            return (upper < max_us) ? upper : max_us;
+        }
+    }
+    return max_us;
+}
+
+void lat_hist_get_summary(lat_path_t path, lat_summary_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (path >= LAT_PATH_COUNT) return;
+    lat_path_state_t *p = &s_paths[path];
+    uint32_t counts[LAT_BUCKETS];
+    uint32_t total = lat_hist_get_buckets(path, counts);
+    out->count = total;
+    out->superseded = atomic_load(&p->superseded);
+    if (total == 0) return;
+    out->min_us = atomic_load(&p->min_us);
+    out->max_us = atomic_load(&p->max_us);
+    out->mean_us = (uint32_t)(atomic_load(&p->sum_us) / total);
+    out->p50_us = percentile(counts, total, 500, out->max_us);
+    out->p90_us = percentile(counts, total, 900, out->max_us);
+    out->p99_us = percentile(counts, total, 990, out->max_us);
+}
+
+void lat_hist_reset(void)
+{
+    for (int i = 0; i < LAT_PATH_COUNT; i++)
+    {
+        lat_path_state_t *p = &s_paths[i];
+        for (int b = 0; b < LAT_BUCKETS; b++) atomic_store(&p->buckets[b], 0);
+        atomic_store(&p->superseded, 0);
+        atomic_store(&p->min_us, UINT32_MAX);
+        atomic_store(&p->max_us, 0);
+        atomic_store(&p->sum_us, 0);
+    }
+}
+
+void lat_hist_log(bool buckets)
+{
+    for (int i = 0; i < LAT_PATH_COUNT; i++)
+    {
+        lat_summary_t s;
+        lat_hist_get_summary((lat_path_t)i, &s);
+        if (s.count == 0 && s.superseded == 0) continue;
+        ESP_LOGI(TAG, "%-16s n=%" PRIu32 " min/p50/p90/p99/max %" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32
+                 " us, mean %" PRIu32 " us, superseded %" PRIu32,
+                 s_defs[i].name, s.count, s.min_us, s.p50_us, s.p90_us, s.p99_us, s.max_us, s.mean_us, s.superseded);
+        if (!buckets) continue;
+        uint32_t counts[LAT_BUCKETS];
+        lat_hist_get_buckets((lat_path_t)i, counts);
+        for (unsigned b = 0; b < LAT_BUCKETS; b++)
+        {
+            if (counts[b] == 0) continue;
+            ESP_LOGI(TAG, "    >= %8" PRIu32 " us: %" PRIu32, lat_hist_bucket_floor_us(b), counts[b]);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef _LAT_HIST_H_
+#define _LAT_HIST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Input-to-actuation latency, always on. The control core marks an input event with
+ * its timestamp when it decides to act on it (the frame time, or the edge interrupt
+ * time for the launch limit switch); motor_control closes the mark when the matching
+ * bdc_motor call for that motor has been issued, and the difference goes into a
+ * per-path histogram in RAM.
+ *
+ * Buckets are log2 with 4 sub-buckets per octave (at most 25% wide), so a path costs
+ * LAT_BUCKETS words and recording is a few instructions and atomic adds, safe from
+ * the control task and esp_timer callbacks alike. An actuation of the other kind on
+ * the same motor (a brake instead of the expected drive) drops the mark as
+ * superseded, so a cancelled command never shows up as a huge latency later.
+ *
+ * Keys and the joystick are polled once per control tick, so their paths start at
+ * the sample time; the polling delay itself is at most one tick on top.
+ *
+ * LAT_WAKE_DRIVE is not tied to one motor: the first drive on any motor after a wake
+ * from light sleep closes it and brakes are ignored. A wake that leads nowhere is
+ * dropped with lat_hist_cancel() before the next sleep.
+ */
+
+#define LAT_BUCKETS         100     // up to 2^26 us (67 s), longer goes in the last bucket
+#define LAT_ANY_MOTOR       0xff
+
+typedef enum
+{
+    LAT_KEY_LAUNCH,     // key 2 -> launch motor driving
+    LAT_LIMIT2_BRAKE,   // limit 2 edge -> launch motor braked
+    LAT_LIMIT1_BRAKE,   // limit 1 reached on the return stroke -> launch motor braked
+    LAT_JOY_AIM_X,      // joystick X changed -> aim motor 1 duty set
+    LAT_JOY_AIM_Y,      // joystick Y changed -> aim motor 2 duty set
+    LAT_LIMIT_AIM_X,    // limit 3/4 reached while driving -> aim motor 1 braked
+    LAT_LIMIT_AIM_Y,    // limit 5/6 reached while driving -> aim motor 2 braked
+    LAT_WAKE_DRIVE,     // key / limit switch woke the CPU -> first motor driving
+    LAT_PATH_COUNT,
+} lat_path_t;
+
+typedef enum
+{
+    LAT_ACT_DRIVE,      // direction and duty applied
+    LAT_ACT_STOP,       // brake or coast
+} lat_act_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t superseded;    // marks dropped by an actuation of the other kind
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t mean_us;
+    uint32_t p50_us;        // percentiles are bucket upper bounds
+    uint32_t p90_us;
+    uint32_t p99_us;
+} lat_summary_t;
+
+void lat_hist_mark(lat_path_t path, int64_t t_event_us);     // keeps the earliest pending mark
+void lat_hist_actuated(uint8_t motor, lat_act_t act, int64_t now_us);
+void lat_hist_cancel(lat_path_t path);                      // drops a pending mark, not counted
+const char *lat_hist_name(lat_path_t path);
+void lat_hist_get_summary(lat_path_t path, lat_summary_t *out);
+uint32_t lat_hist_get_buckets(lat_path_t path, uint32_t counts[LAT_BUCKETS]); // returns the total
+uint32_t lat_hist_bucket_floor_us(unsigned bucket); // lowest latency counted in a bucket
+void lat_hist_reset(void);
+void lat_hist_log(bool buckets); // summary per path, optionally the non-empty buckets
+
+#endif // !_LAT_HIST_H_
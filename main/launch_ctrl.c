@@ -0,0 +1,112 @@
+#include "launch_ctrl.h"
+#include <string.h>
+#include "esp_log.h"
+#include "motor_control.h"
+#include "core_local.h"
+#include "fixq.h"
+
+static const char *TAG = "LAUNCH_CTRL";
+
+#define LAUNCH_ADC_MAX          4095
+#define LAUNCH_DUTY_MIN         2000    // below this the carriage may stall mid-stroke
+#define LAUNCH_GAIN_SHIFT       1       // adapt by 1/2 of the observed error per shot
+
+// duty = k * speed, k in Q16 (duty units per mm/s), learned shot to shot
+#define LAUNCH_K_INIT_Q16       ((uint32_t)(((uint64_t)9000 << 16) / LAUNCH_SPEED_MAX_MMPS))
+
+static CORE_LOCAL fixq_map_t s_setpoint_map; // pot counts -> mm/s
+static CORE_LOCAL uint32_t s_k_q16 = LAUNCH_K_INIT_Q16;
+static CORE_LOCAL uint32_t s_target_mmps = LAUNCH_SPEED_MIN_MMPS;
+static CORE_LOCAL uint32_t s_duty_used = 0;
+static CORE_LOCAL uint32_t s_measured_mmps = 0;
+static CORE_LOCAL uint32_t s_measured_us = 0;
+
+static CORE_LOCAL bool s_armed = false;
+static CORE_LOCAL int64_t s_t_leave_us = 0; // carriage left limit switch 1
+static CORE_LOCAL int64_t s_t_hit_us = 0;   // carriage reached limit switch 2
+
+// Forget the learned gain and the last measurement.
+void launch_ctrl_reset(void)
+{
+    fixq_map_init(&s_setpoint_map, 0, LAUNCH_ADC_MAX, LAUNCH_SPEED_MIN_MMPS, LAUNCH_SPEED_MAX_MMPS);
+    s_k_q16 = LAUNCH_K_INIT_Q16;
+    s_target_mmps = LAUNCH_SPEED_MIN_MMPS;
+    s_duty_used = 0;
+    s_measured_mmps = 0;
+    s_measured_us = 0;
+    s_armed = false;
+    s_t_leave_us = 0;
+    s_t_hit_us = 0;
+}
+
+// Pick the stroke edges out of each input frame while a stroke is armed.
+void launch_ctrl_on_frame(const input_frame_t *in)
+{
+    if (!s_armed) return;
+
+    if (s_t_leave_us == 0 && in->t_edge_us[INPUT_EDGE_LIMIT1_RELEASE] != 0)
+    {
+        s_t_leave_us = in->t_edge_us[INPUT_EDGE_LIMIT1_RELEASE];
+    }
+    if (s_t_leave_us != 0 && s_t_hit_us == 0 && in->t_edge_us[INPUT_EDGE_LIMIT2_HIT] > s_t_leave_us)
+    {
+        s_t_hit_us = in->t_edge_us[INPUT_EDGE_LIMIT2_HIT];
+    }
+}
+
+void launch_ctrl_set_setpoint(uint32_t pot_adc)
+{
+    s_target_mmps = (uint32_t)fixq_map(&s_setpoint_map, (int32_t)pot_adc);
+}
+
+uint32_t launch_ctrl_begin_stroke(void)
+{
+    uint32_t duty = (uint32_t)(((uint64_t)s_k_q16 * s_target_mmps) >> 16);
+    if (duty < LAUNCH_DUTY_MIN) duty = LAUNCH_DUTY_MIN;
+    if (duty > MOTOR_DUTY_SCALE) duty = MOTOR_DUTY_SCALE;
+
+    s_t_leave_us = 0;
+    s_t_hit_us = 0;
+    s_duty_used = duty;
+    s_armed = true;
+    return duty;
+}
+
+bool launch_ctrl_end_stroke(void)
+{
+    s_armed = false;
+    int64_t t_leave = s_t_leave_us;
+    int64_t t_hit = s_t_hit_us;
+    if (t_leave == 0 || t_hit <= t_leave)
+    {
+        ESP_LOGW(TAG, "No valid stroke timing, duty unchanged");
+        return false;
+    }
+
+    s_measured_us = (uint32_t)(t_hit - t_leave);
+    s_measured_mmps = (uint32_t)((uint64_t)LAUNCH_STROKE_LENGTH_MM * 1000000 / s_measured_us);
+    if (s_measured_mmps == 0) return false;
+
+    // the measured speed at the duty used gives a fresh estimate of k
+    int32_t k_meas = (int32_t)(((uint64_t)s_duty_used << 16) / s_measured_mmps);
+    s_k_q16 = (uint32_t)((int32_t)s_k_q16 + ((k_meas - (int32_t)s_k_q16) >> LAUNCH_GAIN_SHIFT));
+
+    ESP_LOGI(TAG, "Stroke %" PRIu32 " us, %" PRIu32 " mm/s (target %" PRIu32 "), duty %" PRIu32,
+             s_measured_us, s_measured_mmps, s_target_mmps, s_duty_used);
+    return true;
+}
+
+uint32_t launch_ctrl_target_speed_mmps(void)
+{
+    return s_target_mmps;
+}
+
+uint32_t launch_ctrl_measured_speed_mmps(void)
+{
+    return s_measured_mmps;
+}
+
+uint32_t launch_ctrl_measured_stroke_us(void)
+{
+    return s_measured_us;
+}
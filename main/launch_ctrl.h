@@ -0,0 +1,29 @@
+#ifndef _LAUNCH_CTRL_H_
+#define _LAUNCH_CTRL_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "input_frame.h"
+
+/*
+ * Launch stroke speed control. The potentiometer sets the target launch speed; the
+ * stroke time (leaving limit switch 1 -> hitting limit switch 2) comes from the edge
+ * timestamps the GPIO ISR puts into the input frames, and the stroke duty is adapted
+ * shot to shot so the measured stroke converges on the target.
+ */
+
+#define LAUNCH_STROKE_LENGTH_MM     120     // distance between limit switch 1 and 2
+#define LAUNCH_SPEED_MIN_MMPS       2000    // pot at 0
+#define LAUNCH_SPEED_MAX_MMPS       30000   // pot at full scale
+
+void launch_ctrl_reset(void);
+void launch_ctrl_on_frame(const input_frame_t *in);
+void launch_ctrl_set_setpoint(uint32_t pot_adc);
+uint32_t launch_ctrl_begin_stroke(void);   // arms the timestamps, returns the duty to use
+bool launch_ctrl_end_stroke(void);         // adapts the duty, false if no valid measurement
+
+uint32_t launch_ctrl_target_speed_mmps(void);
+uint32_t launch_ctrl_measured_speed_mmps(void); // 0 until the first valid shot
+uint32_t launch_ctrl_measured_stroke_us(void);
+
+#endif // !_LAUNCH_CTRL_H_
@@ -1,260 +1,71 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
-#include "driver/gpio.h"
-#include "esp_adc/adc_continuous.h"
-#include "driver/mcpwm_prelude.h"
 #include "esp_timer.h"
-#include "bdc_motor.h"
 
-#include "input_driver.h"
-#include "display_driver.h"
-#include "motor_control.h"
+#include "app_runtime.h"
 
 static const char *TAG = "MAIN";
 
-typedef enum
-{
-    STATE_IDLE,       // 空闲状态
-    STATE_MANUAL_AIM, // 手动摇杆控制状态
-} system_state_t;
-
-volatile system_state_t g_current_state = STATE_IDLE;
-static adc_continuous_handle_t adc_handle = NULL;
-static QueueHandle_t adc_data_queue;
+#define CONTROL_PERIOD_US   (CONTROL_PERIOD_MS * 1000)
 
 //================================================================================
-// 任务 1: 数码管显示任务
+// 超级循环运行时: app_main 中单一循环, 节拍时刻由 esp_timer 单次定时器决定
 //================================================================================
-void display_task(void *pvParameters)
-{
-    uint32_t adc_value = 0;
-    while (1)
-    {
-        if (xQueueReceive(adc_data_queue, &adc_value, portMAX_DELAY))
-        {
-            // 将ADC值 (0-4095) 转换为速度 (0-30 m/s)
-            float speed = (float)adc_value * 30.0f / 4095.0f;
-            ESP_LOGI(TAG, "ADC Value: %d, Speed: %d m/s", (int)adc_value, (int)speed);
-            display_set_float(speed);
-        }
-    }
-}
+static esp_timer_handle_t s_tick_timer = NULL;
+static TaskHandle_t s_loop_task = NULL;
 
-//================================================================================
-// 任务 2: 发射流程任务
-//================================================================================
-void launching_mode(void) 
+static void tick_timer_cb(void *arg)
 {
-    ESP_LOGI(TAG, "发射任务开始...");
-
-    // 1. 电机1正转，直到触发限位器2
-    ESP_LOGI(TAG, "电机1正转...");
-    motor_start_forward(0); // 启动电机1正转
-    while (read_limitStop_IO_level(2) == 1)
-    {
-        vTaskDelay(pdMS_TO_TICKS(10)); 
-    }
-    motor_stop(0); // 立即停止电机1
-
-    ESP_LOGI(TAG, "触发限位器2");
-    // 2. 电机1反转，直到触发限位器1
-    ESP_LOGI(TAG, "电机1反转...");
-    motor_start_reverse(0); // 启动电机1反转
-    while (read_limitStop_IO_level(1) == 1)// 等待限位器1触发
-    {
-        vTaskDelay(pdMS_TO_TICKS(10));
-    } 
-    motor_stop(0); // 立即停止电机1
-
-    ESP_LOGI(TAG, "触发限位器1,发射流程结束。");
-    ESP_LOGI(TAG, "state change: LAUNCH_MODE -> IDLE"); // 发射流程结束，切换到空闲状态
-    g_current_state = STATE_IDLE;
+    xTaskNotifyGive(s_loop_task);
 }
 
-//================================================================================
-// 任务 3: 随机模式任务
-//================================================================================
-void random_mode(void)
+// 到截止时刻的单次定时器唤醒本任务, 等待期间阻塞不占CPU (空闲任务喂看门狗, 也才能 light sleep);
+// 不依赖系统节拍, 100Hz 节拍下也不需要忙等. 提前的通知 (如唤醒引脚) 只会让循环再等一次
+static void wait_until(int64_t deadline_us)
 {
-    ESP_LOGI(TAG, "random mode task started...");
-
-    int64_t start_time = esp_timer_get_time();
-    // 持续5秒
-    while ((esp_timer_get_time() - start_time) < 5000000)
+    while (1)
     {
-        // 随机决定电机2的动作
-        int motor2_action = rand() % 3; // 0: 停止, 1: 正转, 2: 反转
-        if ((motor2_action == 1) && (read_limitStop_IO_level(3) == 1))
-        {
-            motor_start_forward(1); // 正转
-        }
-        else if ((motor2_action == 2) && (read_limitStop_IO_level(4) == 1))
-        {
-            motor_start_reverse(1); // 反转
-        }
-
-        // 随机决定电机3的动作
-        int motor3_action = rand() % 3; // 0: 停止, 1: 正转, 2: 反转
-        if ((motor3_action == 1) && (read_limitStop_IO_level(5) == 1))
-        {
-            motor_start_forward(2); // 正转
-        }
-        else if ((motor3_action == 2) && (read_limitStop_IO_level(6) == 1))
-        {
-            motor_start_reverse(2); // 反转
-        }
+        int64_t rem = deadline_us - esp_timer_get_time();
+        if (rem <= 0) return;
+        ESP_ERROR_CHECK(esp_timer_start_once(s_tick_timer, (uint64_t)rem));
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        esp_timer_stop(s_tick_timer); // 被其它通知提前唤醒时定时器可能仍在运行
     }
-
-    // 5秒后停止电机2和3
-    motor_stop(1);
-    motor_stop(2);
-    ESP_LOGI(TAG, "state change: RANDOM_MODE -> IDLE");
-    g_current_state = STATE_IDLE;
 }
 
-//================================================================================
-// 任务 4: 核心控制与输入扫描任务
-//================================================================================
-void control_task(void *pvParameters)
+void app_main(void)
 {
-    // 用于连续ADC读取的缓冲区
-    uint8_t result[ADC_READ_LEN] = {0};
-    uint32_t ret_num = 0;
-    uint32_t adc_joy_x = 1558;
-    uint32_t adc_joy_y = 1346;
-    uint32_t pot_val = 0; // 电位器值
-
-    // 摇杆死区定义
-    const int JOYSTICK_DEADZONE_LOW_X = 1500;
-    const int JOYSTICK_DEADZONE_HIGH_X = 1600;
-    const int JOYSTICK_DEADZONE_LOW_Y = 1300;
-    const int JOYSTICK_DEADZONE_HIGH_Y = 1400;
-
+    static input_frame_t frame = INPUT_FRAME_INIT;
+    app_runtime_init();
+
+    vTaskPrioritySet(NULL, CONTROL_TASK_PRIO); // 与 RTOS 运行时的控制任务同一优先级, 基准结果可比
+    s_loop_task = xTaskGetCurrentTaskHandle();
+    const esp_timer_create_args_t timer_args = {
+        .callback = tick_timer_cb,
+        .name = "superloop_tick",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_tick_timer));
+    app_runtime_loop_init("superloop");
+    ESP_LOGI(TAG, "init completed. Superloop running.");
+
+    int64_t next_us = esp_timer_get_time();
     while (1)
     {
-        // --- ADC数据处理 ---
-        adc_continuous_read(adc_handle, result, ADC_READ_LEN, &ret_num, 0);
-        for (int i = 0; i < ret_num; i += SOC_ADC_DIGI_RESULT_BYTES)
+        app_runtime_tick(&frame);
+        int64_t now_us = esp_timer_get_time();
+        if (app_runtime_idle(&frame))
         {
-            adc_digi_output_data_t *p = (void *)(&result[i]);
-            uint32_t chan = ADC_GET_CHANNEL(p);
-            uint32_t data = ADC_GET_DATA(p);
-
-            if (chan == ADC1_CHAN1)
-            {
-                pot_val = data;
-            }
-            else if (chan == ADC1_CHANx)
-            {
-                adc_joy_x = data;
-            }
-            else if (chan == ADC1_CHANy)
-            {
-                adc_joy_y = data;
-            }
-        }
-        
-        if (ret_num > 0) 
-        { 
-            xQueueSend(adc_data_queue, &pot_val, 0);
+            next_us = esp_timer_get_time(); // 睡醒后立即运行下一节拍 (与 RTOS 运行时相同), 从现在开始重新计节拍
+            continue;
         }
-
-        switch (g_current_state)
-        {
-        case STATE_IDLE:
-            ESP_LOGI(TAG, "当前状态：空闲");
-            if ((read_key_level(2) == 0) && (read_limitStop_IO_level(1) == 0)) // 按键1按下且限位器1触发
-            {
-                ESP_LOGI(TAG, "按键1按下,电机启动,移向限位器1...");
-                launching_mode(); // 进入发射流程
-                // 发射流程结束后，状态会自动切换回IDLE
-                ESP_LOGI(TAG, "state change: IDLE -> LAUNCH_MODE");
-            }
-            else if (read_key_level(3) == 0) // 按键2按下
-            {
-                ESP_LOGI(TAG, "按键2按下,进入随机模式...");
-                random_mode(); // 进入随机模式
-                ESP_LOGI(TAG, "state change: IDLE -> RANDOM_MODE");
-            }
-            else if ((adc_joy_x < JOYSTICK_DEADZONE_LOW_X) || (adc_joy_x > JOYSTICK_DEADZONE_HIGH_X) ||
-                     (adc_joy_y < JOYSTICK_DEADZONE_LOW_Y) || (adc_joy_y > JOYSTICK_DEADZONE_HIGH_Y))
-            {
-                ESP_LOGI(TAG, "摇杆被触动,进入手动控制模式...");
-                g_current_state = STATE_MANUAL_AIM; // 摇杆被触动
-                ESP_LOGI(TAG, "state change: IDLE -> MANUAL_AIM");
-            }
-            break;
-
-        case STATE_MANUAL_AIM:
-            // 摇杆X轴控制电机2
-            if ((adc_joy_x < JOYSTICK_DEADZONE_LOW_X) && (read_limitStop_IO_level(3) == 1))
-            {
-                motor_start_forward(1); 
-            }
-            else if ((adc_joy_x > JOYSTICK_DEADZONE_HIGH_X) && (read_limitStop_IO_level(4) == 1))
-            {
-                motor_start_reverse(1);
-            }
-            else
-            {
-                motor_stop(1); // 摇杆不在有效范围内，停止电机2
-            }
-
-            // 摇杆Y轴控制电机3
-            if ((adc_joy_y < JOYSTICK_DEADZONE_LOW_Y) && (read_limitStop_IO_level(5) == 1))
-            {
-                motor_start_forward(2);
-            }
-            else if ((adc_joy_y > JOYSTICK_DEADZONE_HIGH_Y) && (read_limitStop_IO_level(6) == 1))
-            {
-                motor_start_reverse(2);
-            }
-            else
-            {
-                motor_stop(2);
-            }
-
-            // 如果摇杆回中，则返回IDLE状态
-            if ((adc_joy_x >= JOYSTICK_DEADZONE_LOW_X) && (adc_joy_x <= JOYSTICK_DEADZONE_HIGH_X) &&
-                (adc_joy_y >= JOYSTICK_DEADZONE_LOW_Y) && (adc_joy_y <= JOYSTICK_DEADZONE_HIGH_Y))
-            {
-                g_current_state = STATE_IDLE;
-                motor_stop(1);
-                motor_stop(2);
-                ESP_LOGI(TAG, "state change: MANUAL_AIM -> IDLE");
-            }
-            break;
-        }
-        ESP_LOGI(TAG, "JoyX: %d, JoyY: %d, Pot: %d", (int)adc_joy_x, (int)adc_joy_y, (int)pot_val); // 打印摇杆和电位器的值
-        vTaskDelay(pdMS_TO_TICKS(50)); // 每50ms扫描一次
+        if (now_us - next_us > CONTROL_PERIOD_US) next_us = now_us; // 落后超过一个节拍
+        next_us += CONTROL_PERIOD_US;
+        wait_until(next_us);
     }
 }
-
-void app_main(void)
-{
-    ESP_LOGI(TAG, "init hardware drivers...");
-    limitStop_IO_init();
-    key_init();
-    display_init();
-    motor_init(); // 电机ID范围为0，1，2 ---> 对应电机1，2，3
-
-    ESP_LOGI(TAG, "init ADC...");
-    continuous_adc_init(adc_channel, 4, &adc_handle);
-    adc_continuous_start(adc_handle);
-
-    // --- 3. 初始化FreeRTOS组件 ---
-    ESP_LOGI(TAG, "init FreeRTOS...");
-    adc_data_queue = xQueueCreate(10, sizeof(uint32_t));
-
-    // --- 4. 创建所有任务 ---
-    ESP_LOGI(TAG, "create tasks...");
-    xTaskCreate(display_task, "display_task", 2048, NULL, 10, NULL);
-    xTaskCreate(control_task, "control_task", 4096, NULL, 10, NULL);
-    ESP_LOGI(TAG, "init completed. System is now running.");
-}
@@ -0,0 +1,328 @@
+#include "motion.h"
+#include <string.h>
+#include "motor_control.h"
+
+#define MOTION_FOREVER  0
+
+static const uint8_t s_size[MOTION_OP_COUNT] = {
+    [MOTION_OP_END]        = 1,
+    [MOTION_OP_MOVE]       = 5,
+    [MOTION_OP_STOP]       = 3,
+    [MOTION_OP_WAIT_LIMIT] = 4,
+    [MOTION_OP_WAIT_MS]    = 3,
+    [MOTION_OP_RAMP]       = 9,
+    [MOTION_OP_LOOP]       = 2,
+    [MOTION_OP_NEXT]       = 1,
+    [MOTION_OP_EMIT]       = 4,
+};
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+//================================================================================
+// Validator
+//================================================================================
+static bool motor_ok(uint8_t m)
+{
+    return m < MOTION_MOTORS;
+}
+
+static bool dir_ok(uint8_t dir)
+{
+    return (int8_t)dir == 1 || (int8_t)dir == -1;
+}
+
+static bool duty_ok(uint16_t duty)
+{
+    return duty <= MOTOR_DUTY_SCALE || duty == MOTION_DUTY_ARG;
+}
+
+static bool operands_ok(const uint8_t *p)
+{
+    switch (p[0])
+    {
+    case MOTION_OP_MOVE:       return motor_ok(p[1]) && dir_ok(p[2]) && duty_ok(get_u16(p + 3));
+    case MOTION_OP_STOP:       return motor_ok(p[1]) && (p[2] <= MOTOR_STOP_RAMP || p[2] == MOTION_STOP_CONFIG);
+    case MOTION_OP_WAIT_LIMIT: return p[1] >= 1 && p[1] <= 6 && get_u16(p + 2) != 0;
+    case MOTION_OP_WAIT_MS:    return get_u16(p + 1) != 0;
+    case MOTION_OP_RAMP:
+        return motor_ok(p[1]) && dir_ok(p[2]) && get_u16(p + 3) <= MOTOR_DUTY_SCALE && get_u16(p + 5) <= MOTOR_DUTY_SCALE &&
+               get_u16(p + 7) != 0;
+    default:                   return true;
+    }
+}
+
+motion_err_t motion_validate(const uint8_t *code, size_t len, uint8_t *motors, size_t *err_pc)
+{
+    struct
+    {
+        uint8_t count;
+        bool waits;
+    } loops[MOTION_LOOP_DEPTH];
+    uint8_t depth = 0, mask = 0;
+    size_t pc = 0;
+    motion_err_t err = MOTION_OK;
+
+    if (len == 0 || len > MOTION_PROG_MAX) err = MOTION_ERR_EMPTY;
+    while (err == MOTION_OK && pc < len)
+    {
+        const uint8_t *p = code + pc;
+        if (p[0] >= MOTION_OP_COUNT)
+        {
+            err = MOTION_ERR_OPCODE;
+            break;
+        }
+        if (pc + s_size[p[0]] > len)
+        {
+            err = MOTION_ERR_TRUNCATED;
+            break;
+        }
+        if (!operands_ok(p))
+        {
+            err = MOTION_ERR_OPERAND;
+            break;
+        }
+        switch (p[0])
+        {
+        case MOTION_OP_END:
+            if (pc != len - 1) err = MOTION_ERR_END;
+            else if (depth != 0) err = MOTION_ERR_NESTING;
+            break;
+        case MOTION_OP_MOVE:
+        case MOTION_OP_STOP:
+            mask |= 1u << p[1];
+            break;
+        case MOTION_OP_RAMP:
+            mask |= 1u << p[1];
+            if (depth) loops[depth - 1].waits = true;
+            break;
+        case MOTION_OP_WAIT_LIMIT:
+        case MOTION_OP_WAIT_MS:
+            if (depth) loops[depth - 1].waits = true;
+            break;
+        case MOTION_OP_LOOP:
+            if (depth == MOTION_LOOP_DEPTH)
+            {
+                err = MOTION_ERR_NESTING;
+                break;
+            }
+            loops[depth].count = p[1];
+            loops[depth].waits = false;
+            depth++;
+            break;
+        case MOTION_OP_NEXT:
+            if (depth == 0)
+            {
+                err = MOTION_ERR_NESTING;
+                break;
+            }
+            depth--;
+            if (loops[depth].count == MOTION_FOREVER && !loops[depth].waits) err = MOTION_ERR_SPIN;
+            else if (depth) loops[depth - 1].waits |= loops[depth].waits;
+            break;
+        }
+        if (err == MOTION_OK) pc += s_size[p[0]];
+    }
+    if (err == MOTION_OK && code[len - 1] != MOTION_OP_END)
+    {
+        err = MOTION_ERR_END;
+        pc = len;
+    }
+    if (err_pc) *err_pc = pc;
+    if (motors) *motors = mask;
+    return err;
+}
+
+const char *motion_err_name(motion_err_t err)
+{
+    switch (err)
+    {
+    case MOTION_OK:            return "ok";
+    case MOTION_ERR_EMPTY:     return "empty or too long";
+    case MOTION_ERR_OPCODE:    return "unknown opcode";
+    case MOTION_ERR_TRUNCATED: return "truncated instruction";
+    case MOTION_ERR_OPERAND:   return "operand out of range";
+    case MOTION_ERR_NESTING:   return "unbalanced or too deep loop";
+    case MOTION_ERR_SPIN:      return "forever loop without a wait";
+    case MOTION_ERR_END:       return "end missing or not last";
+    default:                   return "?";
+    }
+}
+
+// One instruction in the assembler's source form (host/motion_asm.c).
+size_t motion_disasm(const uint8_t *code, size_t len, size_t pc, char *out, size_t out_size)
+{
+    static const char *const stop_names[] = {"brake", "coast", "ramp"};
+    if (pc >= len || code[pc] >= MOTION_OP_COUNT || pc + s_size[code[pc]] > len)
+    {
+        snprintf(out, out_size, "%04u  ?", (unsigned)pc);
+        return 0;
+    }
+    const uint8_t *p = code + pc;
+    const char *dir = (s_size[p[0]] > 2 && (int8_t)p[2] > 0) ? "fwd" : "rev";
+    char duty[8];
+    uint16_t d = (p[0] == MOTION_OP_MOVE) ? get_u16(p + 3) : 0;
+    if (d == MOTION_DUTY_DEFAULT) strcpy(duty, "default");
+    else if (d == MOTION_DUTY_ARG) strcpy(duty, "arg");
+    else snprintf(duty, sizeof(duty), "%u", d);
+
+    int n = snprintf(out, out_size, "%04u  ", (unsigned)pc);
+    char *s = out + n;
+    size_t room = (n > 0 && (size_t)n < out_size) ? out_size - n : 0;
+    switch (p[0])
+    {
+    case MOTION_OP_END:        snprintf(s, room, "end"); break;
+    case MOTION_OP_MOVE:       snprintf(s, room, "move %u %s %s", p[1], dir, duty); break;
+    case MOTION_OP_STOP:
+        snprintf(s, room, "stop %u %s", p[1], (p[2] <= MOTOR_STOP_RAMP) ? stop_names[p[2]] : "config");
+        break;
+    case MOTION_OP_WAIT_LIMIT: snprintf(s, room, "wait_limit %u %u", p[1], get_u16(p + 2)); break;
+    case MOTION_OP_WAIT_MS:    snprintf(s, room, "wait_ms %u", get_u16(p + 1)); break;
+    case MOTION_OP_RAMP:
+        snprintf(s, room, "ramp %u %s %u %u %u", p[1], dir, get_u16(p + 3), get_u16(p + 5), get_u16(p + 7));
+        break;
+    case MOTION_OP_LOOP:       snprintf(s, room, "loop %u", p[1]); break;
+    case MOTION_OP_NEXT:       snprintf(s, room, "next"); break;
+    case MOTION_OP_EMIT:       snprintf(s, room, "emit %u %u", p[1], get_u16(p + 2)); break;
+    }
+    return (p[0] == MOTION_OP_END) ? 0 : pc + s_size[p[0]];
+}
+
+//================================================================================
+// Interpreter
+//================================================================================
+void motion_start(motion_vm_t *vm, const motion_prog_t *prog, motion_emit_fn_t emit, void *ctx)
+{
+    memset(vm, 0, sizeof(*vm));
+    vm->prog = prog;
+    vm->status = MOTION_RUNNING;
+    vm->emit = emit;
+    vm->emit_ctx = ctx;
+}
+
+bool motion_running(const motion_vm_t *vm)
+{
+    return vm->status == MOTION_RUNNING;
+}
+
+void motion_abort(motion_vm_t *vm)
+{
+    for (uint8_t m = 0; m < MOTION_MOTORS; m++)
+    {
+        if (vm->driving & (1u << m)) motor_stop(m);
+    }
+    vm->driving = 0;
+    vm->status = MOTION_ABORTED;
+}
+
+// Waits and ramps keep their start time across ticks; true while still in progress.
+static bool elapsed_below(motion_vm_t *vm, int64_t now, uint32_t ms)
+{
+    if (!vm->started)
+    {
+        vm->started = true;
+        vm->start_us = now;
+    }
+    if (now - vm->start_us < (int64_t)ms * 1000) return true;
+    vm->started = false;
+    return false;
+}
+
+motion_status_t motion_step(motion_vm_t *vm, const input_frame_t *in, int64_t now)
+{
+    if (vm->status != MOTION_RUNNING) return vm->status;
+    const uint8_t *code = vm->prog->code;
+    for (int ops = 0; ops < MOTION_STEP_OPS; ops++)
+    {
+        const uint8_t *p = code + vm->pc;
+        uint8_t m = (p[0] == MOTION_OP_END) ? 0 : p[1]; // END may be the last byte of the code
+        int8_t dir = (s_size[p[0]] > 2) ? (int8_t)p[2] : 0;
+        switch (p[0])
+        {
+        case MOTION_OP_END:
+            vm->status = MOTION_DONE;
+            return vm->status;
+
+        case MOTION_OP_MOVE:
+        {
+            uint16_t duty = get_u16(p + 3);
+            if (duty != MOTION_DUTY_DEFAULT) motor_start_duty(m, dir, (duty == MOTION_DUTY_ARG) ? vm->arg : duty);
+            else if (dir > 0) motor_start_forward(m);
+            else motor_start_reverse(m);
+            vm->driving |= 1u << m;
+            vm->dir[m] = dir;
+            break;
+        }
+
+        case MOTION_OP_STOP:
+            if (p[2] == MOTION_STOP_CONFIG) motor_stop(m);
+            else motor_stop_mode(m, (motor_stop_mode_t)p[2]);
+            vm->driving &= ~(1u << m);
+            break;
+
+        case MOTION_OP_WAIT_LIMIT:
+            // same test as the launch legs had: the switch, else more than the timeout since the wait began
+            if (!vm->started)
+            {
+                vm->started = true;
+                vm->start_us = now;
+            }
+            vm->timed_out = false;
+            if (!input_limit_hit(in, p[1]))
+            {
+                if (now - vm->start_us <= (int64_t)get_u16(p + 2) * 1000) return vm->status;
+                vm->timed_out = true;
+            }
+            vm->started = false;
+            break;
+
+        case MOTION_OP_WAIT_MS:
+            if (elapsed_below(vm, now, get_u16(p + 1))) return vm->status;
+            break;
+
+        case MOTION_OP_RAMP:
+        {
+            int32_t from = get_u16(p + 3), to = get_u16(p + 5);
+            uint32_t ms = get_u16(p + 7);
+            bool more = elapsed_below(vm, now, ms);
+            int32_t duty = more ? from + (int32_t)((to - from) * (now - vm->start_us) / ((int64_t)ms * 1000)) : to;
+            motor_start_duty(m, dir, (uint32_t)duty);
+            vm->driving |= 1u << m;
+            vm->dir[m] = dir;
+            if (more) return vm->status;
+            break;
+        }
+
+        case MOTION_OP_LOOP:
+            vm->loops[vm->depth].pc = vm->pc + s_size[MOTION_OP_LOOP];
+            vm->loops[vm->depth].left = p[1];
+            vm->depth++;
+            break;
+
+        case MOTION_OP_NEXT:
+        {
+            uint8_t *left = &vm->loops[vm->depth - 1].left;
+            if (*left == MOTION_FOREVER || --*left > 0)
+            {
+                vm->pc = vm->loops[vm->depth - 1].pc;
+                continue;
+            }
+            vm->depth--;
+            break;
+        }
+
+        case MOTION_OP_EMIT:
+            if (vm->emit && !vm->emit(vm, p[1], get_u16(p + 2), now, vm->emit_ctx))
+            {
+                motion_abort(vm);
+                vm->status = MOTION_DONE;
+                return vm->status;
+            }
+            break;
+        }
+        vm->pc += s_size[p[0]];
+    }
+    return vm->status;
+}
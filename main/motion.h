@@ -0,0 +1,131 @@
+#ifndef _MOTION_H_
+#define _MOTION_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "input_frame.h"
+
+/*
+ * Motion programs: precompiled bytecode for motor sequences such as the launch
+ * stroke, run by a small interpreter from the control tick. A running program is a
+ * motion_vm_t of a few dozen bytes stepped by a coop job, so programs on different
+ * motors run side by side without a task or stack of their own.
+ *
+ * Instructions are an opcode byte followed by fixed little-endian operands:
+ *
+ *   END                              0x00  end of program (last byte only)
+ *   MOVE motor dir duty16            0x01  drive; duty 0 = default duty, 0xffff = argument
+ *   STOP motor mode                  0x02  motor_stop_mode_t, 0xff = the motor's brake config
+ *   WAIT_LIMIT limit timeout_ms16    0x03  until limit switch 1..6 closes or the time is up
+ *   WAIT_MS ms16                     0x04
+ *   RAMP motor dir from16 to16 ms16  0x05  duty moves linearly, one step per tick
+ *   LOOP count                       0x06  repeat up to the matching NEXT, 0 = forever
+ *   NEXT                             0x07
+ *   EMIT code arg16                  0x08  calls the runner's emit hook, false ends the program
+ *
+ * Waits are re-checked once per control tick. WAIT_LIMIT sets a flag when it times
+ * out and the program goes on; the emit hook decides what a timeout means. A step
+ * runs at most MOTION_STEP_OPS instructions, so a loop without a wait cannot hold up
+ * the tick (forever loops without a wait are rejected by the validator).
+ *
+ * Source form and the host assembler: host/motion_asm.c, programs in host/progs/.
+ */
+
+#define MOTION_PROG_MAX     256     // bytecode bytes per program
+#define MOTION_LOOP_DEPTH   4
+#define MOTION_STEP_OPS     32
+#define MOTION_MOTORS       3
+#define MOTION_DUTY_DEFAULT 0
+#define MOTION_DUTY_ARG     0xffff
+#define MOTION_STOP_CONFIG  0xff
+
+typedef enum
+{
+    MOTION_OP_END,
+    MOTION_OP_MOVE,
+    MOTION_OP_STOP,
+    MOTION_OP_WAIT_LIMIT,
+    MOTION_OP_WAIT_MS,
+    MOTION_OP_RAMP,
+    MOTION_OP_LOOP,
+    MOTION_OP_NEXT,
+    MOTION_OP_EMIT,
+    MOTION_OP_COUNT,
+} motion_op_t;
+
+// C initializers for bytecode, e.g. MP_MOVE(0, 1, MOTION_DUTY_ARG)
+#define MP_U16(v)                       (uint8_t)((v) & 0xff), (uint8_t)(((v) >> 8) & 0xff)
+#define MP_END()                        MOTION_OP_END
+#define MP_MOVE(m, dir, duty)           MOTION_OP_MOVE, (m), (uint8_t)(dir), MP_U16(duty)
+#define MP_STOP(m, mode)                MOTION_OP_STOP, (m), (mode)
+#define MP_WAIT_LIMIT(n, ms)            MOTION_OP_WAIT_LIMIT, (n), MP_U16(ms)
+#define MP_WAIT_MS(ms)                  MOTION_OP_WAIT_MS, MP_U16(ms)
+#define MP_RAMP(m, dir, from, to, ms)   MOTION_OP_RAMP, (m), (uint8_t)(dir), MP_U16(from), MP_U16(to), MP_U16(ms)
+#define MP_LOOP(count)                  MOTION_OP_LOOP, (count)
+#define MP_NEXT()                       MOTION_OP_NEXT
+#define MP_EMIT(code, arg)              MOTION_OP_EMIT, (code), MP_U16(arg)
+
+typedef enum
+{
+    MOTION_OK,
+    MOTION_ERR_EMPTY,       // no code, or longer than MOTION_PROG_MAX
+    MOTION_ERR_OPCODE,      // unknown opcode
+    MOTION_ERR_TRUNCATED,   // operands run past the end
+    MOTION_ERR_OPERAND,     // motor, direction, duty, switch or time out of range
+    MOTION_ERR_NESTING,     // NEXT without LOOP, unclosed LOOP or deeper than MOTION_LOOP_DEPTH
+    MOTION_ERR_SPIN,        // forever loop without a wait
+    MOTION_ERR_END,         // END missing or not the last instruction
+} motion_err_t;
+
+typedef struct
+{
+    char name[16];
+    const uint8_t *code;
+    uint16_t len;
+    uint8_t motors;         // bit per motor the program drives (from the validator)
+} motion_prog_t;
+
+typedef enum
+{
+    MOTION_IDLE,
+    MOTION_RUNNING,
+    MOTION_DONE,            // reached END or the emit hook ended it
+    MOTION_ABORTED,
+} motion_status_t;
+
+typedef struct motion_vm motion_vm_t;
+typedef bool (*motion_emit_fn_t)(motion_vm_t *vm, uint8_t code, uint16_t arg, int64_t now, void *ctx);
+
+struct motion_vm
+{
+    const motion_prog_t *prog;
+    uint16_t pc;
+    uint8_t driving;        // motors this program has left moving
+    int8_t dir[MOTION_MOTORS]; // their direction
+    uint8_t depth;
+    motion_status_t status;
+    bool started;           // current wait or ramp has its start time
+    bool timed_out;         // the last WAIT_LIMIT ran out of time
+    int64_t start_us;
+    uint32_t arg;           // duty for MOVE ... MOTION_DUTY_ARG, set by the emit hook
+    struct
+    {
+        uint16_t pc;        // first instruction of the body
+        uint8_t left;       // passes still to run, 0 = forever
+    } loops[MOTION_LOOP_DEPTH];
+    motion_emit_fn_t emit;
+    void *emit_ctx;
+};
+
+motion_err_t motion_validate(const uint8_t *code, size_t len, uint8_t *motors, size_t *err_pc);
+const char *motion_err_name(motion_err_t err);
+size_t motion_disasm(const uint8_t *code, size_t len, size_t pc, char *out, size_t out_size); // next pc, 0 at the end
+
+void motion_start(motion_vm_t *vm, const motion_prog_t *prog, motion_emit_fn_t emit, void *ctx);
+motion_status_t motion_step(motion_vm_t *vm, const input_frame_t *in, int64_t now);
+void motion_abort(motion_vm_t *vm); // stops the motors it left moving
+bool motion_running(const motion_vm_t *vm);
+
+#endif // !_MOTION_H_
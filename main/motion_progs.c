@@ -0,0 +1,175 @@
+#include "motion_progs.h"
+#include <string.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "motor_control.h"
+
+static const char *TAG = "MOTION";
+
+#define MOTION_NVS_NAMESPACE    "motion"
+#define MOTION_USER_COUNT       (MOTION_PROG_COUNT - MOTION_BUILTIN_COUNT)
+
+//================================================================================
+// Built-in programs, sources in host/progs/*.mp
+//================================================================================
+// the launch sequence: stroke to limit 2 at the potentiometer duty, settle, return to limit 1
+#define LAUNCH_BODY                                                                 \
+    MP_EMIT(MOTION_EMIT_STROKE, 0),                                                 \
+    MP_MOVE(0, 1, MOTION_DUTY_ARG),                                                 \
+    MP_WAIT_LIMIT(2, 1000),                                                         \
+    MP_EMIT(MOTION_EMIT_STROKE_END, 0),                                             \
+    MP_STOP(0, MOTION_STOP_CONFIG),                                                 \
+    MP_WAIT_MS(100),                                                                \
+    MP_EMIT(MOTION_EMIT_RETURN, 0),                                                 \
+    MP_MOVE(0, -1, MOTION_DUTY_DEFAULT),                                            \
+    MP_WAIT_LIMIT(1, 1000),                                                         \
+    MP_EMIT(MOTION_EMIT_RETURN_END, 0),                                             \
+    MP_STOP(0, MOTION_STOP_CONFIG)
+
+static const uint8_t s_launch_code[] = {
+    LAUNCH_BODY,
+    MP_END(),
+};
+
+static const uint8_t s_burst3_code[] = {
+    MP_LOOP(3),
+    LAUNCH_BODY,
+    MP_WAIT_MS(500),
+    MP_NEXT(),
+    MP_END(),
+};
+
+// X axis sweep: ramp up towards limit 3, back to limit 4, slow approach to the middle
+static const uint8_t s_scan_x_code[] = {
+    MP_LOOP(2),
+    MP_RAMP(1, 1, 2000, 7000, 300),
+    MP_WAIT_LIMIT(3, 4000),
+    MP_STOP(1, MOTOR_STOP_BRAKE),
+    MP_WAIT_MS(200),
+    MP_RAMP(1, -1, 2000, 7000, 300),
+    MP_WAIT_LIMIT(4, 4000),
+    MP_STOP(1, MOTOR_STOP_BRAKE),
+    MP_WAIT_MS(200),
+    MP_NEXT(),
+    MP_EMIT(MOTION_EMIT_MARK, 1),
+    MP_MOVE(1, 1, 4000),
+    MP_WAIT_MS(600),
+    MP_STOP(1, MOTOR_STOP_RAMP),
+    MP_END(),
+};
+
+static const motion_prog_t s_builtin[MOTION_BUILTIN_COUNT] = {
+    {"launch", s_launch_code, sizeof(s_launch_code), 0x01},
+    {"burst3", s_burst3_code, sizeof(s_burst3_code), 0x01},
+    {"scan_x", s_scan_x_code, sizeof(s_scan_x_code), 0x02},
+};
+
+//================================================================================
+// User programs: NVS blob "p<id>" = name length, name, bytecode
+//================================================================================
+typedef struct
+{
+    motion_prog_t prog;
+    uint8_t code[MOTION_PROG_MAX];
+} user_prog_t;
+
+static user_prog_t s_user[MOTION_USER_COUNT];
+
+const motion_prog_t *motion_prog_get(uint8_t id)
+{
+    if (id == MOTION_PROG_NONE || id > MOTION_PROG_COUNT) return NULL;
+    if (id <= MOTION_BUILTIN_COUNT) return &s_builtin[id - 1];
+    const motion_prog_t *prog = &s_user[id - MOTION_BUILTIN_COUNT - 1].prog;
+    return (prog->len != 0) ? prog : NULL;
+}
+
+static void nvs_key(uint8_t id, char *key)
+{
+    key[0] = 'p';
+    key[1] = (char)('0' + id);
+    key[2] = '\0';
+}
+
+static bool user_id_ok(uint8_t id)
+{
+    return id > MOTION_BUILTIN_COUNT && id <= MOTION_PROG_COUNT;
+}
+
+// Runs before the control loop starts, programs stay fixed while it runs
+esp_err_t motion_prog_load(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(MOTION_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) return err;
+
+    uint8_t blob[1 + sizeof(s_user[0].prog.name) + MOTION_PROG_MAX];
+    for (uint8_t id = MOTION_BUILTIN_COUNT + 1; id <= MOTION_PROG_COUNT; id++)
+    {
+        user_prog_t *u = &s_user[id - MOTION_BUILTIN_COUNT - 1];
+        char key[4];
+        size_t size = sizeof(blob);
+        memset(u, 0, sizeof(*u));
+        nvs_key(id, key);
+        if (nvs_get_blob(nvs, key, blob, &size) != ESP_OK) continue;
+
+        uint8_t name_len = blob[0];
+        if (size < 2u + name_len || name_len >= sizeof(u->prog.name))
+        {
+            ESP_LOGW(TAG, "Program %d: bad record", id);
+            continue;
+        }
+        size_t len = size - 1 - name_len, err_pc = 0;
+        uint8_t motors = 0;
+        motion_err_t verr = motion_validate(blob + 1 + name_len, len, &motors, &err_pc);
+        if (verr != MOTION_OK)
+        {
+            ESP_LOGW(TAG, "Program %d: %s at %d, not loaded", id, motion_err_name(verr), (int)err_pc);
+            continue;
+        }
+        memcpy(u->prog.name, blob + 1, name_len);
+        memcpy(u->code, blob + 1 + name_len, len);
+        u->prog.code = u->code;
+        u->prog.len = (uint16_t)len;
+        u->prog.motors = motors;
+        ESP_LOGI(TAG, "Program %d \"%s\": %d bytes, motors 0x%x", id, u->prog.name, (int)len, motors);
+    }
+    nvs_close(nvs);
+    return ESP_OK;
+}
+
+esp_err_t motion_prog_store(uint8_t id, const char *name, const uint8_t *code, size_t len)
+{
+    size_t name_len = strlen(name);
+    if (!user_id_ok(id) || name_len == 0 || name_len >= sizeof(s_user[0].prog.name)) return ESP_ERR_INVALID_ARG;
+    if (motion_validate(code, len, NULL, NULL) != MOTION_OK) return ESP_ERR_INVALID_ARG;
+
+    uint8_t blob[1 + sizeof(s_user[0].prog.name) + MOTION_PROG_MAX];
+    blob[0] = (uint8_t)name_len;
+    memcpy(blob + 1, name, name_len);
+    memcpy(blob + 1 + name_len, code, len);
+
+    nvs_handle_t nvs;
+    char key[4];
+    esp_err_t err = nvs_open(MOTION_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+    nvs_key(id, key);
+    err = nvs_set_blob(nvs, key, blob, 1 + name_len + len);
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+    return err;
+}
+
+esp_err_t motion_prog_erase(uint8_t id)
+{
+    if (!user_id_ok(id)) return ESP_ERR_INVALID_ARG;
+
+    nvs_handle_t nvs;
+    char key[4];
+    esp_err_t err = nvs_open(MOTION_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+    nvs_key(id, key);
+    err = nvs_erase_key(nvs, key);
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+    return err;
+}
@@ -0,0 +1,43 @@
+#ifndef _MOTION_PROGS_H_
+#define _MOTION_PROGS_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "motion.h"
+
+/*
+ * Program library. Ids 1..MOTION_BUILTIN_COUNT are built into flash (sources in
+ * host/progs/), the rest are user programs kept in NVS. User programs are validated
+ * and loaded at boot only, so a program never changes under a running interpreter;
+ * a stored program takes effect after the next restart.
+ *
+ * The launch key runs program `launch_prog`, key 3 runs `key3_prog` (0 = random
+ * mode), both tuning parameters. Selection is recorded, so replay runs the same
+ * built-in programs; user programs are not part of a recording. While a key 3
+ * program runs, any motor it left moving is braked at the limit switch in its
+ * direction (launcher: forward limit 2, reverse limit 1; aim axes: 3/4 and 5/6).
+ *
+ * EMIT codes understood by the control core:
+ */
+
+typedef enum
+{
+    MOTION_EMIT_STROKE = 1,     // launch stroke begins: carriage must rest on limit 1, stroke duty -> argument
+    MOTION_EMIT_STROKE_END,     // after the wait for limit 2: latency, stroke timing, timeout report
+    MOTION_EMIT_RETURN,         // before the return stroke: limit 1 must have opened
+    MOTION_EMIT_RETURN_END,     // after the wait for limit 1
+    MOTION_EMIT_MARK,           // logs the argument
+} motion_emit_code_t;
+
+#define MOTION_PROG_NONE        0
+#define MOTION_PROG_LAUNCH      1
+#define MOTION_BUILTIN_COUNT    3
+#define MOTION_PROG_COUNT       7   // highest program id
+
+const motion_prog_t *motion_prog_get(uint8_t id); // NULL for an empty or unknown id
+esp_err_t motion_prog_load(void);
+esp_err_t motion_prog_store(uint8_t id, const char *name, const uint8_t *code, size_t len); // validates first
+esp_err_t motion_prog_erase(uint8_t id);
+
+#endif // !_MOTION_PROGS_H_
@@ -9,6 +9,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "bdc_motor.h"
+#include "lat_hist.h"
 
 const static char *TAG = "MOTOR_CONTROL";
 
@@ -19,18 +20,105 @@ const static char *TAG = "MOTOR_CONTROL";
 #define MOTOR_L3 GPIO_NUM_19
 #define MOTOR_R3 GPIO_NUM_21
 
-#define TIMER_RESOLUTION_HZ     10000000 // 1MHz, 1us per tick
-#define PWM_FREQUENCY_HZ        25000      // 25kHz Ƶ
-#define MOTOR_DUTY_TICK_MAX     (TIMER_RESOLUTION_HZ / PWM_FREQUENCY_HZ ) // 400 ticks (1 tick = 0.1us)
+#define TIMER_RESOLUTION_HZ     10000000 // 10MHz, 0.1us per tick
+#define PWM_FREQUENCY_HZ        25000      // 25kHz 默认频率, 可运行时按电机修改
+#define PWM_FREQUENCY_MIN_HZ    200        // 周期不超过 16 位计数器 (50000 ticks)
+#define PWM_FREQUENCY_MAX_HZ    100000     // 周期不少于 100 ticks
+#define MOTOR_DITHER_PERIOD_US  500        // 占空比抖动更新周期 (2kHz)
+#define MOTOR_DITHER_AVG_US     20000      // 报告抖动分辨率时的平均时间 (一个控制节拍)
 
-#define MOTOR_DUTY_CYCLE_PERCENT  90   // 90% ռձ
-#define MOTOR_SPEED_TICKS       ((MOTOR_DUTY_TICK_MAX * MOTOR_DUTY_CYCLE_PERCENT) / 100)
+#define MOTOR_DUTY_CYCLE_PERCENT  90   // 90% 占空比 (上电默认值, 运行时由 motor_set_default_duty 修改)
+#define MOTOR_DUTY_DEFAULT      motor_duty_default
+
+// 软限位: 接近行程端点时减速, 到达端点估计位置后拒绝继续向该端运动
+#define MOTOR_SLOW_DUTY_PERCENT   35   // 减速区占空比
+#define MOTOR_SLOW_DUTY           (MOTOR_SLOW_DUTY_PERCENT * MOTOR_DUTY_SCALE / 100)
+#define MOTOR_SLOW_ZONE           (MOTOR_POS_FULL / 10)  // 距端点10%进入减速区
+#define MOTOR_SOFT_LIMIT_MARGIN   (MOTOR_POS_FULL / 100) // 距端点1%视为已到端点
+
+// 停止方式默认值
+#define MOTOR_RAMP_STOP_MS_DEFAULT      60   // 斜坡停止最长时间, 到时后刹车
+#define MOTOR_REVERSE_DEAD_MS_DEFAULT   30   // 换向前的滑行间隔
+#define MOTOR_RAMP_STEP_US              5000 // 斜坡步进周期
 
 const uint32_t motor_gpio_a[3] = {MOTOR_L1, MOTOR_L2, MOTOR_L3};
 const uint32_t motor_gpio_b[3] = {MOTOR_R1, MOTOR_R2, MOTOR_R3};
 
 bdc_motor_handle_t motors[3] = {NULL};
 static esp_timer_handle_t motor_stop_timers[3] = {NULL};
+static esp_timer_handle_t motor_zone_timers[3] = {NULL};
+static esp_timer_handle_t motor_ramp_timers[3] = {NULL};
+static esp_timer_handle_t motor_reverse_timers[3] = {NULL};
+static esp_timer_handle_t motor_dither_timer = NULL;
+
+// PWM 设置: 周期 ticks = TIMER_RESOLUTION_HZ / 频率
+static uint32_t motor_pwm_freq[3] = {PWM_FREQUENCY_HZ, PWM_FREQUENCY_HZ, PWM_FREQUENCY_HZ};
+static uint32_t motor_period_ticks[3] = {TIMER_RESOLUTION_HZ / PWM_FREQUENCY_HZ, TIMER_RESOLUTION_HZ / PWM_FREQUENCY_HZ,
+                                         TIMER_RESOLUTION_HZ / PWM_FREQUENCY_HZ};
+// sigma-delta 抖动: 累加占空比的小数部分, 溢出时本周期多输出一个 tick
+static bool motor_dither_en[3] = {false};
+static uint32_t motor_dither_acc[3] = {0};
+static uint32_t motor_last_ticks[3] = {0};
+static uint32_t motor_duty_default = MOTOR_DUTY_CYCLE_PERCENT * MOTOR_DUTY_SCALE / 100;
+static bool motor_suspended = false;
+
+static motor_brake_config_t motor_brake_cfg[3] = {
+    {.mode = MOTOR_STOP_BRAKE, .ramp_ms = MOTOR_RAMP_STOP_MS_DEFAULT, .reverse_dead_ms = MOTOR_REVERSE_DEAD_MS_DEFAULT},
+    {.mode = MOTOR_STOP_BRAKE, .ramp_ms = MOTOR_RAMP_STOP_MS_DEFAULT, .reverse_dead_ms = MOTOR_REVERSE_DEAD_MS_DEFAULT},
+    {.mode = MOTOR_STOP_BRAKE, .ramp_ms = MOTOR_RAMP_STOP_MS_DEFAULT, .reverse_dead_ms = MOTOR_REVERSE_DEAD_MS_DEFAULT},
+};
+
+// 按运行时间估计的轴位置, 行程时间为0表示该电机不做位置跟踪
+typedef struct
+{
+    uint32_t travel_fwd_us; // 反向端 -> 正向端 全速行程时间
+    uint32_t travel_rev_us; // 正向端 -> 反向端 全速行程时间
+    uint32_t travel_duty;   // 测量行程时的默认占空比
+    int32_t pos;            // 0 .. MOTOR_POS_FULL, -1 未知
+    int8_t dir;             // 1 正转, -1 反转, 0 停止
+    uint32_t duty;          // 当前占空比 (MOTOR_DUTY_SCALE)
+    int64_t last_us;        // 上次积分时间
+    bool ramping;           // 斜坡停止进行中
+    uint32_t ramp_duty;     // 斜坡起始占空比
+    int64_t ramp_start_us;
+    int8_t pending_dir;     // 换向间隔结束后要执行的方向, 0 表示无
+    uint32_t pending_duty;
+} motor_track_t;
+
+static motor_track_t motor_track[3] = {
+    {.pos = MOTOR_POS_UNKNOWN}, {.pos = MOTOR_POS_UNKNOWN}, {.pos = MOTOR_POS_UNKNOWN},
+};
+static portMUX_TYPE motor_track_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 命令回调: 每个公开的启动/停止调用在执行前报告一次
+static motor_cmd_hook_t motor_cmd_hook = NULL;
+static void *motor_cmd_hook_arg = NULL;
+
+static void motor_emit_cmd(uint8_t motor_index, int8_t dir, uint32_t duty, motor_stop_mode_t mode)
+{
+    motor_cmd_hook_t hook = motor_cmd_hook;
+    if (hook != NULL)
+    {
+        motor_cmd_t cmd = {.motor = motor_index, .dir = dir, .duty = duty, .stop_mode = mode};
+        hook(&cmd, motor_cmd_hook_arg);
+    }
+}
+
+static inline uint32_t motor_duty_to_ticks(uint8_t motor_index, uint32_t duty, uint32_t *frac)
+{
+    uint64_t prod = (uint64_t)duty * motor_period_ticks[motor_index];
+    if (frac) *frac = (uint32_t)(prod % MOTOR_DUTY_SCALE);
+    return (uint32_t)(prod / MOTOR_DUTY_SCALE);
+}
+
+// 输出新占空比, 并复位抖动累加器
+static void motor_apply_duty(uint8_t motor_index, uint32_t duty)
+{
+    uint32_t ticks = motor_duty_to_ticks(motor_index, duty, NULL);
+    motor_dither_acc[motor_index] = 0;
+    motor_last_ticks[motor_index] = ticks;
+    bdc_motor_set_speed(motors[motor_index], ticks);
+}
 
 static void motor_stop_cb(void *arg)
 {
@@ -39,24 +127,282 @@ static void motor_stop_cb(void *arg)
     motor_stop(motor_index);
 }
 
-void motor_init()
+static bool motor_track_enabled(const motor_track_t *t)
 {
-    ESP_LOGI(TAG, "Initializing motors...");
+    return (t->travel_fwd_us > 0) && (t->travel_rev_us > 0) && (t->pos != MOTOR_POS_UNKNOWN);
+}
+
+// 将上次积分以来的运行时间累加到位置估计, 调用者持有 motor_track_lock
+static void motor_track_integrate(motor_track_t *t, int64_t now_us)
+{
+    if (motor_track_enabled(t) && (t->dir != 0) && (t->duty > 0))
+    {
+        int64_t elapsed = now_us - t->last_us;
+        uint32_t travel = (t->dir > 0) ? t->travel_fwd_us : t->travel_rev_us;
+        // 行程时间按默认占空比测得, 其他占空比近似按比例折算
+        int64_t delta = elapsed * MOTOR_POS_FULL * t->duty / ((int64_t)travel * t->travel_duty);
+        int64_t pos = t->pos + t->dir * delta;
+        if (pos < 0) pos = 0;
+        if (pos > MOTOR_POS_FULL) pos = MOTOR_POS_FULL;
+        t->pos = (int32_t)pos;
+    }
+    t->last_us = now_us;
+}
+
+// 按当前方向和占空比计算到下一个端点事件的时间: 减速区外为到减速区, 区内为到软限位; 0 表示无需定时
+// 调用者持有 motor_track_lock
+static int64_t motor_zone_delay_us(const motor_track_t *t)
+{
+    if (!motor_track_enabled(t) || (t->dir == 0) || (t->duty == 0) || t->ramping) return 0;
+    int32_t remaining = (t->dir > 0) ? (MOTOR_POS_FULL - t->pos) : t->pos;
+    int32_t target = ((remaining > MOTOR_SLOW_ZONE) && (t->duty > MOTOR_SLOW_DUTY)) ? MOTOR_SLOW_ZONE : MOTOR_SOFT_LIMIT_MARGIN;
+    if (remaining <= target) return 1;
+    uint32_t travel = (t->dir > 0) ? t->travel_fwd_us : t->travel_rev_us;
+    int64_t den = (int64_t)MOTOR_POS_FULL * t->duty;
+    // 向上取整, 保证到期时积分出的位置已越过目标点
+    return ((int64_t)(remaining - target) * travel * t->travel_duty + den - 1) / den;
+}
+
+// 端点定时器到期: 进入减速区时降为低速, 到达软限位时刹车, 否则按剩余距离重新定时
+// 长时间的单个命令不会再有新命令触发 motor_drive 中的检查, 由此处保证不以低速撞上限位器
+static void motor_zone_cb(void *arg)
+{
+    uint8_t motor_index = (uint8_t)(intptr_t)arg;
+    motor_track_t *t = &motor_track[motor_index];
+    bool slow = false;
+    bool stop = false;
+
+    taskENTER_CRITICAL(&motor_track_lock);
+    motor_track_integrate(t, esp_timer_get_time());
+    if (motor_track_enabled(t) && (t->dir != 0) && !t->ramping)
+    {
+        int32_t remaining = (t->dir > 0) ? (MOTOR_POS_FULL - t->pos) : t->pos;
+        if (remaining <= MOTOR_SOFT_LIMIT_MARGIN)
+        {
+            stop = true;
+            t->dir = 0;
+            t->duty = 0;
+        }
+        else if ((remaining <= MOTOR_SLOW_ZONE) && (t->duty > MOTOR_SLOW_DUTY))
+        {
+            slow = true;
+            t->duty = MOTOR_SLOW_DUTY;
+        }
+    }
+    int64_t delay_us = motor_zone_delay_us(t);
+    taskEXIT_CRITICAL(&motor_track_lock);
+
+    if (stop)
+    {
+        ESP_LOGD(TAG, "Motor %d stopped at soft limit", motor_index);
+        bdc_motor_brake(motors[motor_index]);
+        lat_hist_actuated(motor_index, LAT_ACT_STOP, esp_timer_get_time());
+        return;
+    }
+    if (slow)
+    {
+        ESP_LOGD(TAG, "Motor %d entering slow zone", motor_index);
+        motor_apply_duty(motor_index, MOTOR_SLOW_DUTY);
+    }
+    if (delay_us > 0)
+    {
+        esp_timer_start_once(motor_zone_timers[motor_index], delay_us);
+    }
+}
+
+// 斜坡停止步进: 占空比随时间线性降到0, 到达限定时间后刹车
+static void motor_ramp_cb(void *arg)
+{
+    uint8_t motor_index = (uint8_t)(intptr_t)arg;
+    motor_track_t *t = &motor_track[motor_index];
+    int64_t now = esp_timer_get_time();
+    int64_t ramp_us = (int64_t)motor_brake_cfg[motor_index].ramp_ms * 1000;
+    bool finished = false;
+    uint32_t duty = 0;
+
+    taskENTER_CRITICAL(&motor_track_lock);
+    if (!t->ramping)
+    {
+        taskEXIT_CRITICAL(&motor_track_lock);
+        return;
+    }
+    motor_track_integrate(t, now);
+    int64_t elapsed = now - t->ramp_start_us;
+    if (elapsed >= ramp_us)
+    {
+        finished = true;
+        t->ramping = false;
+        t->dir = 0;
+        t->duty = 0;
+    }
+    else
+    {
+        duty = (uint32_t)(t->ramp_duty * (ramp_us - elapsed) / ramp_us);
+        t->duty = duty;
+    }
+    taskEXIT_CRITICAL(&motor_track_lock);
+
+    if (finished)
+    {
+        esp_timer_stop(motor_ramp_timers[motor_index]);
+        bdc_motor_brake(motors[motor_index]);
+        lat_hist_actuated(motor_index, LAT_ACT_STOP, esp_timer_get_time());
+    }
+    else
+    {
+        motor_apply_duty(motor_index, duty);
+    }
+}
+
+static esp_err_t motor_drive(uint8_t motor_index, int8_t dir, uint32_t duty);
 
+// 抖动定时器: 对开启抖动且在运行的电机, 用一阶 sigma-delta 在相邻窗口间切换 n / n+1 ticks
+static void motor_dither_cb(void *arg)
+{
     for (int i = 0; i < 3; i++)
     {
-        bdc_motor_config_t motor_config = {
-            .pwm_freq_hz = PWM_FREQUENCY_HZ,
-            .pwma_gpio_num = motor_gpio_a[i],
-            .pwmb_gpio_num = motor_gpio_b[i],
-        };
+        if (!motor_dither_en[i]) continue;
 
-        bdc_motor_mcpwm_config_t mcpwm_config = {
-            .group_id = 0, 
-            .resolution_hz = TIMER_RESOLUTION_HZ,
-        };
+        taskENTER_CRITICAL(&motor_track_lock);
+        bool running = (motor_track[i].dir != 0) && (motor_track[i].pending_dir == 0);
+        uint32_t duty = motor_track[i].duty;
+        taskEXIT_CRITICAL(&motor_track_lock);
+        if (!running || duty == 0) continue;
+
+        uint32_t frac;
+        uint32_t ticks = motor_duty_to_ticks(i, duty, &frac);
+        motor_dither_acc[i] += frac;
+        if (motor_dither_acc[i] >= MOTOR_DUTY_SCALE)
+        {
+            motor_dither_acc[i] -= MOTOR_DUTY_SCALE;
+            ticks++;
+        }
+        if (ticks != motor_last_ticks[i])
+        {
+            motor_last_ticks[i] = ticks;
+            bdc_motor_set_speed(motors[i], ticks);
+        }
+    }
+}
+
+// 换向间隔结束, 按保存的方向和占空比启动
+static void motor_reverse_cb(void *arg)
+{
+    uint8_t motor_index = (uint8_t)(intptr_t)arg;
+    motor_track_t *t = &motor_track[motor_index];
+
+    taskENTER_CRITICAL(&motor_track_lock);
+    int8_t dir = t->pending_dir;
+    uint32_t duty = t->pending_duty;
+    t->pending_dir = 0;
+    taskEXIT_CRITICAL(&motor_track_lock);
+
+    if (dir != 0)
+    {
+        motor_drive(motor_index, dir, duty);
+    }
+}
+
+// 按方向启动电机, 换向时先滑行一段间隔; 对跟踪中的轴执行软限位和端点减速
+static esp_err_t motor_drive(uint8_t motor_index, int8_t dir, uint32_t duty)
+{
+    motor_track_t *t = &motor_track[motor_index];
+    uint32_t slow = (duty < MOTOR_SLOW_DUTY) ? duty : MOTOR_SLOW_DUTY;
+    uint32_t dead_ms = motor_brake_cfg[motor_index].reverse_dead_ms;
+    int64_t zone_delay_us = 0;
+    bool rejected = false;
+
+    taskENTER_CRITICAL(&motor_track_lock);
+    motor_track_integrate(t, esp_timer_get_time());
+    if (t->pending_dir != 0)
+    {
+        // 换向间隔内只更新待执行的命令
+        t->pending_dir = dir;
+        t->pending_duty = duty;
+        taskEXIT_CRITICAL(&motor_track_lock);
+        return ESP_OK;
+    }
+    if ((t->dir == -dir) && (dead_ms > 0))
+    {
+        t->dir = 0;
+        t->duty = 0;
+        t->ramping = false;
+        t->pending_dir = dir;
+        t->pending_duty = duty;
+        taskEXIT_CRITICAL(&motor_track_lock);
+
+        esp_timer_stop(motor_zone_timers[motor_index]);
+        esp_timer_stop(motor_ramp_timers[motor_index]);
+        ESP_ERROR_CHECK(bdc_motor_coast(motors[motor_index]));
+        ESP_ERROR_CHECK(esp_timer_start_once(motor_reverse_timers[motor_index], (uint64_t)dead_ms * 1000));
+        return ESP_OK;
+    }
+    t->ramping = false;
+    if (motor_track_enabled(t))
+    {
+        int32_t remaining = (dir > 0) ? (MOTOR_POS_FULL - t->pos) : t->pos;
+        if (remaining <= MOTOR_SOFT_LIMIT_MARGIN)
+        {
+            rejected = true;
+        }
+        else if (remaining <= MOTOR_SLOW_ZONE)
+        {
+            duty = slow;
+        }
+        else if ((t->dir == dir) && (t->duty == slow))
+        {
+            duty = slow; // 同方向重复命令, 保持已进入的减速
+        }
+    }
+    t->dir = rejected ? 0 : dir;
+    t->duty = rejected ? 0 : duty;
+    // 每个命令都按新的方向和速度重新计算端点定时 (同方向加速时旧的延时会让轴全速冲进端点)
+    zone_delay_us = motor_zone_delay_us(t);
+    taskEXIT_CRITICAL(&motor_track_lock);
+
+    esp_timer_stop(motor_ramp_timers[motor_index]);
+    esp_timer_stop(motor_zone_timers[motor_index]);
+    if (rejected)
+    {
+        ESP_LOGD(TAG, "Motor %d command rejected at soft limit", motor_index);
+        ESP_ERROR_CHECK(bdc_motor_brake(motors[motor_index]));
+        lat_hist_actuated(motor_index, LAT_ACT_STOP, esp_timer_get_time());
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_ERROR_CHECK((dir > 0) ? bdc_motor_forward(motors[motor_index]) : bdc_motor_reverse(motors[motor_index]));
+    motor_apply_duty(motor_index, duty);
+    lat_hist_actuated(motor_index, LAT_ACT_DRIVE, esp_timer_get_time()); // 输入到执行的延迟统计
+    if (zone_delay_us > 0)
+    {
+        esp_timer_start_once(motor_zone_timers[motor_index], zone_delay_us);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t motor_new_device(uint8_t motor_index)
+{
+    bdc_motor_config_t motor_config = {
+        .pwm_freq_hz = motor_pwm_freq[motor_index],
+        .pwma_gpio_num = motor_gpio_a[motor_index],
+        .pwmb_gpio_num = motor_gpio_b[motor_index],
+    };
+
+    bdc_motor_mcpwm_config_t mcpwm_config = {
+        .group_id = 0, 
+        .resolution_hz = TIMER_RESOLUTION_HZ,
+    };
+
+    return bdc_motor_new_mcpwm_device(&motor_config, &mcpwm_config, &motors[motor_index]);
+}
+
+void motor_init()
+{
+    ESP_LOGI(TAG, "Initializing motors...");
 
-        ESP_ERROR_CHECK(bdc_motor_new_mcpwm_device(&motor_config, &mcpwm_config, &motors[i]));
+    for (int i = 0; i < 3; i++)
+    {
+        ESP_ERROR_CHECK(motor_new_device(i));
     }
 
     for (int i = 0; i < 3; i++)
@@ -72,8 +418,35 @@ void motor_init()
             .name = "motor_stop_timers"
         };
         ESP_ERROR_CHECK(esp_timer_create(&timer_args, &motor_stop_timers[i]));
+
+        esp_timer_create_args_t zone_args = {
+            .callback = &motor_zone_cb,
+            .arg = (void *)(intptr_t)i,
+            .name = "motor_zone_timers"
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&zone_args, &motor_zone_timers[i]));
+
+        esp_timer_create_args_t ramp_args = {
+            .callback = &motor_ramp_cb,
+            .arg = (void *)(intptr_t)i,
+            .name = "motor_ramp_timers"
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&ramp_args, &motor_ramp_timers[i]));
+
+        esp_timer_create_args_t reverse_args = {
+            .callback = &motor_reverse_cb,
+            .arg = (void *)(intptr_t)i,
+            .name = "motor_reverse_timers"
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&reverse_args, &motor_reverse_timers[i]));
     }
 
+    esp_timer_create_args_t dither_args = {
+        .callback = &motor_dither_cb,
+        .name = "motor_dither_timer"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&dither_args, &motor_dither_timer));
+
     ESP_LOGI(TAG, "Motor initialization completed.");
 }
 
@@ -91,11 +464,14 @@ void motor_forward_for_duration(uint8_t motor_index, uint32_t duration_ms)
     {
         esp_timer_stop(motor_stop_timers[motor_index]);
     }
-    // 
-    ESP_ERROR_CHECK(bdc_motor_forward(motors[motor_index]));
-    ESP_ERROR_CHECK(bdc_motor_set_speed(motors[motor_index], MOTOR_SPEED_TICKS));
+    // 启动电机
+    motor_emit_cmd(motor_index, 1, MOTOR_DUTY_DEFAULT, MOTOR_STOP_BRAKE);
+    if (motor_drive(motor_index, 1, MOTOR_DUTY_DEFAULT) != ESP_OK)
+    {
+        return;
+    }
 
-    // һԶʱʱ䵥λ΢ (us)
+    // 启动一次性定时器，时间单位是微秒 (us)
     ESP_ERROR_CHECK(esp_timer_start_once(motor_stop_timers[motor_index], duration_ms * 1000));
 }
 
@@ -111,11 +487,14 @@ void motor_reverse_for_duration(uint8_t motor_index, uint32_t duration_ms)
     {
         esp_timer_stop(motor_stop_timers[motor_index]);
     }
-    // 
-    ESP_ERROR_CHECK(bdc_motor_reverse(motors[motor_index]));
-    ESP_ERROR_CHECK(bdc_motor_set_speed(motors[motor_index], MOTOR_SPEED_TICKS));
+    // 启动电机
+    motor_emit_cmd(motor_index, -1, MOTOR_DUTY_DEFAULT, MOTOR_STOP_BRAKE);
+    if (motor_drive(motor_index, -1, MOTOR_DUTY_DEFAULT) != ESP_OK)
+    {
+        return;
+    }
 
-    // һԶʱʱ䵥λ΢ (us)
+    // 启动一次性定时器，时间单位是微秒 (us)
     ESP_ERROR_CHECK(esp_timer_start_once(motor_stop_timers[motor_index], duration_ms * 1000));
 }
 
@@ -125,28 +504,265 @@ void motor_stop(uint8_t motor_index)
         ESP_LOGE(TAG, "Invalid motor index: %d", motor_index);
         return;
     }
+    motor_stop_mode(motor_index, motor_brake_cfg[motor_index].mode);
+}
+
+// 按指定方式停止电机: 刹车 (两个下管导通), 滑行 (全部关断), 或斜坡降速后刹车
+void motor_stop_mode(uint8_t motor_index, motor_stop_mode_t mode)
+{
+    if (motor_index >= 3) {
+        ESP_LOGE(TAG, "Invalid motor index: %d", motor_index);
+        return;
+    }
+    motor_track_t *t = &motor_track[motor_index];
+    motor_emit_cmd(motor_index, 0, 0, mode);
 
-    // ʱУֹֹͣͻ
+    // 如果定时器还在运行，先停止它，防止冲突
     if (esp_timer_is_active(motor_stop_timers[motor_index])) {
         esp_timer_stop(motor_stop_timers[motor_index]);
     }
+    esp_timer_stop(motor_zone_timers[motor_index]);
+    esp_timer_stop(motor_reverse_timers[motor_index]);
 
-    // ֹͣ
-    ESP_ERROR_CHECK(bdc_motor_brake(motors[motor_index]));
+    taskENTER_CRITICAL(&motor_track_lock);
+    motor_track_integrate(t, esp_timer_get_time());
+    t->pending_dir = 0;
+    if (mode == MOTOR_STOP_RAMP)
+    {
+        // 已在停止或斜坡中时不重新开始
+        bool start_ramp = (t->dir != 0) && !t->ramping && (motor_brake_cfg[motor_index].ramp_ms > 0);
+        if (start_ramp)
+        {
+            t->ramping = true;
+            t->ramp_duty = t->duty;
+            t->ramp_start_us = t->last_us;
+        }
+        bool idle = (t->dir == 0);
+        taskEXIT_CRITICAL(&motor_track_lock);
+
+        if (start_ramp)
+        {
+            ESP_ERROR_CHECK(esp_timer_start_periodic(motor_ramp_timers[motor_index], MOTOR_RAMP_STEP_US));
+        }
+        else if (idle || motor_brake_cfg[motor_index].ramp_ms == 0)
+        {
+            ESP_ERROR_CHECK(bdc_motor_brake(motors[motor_index]));
+            lat_hist_actuated(motor_index, LAT_ACT_STOP, esp_timer_get_time());
+        }
+        return;
+    }
+    t->ramping = false;
+    t->dir = 0;
+    t->duty = 0;
+    taskEXIT_CRITICAL(&motor_track_lock);
+
+    // 停止电机
+    esp_timer_stop(motor_ramp_timers[motor_index]);
+    if (mode == MOTOR_STOP_COAST)
+    {
+        ESP_ERROR_CHECK(bdc_motor_coast(motors[motor_index]));
+    }
+    else
+    {
+        ESP_ERROR_CHECK(bdc_motor_brake(motors[motor_index]));
+    }
+    lat_hist_actuated(motor_index, LAT_ACT_STOP, esp_timer_get_time());
+}
+
+// 设置电机默认停止方式、斜坡时间和换向间隔
+void motor_set_brake_config(uint8_t motor_index, const motor_brake_config_t *cfg)
+{
+    if (motor_index >= 3 || cfg == NULL) return;
+    motor_brake_cfg[motor_index] = *cfg;
+}
+
+// 直接启动电机正转，不设定时间，直到手动调用 motor_stop
+esp_err_t motor_start_forward(uint8_t motor_index)
+{
+    if (motor_index >= 3) return ESP_ERR_INVALID_ARG;
+    motor_emit_cmd(motor_index, 1, MOTOR_DUTY_DEFAULT, MOTOR_STOP_BRAKE);
+    return motor_drive(motor_index, 1, MOTOR_DUTY_DEFAULT);
+}
+
+// 持续反转，直到手动调用 motor_stop
+esp_err_t motor_start_reverse(uint8_t motor_index)
+{
+    if (motor_index >= 3) return ESP_ERR_INVALID_ARG;
+    motor_emit_cmd(motor_index, -1, MOTOR_DUTY_DEFAULT, MOTOR_STOP_BRAKE);
+    return motor_drive(motor_index, -1, MOTOR_DUTY_DEFAULT);
+}
+
+// 按指定方向和占空比启动电机 (dir: 1 正转, -1 反转; duty: 0..MOTOR_DUTY_SCALE)
+esp_err_t motor_start_duty(uint8_t motor_index, int8_t dir, uint32_t duty)
+{
+    if (motor_index >= 3 || dir == 0) return ESP_ERR_INVALID_ARG;
+    if (duty > MOTOR_DUTY_SCALE) duty = MOTOR_DUTY_SCALE;
+    if (duty == 0)
+    {
+        motor_stop(motor_index);
+        return ESP_OK;
+    }
+    motor_emit_cmd(motor_index, dir, duty, MOTOR_STOP_BRAKE);
+    return motor_drive(motor_index, dir, duty);
+}
+
+// 修改默认占空比, 由控制逻辑在节拍边界调用
+void motor_set_default_duty(uint32_t duty)
+{
+    if (duty == 0 || duty > MOTOR_DUTY_SCALE) return;
+    motor_duty_default = duty;
 }
 
-// ֱת趨ʱ䣬ֱֶ motor_stop
-void motor_start_forward(uint8_t motor_index)
+// 读取当前默认占空比, 供行程测量记录测量时的速度
+uint32_t motor_get_default_duty(void)
+{
+    return motor_duty_default;
+}
+
+// 设置轴的行程时间及测量时的占空比 (0 按当前默认占空比), 任一时间为0则关闭该轴的位置跟踪与软限位
+void motor_set_travel(uint8_t motor_index, uint32_t travel_fwd_us, uint32_t travel_rev_us, uint32_t travel_duty)
 {
     if (motor_index >= 3) return;
-    ESP_ERROR_CHECK(bdc_motor_forward(motors[motor_index]));
-    ESP_ERROR_CHECK(bdc_motor_set_speed(motors[motor_index], MOTOR_SPEED_TICKS));
+    taskENTER_CRITICAL(&motor_track_lock);
+    motor_track_integrate(&motor_track[motor_index], esp_timer_get_time());
+    motor_track[motor_index].travel_fwd_us = travel_fwd_us;
+    motor_track[motor_index].travel_rev_us = travel_rev_us;
+    motor_track[motor_index].travel_duty = travel_duty ? travel_duty : MOTOR_DUTY_DEFAULT;
+    taskEXIT_CRITICAL(&motor_track_lock);
+}
+
+// 用已知位置 (如限位器触发) 校正位置估计, MOTOR_POS_UNKNOWN 表示失去位置
+void motor_track_sync(uint8_t motor_index, int32_t pos)
+{
+    if (motor_index >= 3) return;
+    taskENTER_CRITICAL(&motor_track_lock);
+    motor_track[motor_index].pos = pos;
+    motor_track[motor_index].last_us = esp_timer_get_time();
+    taskEXIT_CRITICAL(&motor_track_lock);
+}
+
+int32_t motor_get_position(uint8_t motor_index)
+{
+    if (motor_index >= 3) return MOTOR_POS_UNKNOWN;
+    taskENTER_CRITICAL(&motor_track_lock);
+    motor_track_integrate(&motor_track[motor_index], esp_timer_get_time());
+    int32_t pos = motor_track_enabled(&motor_track[motor_index]) ? motor_track[motor_index].pos : MOTOR_POS_UNKNOWN;
+    taskEXIT_CRITICAL(&motor_track_lock);
+    return pos;
+}
+
+// 空闲省电: 停用 MCPWM 定时器, 其电源锁会阻止 light sleep; 电机须处于停止状态, 输出保持停止时的电平
+bool motor_busy(void)
+{
+    bool busy = false;
+    taskENTER_CRITICAL(&motor_track_lock);
+    for (int i = 0; i < 3; i++)
+    {
+        busy = busy || (motor_track[i].dir != 0) || (motor_track[i].pending_dir != 0) || motor_track[i].ramping;
+    }
+    taskEXIT_CRITICAL(&motor_track_lock);
+    return busy;
+}
+
+static bool motor_dither_any(void)
+{
+    return motor_dither_en[0] || motor_dither_en[1] || motor_dither_en[2];
+}
+
+// 挂起时同时停止抖动定时器, 否则周期定时器让自动 light sleep 无法进入
+esp_err_t motor_suspend(bool suspend)
+{
+    if (suspend == motor_suspended) return ESP_OK;
+    if (suspend && motor_busy()) return ESP_ERR_INVALID_STATE;
+    if (suspend && esp_timer_is_active(motor_dither_timer)) ESP_ERROR_CHECK(esp_timer_stop(motor_dither_timer));
+    for (int i = 0; i < 3; i++)
+    {
+        ESP_ERROR_CHECK(suspend ? bdc_motor_disable(motors[i]) : bdc_motor_enable(motors[i]));
+    }
+    if (!suspend && motor_dither_any()) ESP_ERROR_CHECK(esp_timer_start_periodic(motor_dither_timer, MOTOR_DITHER_PERIOD_US));
+    motor_suspended = suspend;
+    return ESP_OK;
 }
 
-// תֱֶ motor_stop
-void motor_start_reverse(uint8_t motor_index)
+// 修改电机 PWM 频率 (电机须处于停止状态), 通过重建 MCPWM 设备生效
+esp_err_t motor_set_pwm_freq(uint8_t motor_index, uint32_t freq_hz)
+{
+    if (motor_index >= 3) return ESP_ERR_INVALID_ARG;
+    if (freq_hz < PWM_FREQUENCY_MIN_HZ || freq_hz > PWM_FREQUENCY_MAX_HZ) return ESP_ERR_INVALID_ARG;
+    if (freq_hz == motor_pwm_freq[motor_index]) return ESP_OK;
+
+    taskENTER_CRITICAL(&motor_track_lock);
+    bool busy = (motor_track[motor_index].dir != 0) || (motor_track[motor_index].pending_dir != 0) ||
+                motor_track[motor_index].ramping;
+    taskEXIT_CRITICAL(&motor_track_lock);
+    if (busy) return ESP_ERR_INVALID_STATE;
+
+    ESP_ERROR_CHECK(bdc_motor_disable(motors[motor_index]));
+    ESP_ERROR_CHECK(bdc_motor_del(motors[motor_index]));
+    motors[motor_index] = NULL;
+
+    uint32_t old_freq = motor_pwm_freq[motor_index];
+    motor_pwm_freq[motor_index] = freq_hz;
+    esp_err_t err = motor_new_device(motor_index);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Motor %d: %" PRIu32 " Hz rejected (%s), restoring %" PRIu32 " Hz",
+                 motor_index, freq_hz, esp_err_to_name(err), old_freq);
+        motor_pwm_freq[motor_index] = old_freq;
+        ESP_ERROR_CHECK(motor_new_device(motor_index));
+    }
+    else
+    {
+        motor_period_ticks[motor_index] = TIMER_RESOLUTION_HZ / freq_hz;
+    }
+    ESP_ERROR_CHECK(bdc_motor_enable(motors[motor_index]));
+    ESP_ERROR_CHECK(bdc_motor_brake(motors[motor_index]));
+
+    motor_pwm_info_t info;
+    motor_get_pwm_info(motor_index, &info);
+    ESP_LOGI(TAG, "Motor %d PWM %" PRIu32 " Hz, %" PRIu32 " ticks, step %" PRIu32 ".%02" PRIu32 "%%, dithered %" PRIu32 ".%02" PRIu32 "%% per 20 ms",
+             motor_index, info.freq_hz, info.period_ticks, info.step_native / 100, info.step_native % 100,
+             info.step_dithered / 100, info.step_dithered % 100);
+    return err;
+}
+
+// 开启或关闭占空比抖动, 抖动定时器只在有电机开启抖动且未挂起时运行
+void motor_set_dither(uint8_t motor_index, bool enable)
 {
     if (motor_index >= 3) return;
-    ESP_ERROR_CHECK(bdc_motor_reverse(motors[motor_index]));
-    ESP_ERROR_CHECK(bdc_motor_set_speed(motors[motor_index], MOTOR_SPEED_TICKS));
+    motor_dither_en[motor_index] = enable;
+    motor_dither_acc[motor_index] = 0;
+    bool run = motor_dither_any() && !motor_suspended;
+    if (run && !esp_timer_is_active(motor_dither_timer))
+    {
+        ESP_ERROR_CHECK(esp_timer_start_periodic(motor_dither_timer, MOTOR_DITHER_PERIOD_US));
+    }
+    else if (!run && esp_timer_is_active(motor_dither_timer))
+    {
+        ESP_ERROR_CHECK(esp_timer_stop(motor_dither_timer));
+    }
+}
+
+// 报告当前 PWM 设置下的占空比分辨率 (单位 0.01%)
+void motor_get_pwm_info(uint8_t motor_index, motor_pwm_info_t *info)
+{
+    if (motor_index >= 3 || info == NULL) return;
+    uint32_t ticks = motor_period_ticks[motor_index];
+
+    info->freq_hz = motor_pwm_freq[motor_index];
+    info->period_ticks = ticks;
+    info->step_native = (MOTOR_DUTY_SCALE + ticks - 1) / ticks;
+    info->dither = motor_dither_en[motor_index];
+    // 抖动按定时器节拍 (不是每个PWM周期) 在 n / n+1 ticks 间切换: MOTOR_DITHER_AVG_US 内有
+    // AVG/PERIOD 次更新, 平均出的步长为 step_native 除以更新次数; 0.01% 的最细一步需要 step_native 次更新
+    uint32_t updates = MOTOR_DITHER_AVG_US / MOTOR_DITHER_PERIOD_US;
+    info->step_dithered = info->dither ? (info->step_native + updates - 1) / updates : info->step_native;
+    info->dither_window_us = info->dither ? info->step_native * MOTOR_DITHER_PERIOD_US : 0;
+}
+
+// 设置命令回调 (例如输入记录器), NULL 取消; 回调在调用者上下文中执行, 不能阻塞
+void motor_set_cmd_hook(motor_cmd_hook_t hook, void *arg)
+{
+    motor_cmd_hook_arg = arg;
+    motor_cmd_hook = hook;
 }
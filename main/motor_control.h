@@ -3,14 +3,69 @@
 
 #include <stdio.h>
 #include <string.h>
+#include "esp_err.h"
+
+#define MOTOR_POS_FULL      10000 // 轴位置满量程 (0 = 反向端, MOTOR_POS_FULL = 正向端)
+#define MOTOR_POS_UNKNOWN   (-1)
+#define MOTOR_DUTY_SCALE    10000 // 占空比单位 0.01%
+
+typedef struct
+{
+    uint32_t freq_hz;          // PWM 频率
+    uint32_t period_ticks;     // 每个 PWM 周期的计数值
+    uint32_t step_native;      // 不抖动时的占空比步长 (MOTOR_DUTY_SCALE 单位)
+    uint32_t step_dithered;    // 抖动后一个控制节拍 (20ms) 内平均出的步长, 抖动每 500us 定时器节拍更新一次
+    uint32_t dither_window_us; // 按定时器节拍平均出 0.01% 步长所需的时间
+    bool dither;
+} motor_pwm_info_t;
+
+typedef enum
+{
+    MOTOR_STOP_BRAKE, // 立即刹车 (两个下管导通)
+    MOTOR_STOP_COAST, // 关断输出, 电机自由滑行
+    MOTOR_STOP_RAMP,  // 占空比在 ramp_ms 内降到0, 然后刹车
+} motor_stop_mode_t;
+
+typedef struct
+{
+    motor_stop_mode_t mode;   // motor_stop() 使用的默认停止方式
+    uint16_t ramp_ms;         // 斜坡停止最长时间
+    uint16_t reverse_dead_ms; // 换向前的滑行间隔, 0 表示直接换向
+} motor_brake_config_t;
+
+// 控制逻辑发出的电机命令 (用于记录/回放), dir 为0表示停止
+typedef struct
+{
+    uint8_t motor;
+    int8_t dir;                  // 1 正转, -1 反转, 0 停止
+    uint32_t duty;               // 启动时的占空比 (MOTOR_DUTY_SCALE)
+    motor_stop_mode_t stop_mode; // 停止时的方式
+} motor_cmd_t;
+
+typedef void (*motor_cmd_hook_t)(const motor_cmd_t *cmd, void *arg);
 
 void motor_init(void);
 void motor_reverse_for_duration(uint8_t motor_index, uint32_t duration_ms);
 void motor_forward_for_duration(uint8_t motor_index, uint32_t duration_ms);
 void motor_stop(uint8_t motor_index);
+void motor_stop_mode(uint8_t motor_index, motor_stop_mode_t mode);
+void motor_set_brake_config(uint8_t motor_index, const motor_brake_config_t *cfg);
 
-void motor_start_forward(uint8_t motor_index);
-void motor_start_reverse(uint8_t motor_index);
+esp_err_t motor_start_forward(uint8_t motor_index);
+esp_err_t motor_start_reverse(uint8_t motor_index);
+esp_err_t motor_start_duty(uint8_t motor_index, int8_t dir, uint32_t duty);
+void motor_set_default_duty(uint32_t duty); // motor_start_forward / reverse 的占空比
+uint32_t motor_get_default_duty(void);
 
-#endif // !_MOTOR_CONTROL_H_
+void motor_set_travel(uint8_t motor_index, uint32_t travel_fwd_us, uint32_t travel_rev_us, uint32_t travel_duty);
+void motor_track_sync(uint8_t motor_index, int32_t pos);
+int32_t motor_get_position(uint8_t motor_index);
 
+esp_err_t motor_set_pwm_freq(uint8_t motor_index, uint32_t freq_hz);
+bool motor_busy(void);                 // 有电机在转、斜坡停止中或等待换向
+esp_err_t motor_suspend(bool suspend); // 空闲省电时停用/恢复 PWM 定时器, 有电机在动时返回 ESP_ERR_INVALID_STATE
+void motor_set_dither(uint8_t motor_index, bool enable);
+void motor_get_pwm_info(uint8_t motor_index, motor_pwm_info_t *info);
+void motor_set_cmd_hook(motor_cmd_hook_t hook, void *arg);
+
+#endif // !_MOTOR_CONTROL_H_
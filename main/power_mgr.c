@@ -0,0 +1,111 @@
+#include "power_mgr.h"
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "driver/uart.h"
+
+#include "input_driver.h"
+#include "lat_hist.h"
+
+static const char *TAG = "POWER";
+
+#define POWER_UART_WAKE_EDGES   3   // console input wakes the CPU; these first edges are lost
+
+static TaskHandle_t s_task = NULL;
+static esp_pm_lock_handle_t s_active_lock = NULL;
+static bool s_asleep = false;
+static int64_t s_sleep_us = 0;
+static volatile int64_t s_wake_isr_us = 0;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static power_stats_t s_stats;
+static int64_t s_stats_start_us = 0;
+
+static void IRAM_ATTR power_wake_isr(void)
+{
+    BaseType_t yield = pdFALSE;
+    s_wake_isr_us = esp_timer_get_time();
+    vTaskNotifyGiveFromISR(s_task, &yield);
+    portYIELD_FROM_ISR(yield);
+}
+
+esp_err_t power_mgr_init(void)
+{
+    s_task = xTaskGetCurrentTaskHandle();
+    s_stats_start_us = esp_timer_get_time();
+
+    esp_pm_config_t pm = {
+        .max_freq_mhz = POWER_CPU_MAX_MHZ,
+        .min_freq_mhz = POWER_CPU_MIN_MHZ,
+        .light_sleep_enable = true,
+    };
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err == ESP_ERR_NOT_SUPPORTED)
+    {
+        ESP_LOGW(TAG, "CONFIG_PM_ENABLE is off, idle without light sleep");
+        return ESP_OK;
+    }
+    if (err == ESP_OK) err = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "control", &s_active_lock);
+    if (err == ESP_OK) err = esp_pm_lock_acquire(s_active_lock);
+    if (err == ESP_OK) err = esp_sleep_enable_gpio_wakeup();
+#if CONFIG_ESP_CONSOLE_UART_DEFAULT || CONFIG_ESP_CONSOLE_UART_CUSTOM
+    if (err == ESP_OK) err = uart_set_wakeup_threshold(CONFIG_ESP_CONSOLE_UART_NUM, POWER_UART_WAKE_EDGES);
+    if (err == ESP_OK) err = esp_sleep_enable_uart_wakeup(CONFIG_ESP_CONSOLE_UART_NUM);
+#endif
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Power management not available: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "DFS %d..%d MHz, light sleep when idle", POWER_CPU_MIN_MHZ, POWER_CPU_MAX_MHZ);
+    return ESP_OK;
+}
+
+void power_mgr_sleep(void)
+{
+    if (s_asleep) return;
+    ulTaskNotifyTake(pdTRUE, 0); // drop a stale wake
+    lat_hist_cancel(LAT_WAKE_DRIVE); // the last wake did not lead to a drive
+    if (input_wake_arm(power_wake_isr) != ESP_OK) return;
+    if (s_active_lock) esp_pm_lock_release(s_active_lock);
+    s_asleep = true;
+    s_sleep_us = esp_timer_get_time();
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.sleeps++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+bool power_mgr_wait(uint32_t timeout_ms)
+{
+    if (!s_asleep) return false;
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) == 0) return false;
+    lat_hist_mark(LAT_WAKE_DRIVE, s_wake_isr_us);
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.pin_wakes++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+    return true;
+}
+
+void power_mgr_wake(void)
+{
+    if (!s_asleep) return;
+    if (s_active_lock) esp_pm_lock_acquire(s_active_lock);
+    input_wake_disarm();
+    s_asleep = false;
+    int64_t slept = esp_timer_get_time() - s_sleep_us;
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.asleep_us += (uint64_t)slept;
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+void power_mgr_get_stats(power_stats_t *out)
+{
+    taskENTER_CRITICAL(&s_stats_lock);
+    *out = s_stats;
+    taskEXIT_CRITICAL(&s_stats_lock);
+    out->since_us = (uint64_t)(esp_timer_get_time() - s_stats_start_us);
+}
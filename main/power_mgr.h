@@ -0,0 +1,45 @@
+#ifndef _POWER_MGR_H_
+#define _POWER_MGR_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * Idle power management. With CONFIG_PM_ENABLE the CPU scales between
+ * POWER_CPU_MIN_MHZ and POWER_CPU_MAX_MHZ and FreeRTOS tickless idle enters light
+ * sleep whenever no lock is held. The control task holds a CPU_FREQ_MAX lock while
+ * active; once it has been idle long enough it calls power_mgr_sleep(), which drops
+ * the lock and arms the key / limit switch wake pins, and then power_mgr_wait() for
+ * a wake pin or the next low-rate poll.
+ *
+ * The caller only sleeps while the control core is quiescent, and motor_suspend()
+ * stops the PWM dither timer, so no periodic esp_timer keeps the CPU awake.
+ *
+ * A pin wake marks LAT_WAKE_DRIVE in lat_hist with the interrupt time; both runtimes
+ * run the next tick as soon as power_mgr_wake() returns, so the latency is the light
+ * sleep exit, restarting ADC and PWM and one control tick. The console `stats` and
+ * `lat` commands print the measured min / median / max.
+ *
+ * Without CONFIG_PM_ENABLE the calls still work; the CPU just does not sleep.
+ */
+
+#define POWER_CPU_MAX_MHZ   240
+#define POWER_CPU_MIN_MHZ   80
+
+typedef struct
+{
+    uint32_t sleeps;        // power_mgr_sleep() calls
+    uint32_t pin_wakes;     // woken by a key or limit switch
+    uint64_t asleep_us;     // time between power_mgr_sleep() and power_mgr_wake(), light sleep whenever no timer is due
+    uint64_t since_us;      // time the counters cover
+} power_stats_t;
+
+esp_err_t power_mgr_init(void);     // call from the control task: it owns the lock and the wake notification
+void power_mgr_sleep(void);
+bool power_mgr_wait(uint32_t timeout_ms); // true: woken by a pin
+void power_mgr_wake(void);
+void power_mgr_get_stats(power_stats_t *out);
+
+#endif // !_POWER_MGR_H_
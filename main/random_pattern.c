@@ -0,0 +1,96 @@
+#include "random_pattern.h"
+#include <string.h>
+
+#define PCG_MULT        6364136223846793005ULL
+#define PCG_STREAM      0xda3e39cb94b95bdbULL
+
+void random_pcg_seed(random_pcg_t *rng, uint32_t seed)
+{
+    rng->state = 0;
+    rng->inc = (PCG_STREAM << 1) | 1;
+    random_pcg_next(rng);
+    rng->state += seed;
+    random_pcg_next(rng);
+}
+
+uint32_t random_pcg_next(random_pcg_t *rng)
+{
+    uint64_t old = rng->state;
+    rng->state = old * PCG_MULT + rng->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+uint32_t random_pcg_range(random_pcg_t *rng, uint32_t lo, uint32_t hi)
+{
+    if (hi <= lo) return lo;
+    uint64_t span = (uint64_t)hi - lo + 1;
+    return lo + (uint32_t)(((uint64_t)random_pcg_next(rng) * span) >> 32); // no modulo
+}
+
+static uint32_t pick_dwell(random_pcg_t *rng, const random_pattern_cfg_t *cfg)
+{
+    uint32_t a = random_pcg_range(rng, cfg->dwell_min_ms, cfg->dwell_max_ms);
+    if (cfg->dwell == RANDOM_DWELL_UNIFORM) return a;
+    uint32_t b = random_pcg_range(rng, cfg->dwell_min_ms, cfg->dwell_max_ms);
+    if (cfg->dwell == RANDOM_DWELL_TRIANGULAR) return (a + b + 1) / 2;
+    return a < b ? a : b;
+}
+
+void random_pattern_build(random_pattern_t *pat, const random_pattern_cfg_t *cfg, uint32_t seed)
+{
+    random_pcg_t rng;
+    random_pcg_seed(&rng, seed);
+    memset(pat, 0, sizeof(*pat));
+    pat->seed = seed;
+
+    // estimated position from the reverse end, in ms of forward travel at travel_duty
+    int32_t pos[RANDOM_PATTERN_AXES];
+    for (int i = 0; i < RANDOM_PATTERN_AXES; i++)
+    {
+        int32_t span = (int32_t)cfg->travel_fwd_ms[i];
+        int32_t start = cfg->start_ms[i];
+        pos[i] = (start < 0) ? span / 2 : (start > span ? span : start);
+    }
+    uint32_t t = 0;
+    while (t < cfg->duration_ms && pat->num_steps < RANDOM_PATTERN_MAX_STEPS)
+    {
+        uint32_t dwell = pick_dwell(&rng, cfg);
+        if (dwell == 0) dwell = 1;
+        if (dwell > cfg->duration_ms - t) dwell = cfg->duration_ms - t;
+
+        random_step_t *step = &pat->steps[pat->num_steps++];
+        step->t_ms = t;
+        for (int i = 0; i < RANDOM_PATTERN_AXES; i++)
+        {
+            if (cfg->num_speeds == 0 || random_pcg_range(&rng, 0, 99) < cfg->stop_percent) continue;
+
+            uint16_t duty = cfg->speeds[random_pcg_range(&rng, 0, cfg->num_speeds - 1)];
+            int8_t dir = (random_pcg_next(&rng) & 1) ? 1 : -1;
+            int32_t span = (int32_t)cfg->travel_fwd_ms[i];
+            if (span > 0 && cfg->travel_rev_ms[i] > 0 && cfg->travel_duty[i] > 0)
+            {
+                // distance covered each way, a reverse move scaled to forward-travel ms
+                int32_t fwd = (int32_t)((uint64_t)dwell * duty / cfg->travel_duty[i]);
+                int32_t rev = (int32_t)((uint64_t)fwd * cfg->travel_fwd_ms[i] / cfg->travel_rev_ms[i]);
+                // turn around rather than run into the end of travel
+                if ((dir > 0) ? (pos[i] + fwd > span) : (pos[i] - rev < 0))
+                {
+                    dir = (int8_t)-dir;
+                }
+                if ((dir > 0) ? (pos[i] + fwd > span) : (pos[i] - rev < 0))
+                {
+                    dir = (pos[i] > span / 2) ? -1 : 1; // longer than the travel: head for the far side
+                }
+                pos[i] += (dir > 0) ? fwd : -rev;
+                if (pos[i] > span) pos[i] = span;
+                if (pos[i] < 0) pos[i] = 0;
+            }
+            step->dir[i] = dir;
+            step->duty[i] = duty;
+        }
+        t += dwell;
+    }
+    pat->duration_ms = t;
+}
@@ -0,0 +1,70 @@
+#ifndef _RANDOM_PATTERN_H_
+#define _RANDOM_PATTERN_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Random mode motion schedules. A pattern is built up front from a 32-bit seed with
+ * a PCG32 generator, so the same seed always gives the same schedule on any target
+ * and thread. The control tick walks the steps and only commands an axis when its
+ * action changes.
+ */
+
+#define RANDOM_PATTERN_AXES         2
+#define RANDOM_PATTERN_MAX_STEPS    32
+#define RANDOM_PATTERN_MAX_SPEEDS   4
+
+typedef enum
+{
+    RANDOM_DWELL_UNIFORM,    // any value in [min, max] equally likely
+    RANDOM_DWELL_TRIANGULAR, // mean of two draws, clusters around the middle
+    RANDOM_DWELL_SHORT,      // smaller of two draws, favours quick changes
+} random_dwell_t;
+
+typedef struct
+{
+    uint32_t duration_ms;
+    uint16_t dwell_min_ms;
+    uint16_t dwell_max_ms;
+    random_dwell_t dwell;
+    uint8_t stop_percent;                       // chance an axis rests for a step
+    uint8_t num_speeds;
+    uint16_t speeds[RANDOM_PATTERN_MAX_SPEEDS]; // duty levels (MOTOR_DUTY_SCALE)
+    uint32_t travel_fwd_ms[RANDOM_PATTERN_AXES];  // reverse end to forward end at travel_duty, 0 = unknown
+    uint32_t travel_rev_ms[RANDOM_PATTERN_AXES];  // forward end to reverse end at travel_duty
+    uint16_t travel_duty[RANDOM_PATTERN_AXES];    // duty the travel times were measured at
+    int32_t start_ms[RANDOM_PATTERN_AXES];        // start, in travel_fwd_ms from the reverse end, -1 = unknown (centre)
+} random_pattern_cfg_t;
+
+typedef struct
+{
+    uint32_t t_ms; // start, from the beginning of the pattern
+    int8_t dir[RANDOM_PATTERN_AXES];
+    uint16_t duty[RANDOM_PATTERN_AXES];
+} random_step_t;
+
+typedef struct
+{
+    uint32_t seed;
+    uint32_t duration_ms;
+    uint8_t num_steps;
+    random_step_t steps[RANDOM_PATTERN_MAX_STEPS];
+} random_pattern_t;
+
+typedef struct
+{
+    uint64_t state;
+    uint64_t inc;
+} random_pcg_t;
+
+void random_pcg_seed(random_pcg_t *rng, uint32_t seed);
+uint32_t random_pcg_next(random_pcg_t *rng);
+uint32_t random_pcg_range(random_pcg_t *rng, uint32_t lo, uint32_t hi); // inclusive
+
+// Steps never head further than the estimated travel allows from the start position,
+// so with a known travel the pattern turns around before the limit switches.
+void random_pattern_build(random_pattern_t *pat, const random_pattern_cfg_t *cfg, uint32_t seed);
+
+#endif // !_RANDOM_PATTERN_H_
@@ -0,0 +1,244 @@
+#include "rec_log.h"
+#include <string.h>
+
+#define REC_SIZE_BOOT   17
+#define REC_SIZE_INPUT  13
+#define REC_SIZE_EDGE   6
+#define REC_SIZE_MOTOR  6
+#define REC_SIZE_GAP    5
+#define REC_SIZE_SEED   5
+#define REC_SIZE_PARAM  6
+#define REC_SIZE_DUTY   5
+#define REC_SIZE_AIM    3
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t rec_log_put_header(uint8_t *out, uint32_t boot_count)
+{
+    put_u32(out, REC_LOG_MAGIC);
+    put_u16(out + 4, REC_LOG_VERSION);
+    put_u16(out + 6, REC_LOG_HDR_SIZE);
+    put_u32(out + 8, boot_count);
+    put_u32(out + 12, 0);
+    return REC_LOG_HDR_SIZE;
+}
+
+size_t rec_log_put_boot(uint8_t *out, const uint32_t travel_us[4])
+{
+    out[0] = REC_BOOT;
+    for (int i = 0; i < 4; i++)
+    {
+        put_u32(out + 1 + 4 * i, travel_us[i]);
+    }
+    return REC_SIZE_BOOT;
+}
+
+size_t rec_log_put_duty(uint8_t *out, const uint32_t travel_duty[2])
+{
+    out[0] = REC_DUTY;
+    put_u16(out + 1, (uint16_t)travel_duty[0]);
+    put_u16(out + 3, (uint16_t)travel_duty[1]);
+    return REC_SIZE_DUTY;
+}
+
+size_t rec_log_put_input(uint8_t *out, const input_frame_t *in)
+{
+    out[0] = REC_INPUT;
+    put_u32(out + 1, (uint32_t)in->t_us);
+    put_u16(out + 5, in->pot);
+    put_u16(out + 7, in->joy_x);
+    put_u16(out + 9, in->joy_y);
+    put_u16(out + 11, in->gpio);
+    return REC_SIZE_INPUT;
+}
+
+size_t rec_log_put_edge(uint8_t *out, uint8_t edge, int64_t t_us)
+{
+    out[0] = REC_EDGE;
+    out[1] = edge;
+    put_u32(out + 2, (uint32_t)t_us);
+    return REC_SIZE_EDGE;
+}
+
+size_t rec_log_put_aim(uint8_t *out, const int8_t aim_pos[INPUT_AIM_AXES])
+{
+    out[0] = REC_AIM;
+    out[1] = (uint8_t)aim_pos[0];
+    out[2] = (uint8_t)aim_pos[1];
+    return REC_SIZE_AIM;
+}
+
+size_t rec_log_put_motor(uint8_t *out, uint8_t motor, int8_t dir, uint8_t stop_mode, uint32_t duty)
+{
+    out[0] = REC_MOTOR;
+    out[1] = motor;
+    out[2] = (uint8_t)dir;
+    out[3] = stop_mode;
+    put_u16(out + 4, (uint16_t)duty);
+    return REC_SIZE_MOTOR;
+}
+
+size_t rec_log_put_gap(uint8_t *out, uint32_t dropped)
+{
+    out[0] = REC_GAP;
+    put_u32(out + 1, dropped);
+    return REC_SIZE_GAP;
+}
+
+size_t rec_log_put_seed(uint8_t *out, uint32_t seed)
+{
+    out[0] = REC_SEED;
+    put_u32(out + 1, seed);
+    return REC_SIZE_SEED;
+}
+
+size_t rec_log_put_param(uint8_t *out, uint8_t id, uint32_t value)
+{
+    out[0] = REC_PARAM;
+    out[1] = id;
+    put_u32(out + 2, value);
+    return REC_SIZE_PARAM;
+}
+
+bool rec_log_open(rec_reader_t *rd, const uint8_t *buf, size_t len)
+{
+    memset(rd, 0, sizeof(*rd));
+    if (len < REC_LOG_HDR_SIZE || get_u32(buf) != REC_LOG_MAGIC || get_u16(buf + 4) != REC_LOG_VERSION)
+    {
+        return false;
+    }
+    rd->buf = buf;
+    rd->len = len;
+    rd->pos = get_u16(buf + 6);
+    rd->boot_count = get_u32(buf + 8);
+    memset(rd->aim_pos, -1, sizeof(rd->aim_pos));
+    return rd->pos <= len;
+}
+
+// 32-bit timestamps are unwrapped against the last INPUT time (steps under 35 min).
+static int64_t unwrap(const rec_reader_t *rd, uint32_t t32)
+{
+    if (!rd->have_time) return t32;
+    return rd->t_us + (int32_t)(t32 - rd->last_t32);
+}
+
+bool rec_log_next(rec_reader_t *rd, rec_item_t *item)
+{
+    while (rd->pos < rd->len)
+    {
+        const uint8_t *p = rd->buf + rd->pos;
+        size_t avail = rd->len - rd->pos;
+        size_t size;
+
+        switch (p[0])
+        {
+        case REC_PAD:   size = 1; break;
+        case REC_BOOT:  size = REC_SIZE_BOOT; break;
+        case REC_INPUT: size = REC_SIZE_INPUT; break;
+        case REC_EDGE:  size = REC_SIZE_EDGE; break;
+        case REC_MOTOR: size = REC_SIZE_MOTOR; break;
+        case REC_GAP:   size = REC_SIZE_GAP; break;
+        case REC_SEED:  size = REC_SIZE_SEED; break;
+        case REC_PARAM: size = REC_SIZE_PARAM; break;
+        case REC_DUTY:  size = REC_SIZE_DUTY; break;
+        case REC_AIM:   size = REC_SIZE_AIM; break;
+        default:        return false; // REC_END, erased flash or garbage
+        }
+        if (size > avail) return false;
+        rd->pos += size;
+
+        memset(item, 0, sizeof(*item));
+        item->type = (rec_type_t)p[0];
+        switch (p[0])
+        {
+        case REC_PAD:
+            continue;
+
+        case REC_BOOT:
+            for (int i = 0; i < 4; i++)
+            {
+                item->travel_us[i] = get_u32(p + 1 + 4 * i);
+            }
+            return true;
+
+        case REC_EDGE:
+            if (p[1] < INPUT_EDGE_COUNT)
+            {
+                rd->edge_us[p[1]] = unwrap(rd, get_u32(p + 2));
+            }
+            continue;
+
+        case REC_AIM:
+            rd->aim_pos[0] = (int8_t)p[1];
+            rd->aim_pos[1] = (int8_t)p[2];
+            continue;
+
+        case REC_INPUT:
+        {
+            uint32_t t32 = get_u32(p + 1);
+            rd->t_us = unwrap(rd, t32);
+            rd->last_t32 = t32;
+            rd->have_time = true;
+
+            input_frame_t *in = &item->input;
+            in->t_us = rd->t_us;
+            in->pot = get_u16(p + 5);
+            in->joy_x = get_u16(p + 7);
+            in->joy_y = get_u16(p + 9);
+            in->gpio = get_u16(p + 11);
+            memcpy(in->t_edge_us, rd->edge_us, sizeof(in->t_edge_us));
+            memset(rd->edge_us, 0, sizeof(rd->edge_us));
+            memcpy(in->aim_pos, rd->aim_pos, sizeof(in->aim_pos));
+            return true;
+        }
+
+        case REC_MOTOR:
+            item->motor.motor = p[1];
+            item->motor.dir = (int8_t)p[2];
+            item->motor.stop_mode = p[3];
+            item->motor.duty = get_u16(p + 4);
+            return true;
+
+        case REC_GAP:
+            item->dropped = get_u32(p + 1);
+            return true;
+
+        case REC_SEED:
+            item->seed = get_u32(p + 1);
+            return true;
+
+        case REC_PARAM:
+            item->param.id = p[1];
+            item->param.value = get_u32(p + 2);
+            return true;
+
+        case REC_DUTY:
+            item->travel_duty[0] = get_u16(p + 1);
+            item->travel_duty[1] = get_u16(p + 3);
+            return true;
+        }
+    }
+    return false;
+}
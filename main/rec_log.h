@@ -0,0 +1,92 @@
+#ifndef _REC_LOG_H_
+#define _REC_LOG_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "input_frame.h"
+
+/*
+ * Binary session log shared by the on-device recorder and the replay tools.
+ * All fields are little endian. A log is a header followed by packed records; each
+ * record starts with a type byte and has a fixed size per type. Times are the low
+ * 32 bits of esp_timer_get_time(); the reader unwraps them into 64-bit time.
+ * Erased flash (0xff) ends the log.
+ */
+
+#define REC_LOG_MAGIC       0x31474c52u // "RLG1"
+#define REC_LOG_VERSION     1
+#define REC_LOG_HDR_SIZE    16
+
+typedef enum
+{
+    REC_PAD   = 0x00, // 1 byte filler
+    REC_BOOT  = 0x01, // travel times loaded at boot (motor 1 fwd/rev, motor 2 fwd/rev)
+    REC_INPUT = 0x02, // one input frame: t, pot, joy_x, joy_y, gpio
+    REC_EDGE  = 0x03, // edge timestamp for the next INPUT record: edge, t
+    REC_MOTOR = 0x04, // command issued while handling the previous INPUT: motor, dir, mode, duty
+    REC_GAP   = 0x05, // records were dropped before this point: count
+    REC_SEED  = 0x06, // random mode session seed passed to control_core_set_seed()
+    REC_PARAM = 0x07, // tuning parameter in effect from the next INPUT record: id, value
+    REC_DUTY  = 0x08, // duty the REC_BOOT travel times were measured at (motor 1, motor 2)
+    REC_AIM   = 0x09, // aim axis positions for this and later INPUT records: axis 1, axis 2
+    REC_END   = 0xff,
+} rec_type_t;
+
+#define REC_MAX_SIZE        17  // largest record (REC_BOOT)
+
+typedef struct
+{
+    rec_type_t type;
+    union
+    {
+        uint32_t travel_us[4];
+        uint32_t travel_duty[2];        // 0 when the log has no REC_DUTY record
+        input_frame_t input;            // t_edge_us filled from preceding EDGE records
+        struct
+        {
+            uint8_t motor;
+            int8_t dir;
+            uint8_t stop_mode;
+            uint16_t duty;
+        } motor;
+        uint32_t dropped;
+        uint32_t seed;
+        struct
+        {
+            uint8_t id;     // tune_param_t
+            uint32_t value;
+        } param;
+    };
+} rec_item_t;
+
+typedef struct
+{
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+    uint32_t boot_count;
+    bool have_time;
+    uint32_t last_t32;
+    int64_t t_us;
+    int64_t edge_us[INPUT_EDGE_COUNT];
+    int8_t aim_pos[INPUT_AIM_AXES];     // last REC_AIM, -1 before the first one
+} rec_reader_t;
+
+// Writers return the number of bytes put in `out` (REC_MAX_SIZE bytes must fit).
+size_t rec_log_put_header(uint8_t *out, uint32_t boot_count);
+size_t rec_log_put_boot(uint8_t *out, const uint32_t travel_us[4]);
+size_t rec_log_put_duty(uint8_t *out, const uint32_t travel_duty[2]);
+size_t rec_log_put_input(uint8_t *out, const input_frame_t *in);
+size_t rec_log_put_edge(uint8_t *out, uint8_t edge, int64_t t_us);
+size_t rec_log_put_aim(uint8_t *out, const int8_t aim_pos[INPUT_AIM_AXES]);
+size_t rec_log_put_motor(uint8_t *out, uint8_t motor, int8_t dir, uint8_t stop_mode, uint32_t duty);
+size_t rec_log_put_gap(uint8_t *out, uint32_t dropped);
+size_t rec_log_put_seed(uint8_t *out, uint32_t seed);
+size_t rec_log_put_param(uint8_t *out, uint8_t id, uint32_t value);
+
+bool rec_log_open(rec_reader_t *rd, const uint8_t *buf, size_t len); // false if no valid header
+bool rec_log_next(rec_reader_t *rd, rec_item_t *item);               // false at the end of the log
+
+#endif // !_REC_LOG_H_
@@ -0,0 +1,257 @@
+#include "remote_ctrl.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+
+static const char *TAG = "REMOTE";
+
+#define REMOTE_AXIS_MAX     1000    // aim and speed commands are in 1/1000 of full range
+#define REMOTE_ADC_MAX      4095
+#define REMOTE_POT_PICKUP   200     // local pot movement that takes the speed setpoint back
+
+// commands that become a key press, in the order they are served; release goes last
+// so the commands sent before it still take effect
+typedef enum
+{
+    CMD_REHOME,
+    CMD_RANDOM,
+    CMD_STABILIZE,
+    CMD_LAUNCH,
+    CMD_RELEASE,
+    CMD_COUNT,
+} remote_cmd_t;
+
+static const uint8_t s_cmd_key[CMD_COUNT] = {1, 3, 4, 2, 0};
+
+// Written by the transport task. s_rx_frames is bumped last, so the control task
+// sees the fields of every frame it has counted.
+static atomic_uint s_rx_frames;
+static atomic_uint s_rx_ms;             // arrival of the newest frame
+static atomic_uint s_rx_seq;
+static atomic_uint s_aim;               // (uint16)x | y << 16
+static atomic_int s_speed;              // potentiometer counts, < 0: use the local pot
+static atomic_uint s_cmd_rx[CMD_COUNT];
+static int64_t s_rx_last_us = 0;        // transport task only
+
+// control task only
+static remote_link_t s_link = REMOTE_LINK_NONE;
+static unsigned s_frames_seen = 0;
+static unsigned s_cmd_done[CMD_COUNT];
+static bool s_key_gap = false;          // a key was pressed last tick, release it first
+static uint16_t s_applied_seq = 0;
+static int s_speed_seen = -1;           // remote speed in effect
+static uint16_t s_pot_ref = 0;          // local pot when it was set
+
+static int16_t clamp_axis(int32_t v)
+{
+    if (v > REMOTE_AXIS_MAX) return REMOTE_AXIS_MAX;
+    if (v < -REMOTE_AXIS_MAX) return -REMOTE_AXIS_MAX;
+    return (int16_t)v;
+}
+
+// deflection (-1000..1000) to the ADC value of a joystick pushed that far from rest
+static uint16_t axis_to_adc(int16_t v, uint16_t rest)
+{
+    if (v >= 0) return (uint16_t)(rest + (int32_t)v * (REMOTE_ADC_MAX - rest) / REMOTE_AXIS_MAX);
+    return (uint16_t)(rest + (int32_t)v * rest / REMOTE_AXIS_MAX);
+}
+
+void remote_ctrl_init(void)
+{
+    atomic_store(&s_rx_frames, 0);
+    atomic_store(&s_aim, 0);
+    atomic_store(&s_speed, -1);
+    for (int i = 0; i < CMD_COUNT; i++)
+    {
+        atomic_store(&s_cmd_rx[i], 0);
+        s_cmd_done[i] = 0;
+    }
+    s_link = REMOTE_LINK_NONE;
+    s_frames_seen = 0;
+    s_key_gap = false;
+    s_speed_seen = -1;
+}
+
+static void handle_msg(const remote_msg_t *msg, int64_t now_us, remote_reply_fn_t reply, void *arg)
+{
+    const uint8_t *p = msg->payload;
+    switch (msg->type)
+    {
+    case REMOTE_AIM:
+        if (msg->len < 4) break;
+        atomic_store(&s_aim, (uint16_t)clamp_axis(remote_get_i16(p)) |
+                             ((unsigned)(uint16_t)clamp_axis(remote_get_i16(p + 2)) << 16));
+        break;
+
+    case REMOTE_LAUNCH:
+        atomic_fetch_add(&s_cmd_rx[CMD_LAUNCH], 1);
+        break;
+
+    case REMOTE_MODE:
+        if (msg->len < 1) break;
+        if (p[0] == REMOTE_MODE_REHOME) atomic_fetch_add(&s_cmd_rx[CMD_REHOME], 1);
+        else if (p[0] == REMOTE_MODE_RANDOM) atomic_fetch_add(&s_cmd_rx[CMD_RANDOM], 1);
+        else if (p[0] == REMOTE_MODE_STABILIZE) atomic_fetch_add(&s_cmd_rx[CMD_STABILIZE], 1);
+        else if (p[0] == REMOTE_MODE_RELEASE) atomic_fetch_add(&s_cmd_rx[CMD_RELEASE], 1);
+        break;
+
+    case REMOTE_PARAM:
+        if (msg->len < 5 || p[0] != REMOTE_PARAM_LAUNCH_SPEED) break;
+        int32_t v = remote_get_i32(p + 1);
+        if (v < 0) v = 0;
+        if (v > REMOTE_AXIS_MAX) v = REMOTE_AXIS_MAX;
+        atomic_store(&s_speed, v * REMOTE_ADC_MAX / REMOTE_AXIS_MAX);
+        break;
+
+    case REMOTE_PING:
+        if (reply)
+        {
+            uint8_t out[REMOTE_MAX_FRAME];
+            reply(out, remote_encode(out, msg->seq, REMOTE_PONG, p, msg->len), arg);
+        }
+        break;
+
+    default: // heartbeat, or a type this firmware does not know: still proof of life
+        break;
+    }
+
+    atomic_store(&s_rx_seq, msg->seq);
+    atomic_store(&s_rx_ms, (unsigned)(now_us / 1000));
+    atomic_fetch_add(&s_rx_frames, 1);
+}
+
+void remote_ctrl_rx_bytes(remote_parser_t *p, const uint8_t *data, size_t len, int64_t now_us,
+                          remote_reply_fn_t reply, void *arg)
+{
+    // after a silence the client may have restarted its sequence numbers
+    if (now_us - s_rx_last_us > (int64_t)REMOTE_LINK_TIMEOUT_MS * 1000) remote_parser_resync(p);
+
+    while (len > 0)
+    {
+        remote_msg_t msg;
+        bool got;
+        size_t used = remote_parser_feed(p, data, len, &msg, &got);
+        data += used;
+        len -= used;
+        if (!got) continue;
+        s_rx_last_us = now_us;
+        handle_msg(&msg, now_us, reply, arg);
+    }
+}
+
+static void link_set(remote_link_t link)
+{
+    static const char *const names[] = {"local", "remote", "lost"};
+    if (link == REMOTE_LINK_LOST)
+    {
+        ESP_LOGW(TAG, "no command for %d ms, failsafe", REMOTE_LINK_TIMEOUT_MS);
+    }
+    else
+    {
+        ESP_LOGI(TAG, "link %s -> %s", names[s_link], names[link]);
+    }
+    s_link = link;
+}
+
+// commands that arrived while the client was not in control are not acted on
+static void drop_pending(void)
+{
+    for (int i = 0; i < CMD_COUNT; i++) s_cmd_done[i] = atomic_load(&s_cmd_rx[i]);
+    s_key_gap = false;
+}
+
+// The remote speed setpoint outlives the link, like a pot left where it was set,
+// until the operator turns the local pot.
+static void apply_speed(input_frame_t *frame)
+{
+    int speed = atomic_load(&s_speed);
+    if (speed < 0) return;
+    if (speed != s_speed_seen)
+    {
+        s_speed_seen = speed;
+        s_pot_ref = frame->pot;
+    }
+    int moved = (int)frame->pot - (int)s_pot_ref;
+    if (moved > REMOTE_POT_PICKUP || moved < -REMOTE_POT_PICKUP)
+    {
+        atomic_compare_exchange_strong(&s_speed, &speed, -1);
+        s_speed_seen = -1;
+        return;
+    }
+    frame->pot = (uint16_t)speed;
+}
+
+void remote_ctrl_apply(input_frame_t *frame)
+{
+    apply_speed(frame);
+
+    unsigned frames = atomic_load(&s_rx_frames);
+    bool fresh = frames != s_frames_seen;
+    s_frames_seen = frames;
+    uint32_t now_ms = (uint32_t)(frame->t_us / 1000);
+    bool timed_out = (int32_t)(now_ms - atomic_load(&s_rx_ms)) > REMOTE_LINK_TIMEOUT_MS;
+
+    if (fresh && !timed_out && s_link != REMOTE_LINK_ACTIVE) link_set(REMOTE_LINK_ACTIVE);
+    else if (s_link == REMOTE_LINK_ACTIVE && timed_out) link_set(REMOTE_LINK_LOST);
+
+    if (s_link == REMOTE_LINK_LOST)
+    {
+        drop_pending();
+        if (input_key_down(frame, 1))
+        {
+            link_set(REMOTE_LINK_NONE); // operator takes over locally
+            return;
+        }
+        frame->gpio |= INPUT_FAILSAFE_BIT;
+        frame->joy_x = INPUT_JOY_X_REST;
+        frame->joy_y = INPUT_JOY_Y_REST;
+        return;
+    }
+    if (s_link == REMOTE_LINK_NONE)
+    {
+        drop_pending();
+        return;
+    }
+
+    s_applied_seq = (uint16_t)atomic_load(&s_rx_seq);
+
+    // one key press per tick with a released tick in between; repeats of a
+    // command that has not been served yet collapse into one
+    if (s_key_gap)
+    {
+        s_key_gap = false;
+    }
+    else
+    {
+        for (int i = 0; i < CMD_COUNT; i++)
+        {
+            unsigned rx = atomic_load(&s_cmd_rx[i]);
+            if (rx == s_cmd_done[i]) continue;
+            s_cmd_done[i] = rx;
+            if (i == CMD_RELEASE)
+            {
+                atomic_store(&s_aim, 0);
+                link_set(REMOTE_LINK_NONE);
+                drop_pending();
+                return;
+            }
+            frame->gpio &= (uint16_t)~INPUT_KEY_BIT(s_cmd_key[i]);
+            s_key_gap = true;
+            break;
+        }
+    }
+
+    unsigned aim = atomic_load(&s_aim);
+    frame->joy_x = axis_to_adc((int16_t)(aim & 0xffff), INPUT_JOY_X_REST);
+    frame->joy_y = axis_to_adc((int16_t)(aim >> 16), INPUT_JOY_Y_REST);
+}
+
+remote_link_t remote_ctrl_link(void)
+{
+    return s_link;
+}
+
+uint16_t remote_ctrl_applied_seq(void)
+{
+    return s_applied_seq;
+}
@@ -0,0 +1,45 @@
+#ifndef _REMOTE_CTRL_H_
+#define _REMOTE_CTRL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "input_frame.h"
+#include "remote_proto.h"
+
+/*
+ * Remote commands enter the control logic through the input frame, exactly like the
+ * local joystick and keys: a transport task feeds received bytes to
+ * remote_ctrl_rx_bytes(), and the control task calls remote_ctrl_apply() on each
+ * sampled frame. While a client is sending, its aim replaces the joystick, its
+ * launch / mode commands become one-tick key presses and its speed setpoint replaces
+ * the potentiometer (until the local pot is turned), so recordings and replay cover
+ * remote sessions too.
+ *
+ * If no frame arrives for REMOTE_LINK_TIMEOUT_MS the link is lost and every frame
+ * carries INPUT_FAILSAFE_BIT: the control core brakes all motors and ignores
+ * commands until the link comes back, or the operator presses key 1 to take over
+ * locally.
+ */
+
+#define REMOTE_LINK_TIMEOUT_MS  250
+
+typedef enum
+{
+    REMOTE_LINK_NONE,   // local inputs only
+    REMOTE_LINK_ACTIVE, // client in control
+    REMOTE_LINK_LOST,   // failsafe
+} remote_link_t;
+
+// Sends a reply frame back over the transport the request came in on.
+typedef void (*remote_reply_fn_t)(const uint8_t *frame, size_t len, void *arg);
+
+void remote_ctrl_init(void);
+void remote_ctrl_rx_bytes(remote_parser_t *p, const uint8_t *data, size_t len, int64_t now_us,
+                          remote_reply_fn_t reply, void *arg);
+void remote_ctrl_apply(input_frame_t *frame); // overlays the remote state, uses frame->t_us
+remote_link_t remote_ctrl_link(void);
+uint16_t remote_ctrl_applied_seq(void); // newest command reflected in the last applied frame
+
+#endif // !_REMOTE_CTRL_H_
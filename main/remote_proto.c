@@ -0,0 +1,112 @@
+#include "remote_proto.h"
+#include <string.h>
+
+uint16_t remote_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xffff;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t remote_encode(uint8_t out[REMOTE_MAX_FRAME], uint16_t seq, uint8_t type, const void *payload, uint8_t len)
+{
+    if (len > REMOTE_MAX_PAYLOAD) return 0;
+    out[0] = REMOTE_SOF0;
+    out[1] = REMOTE_SOF1;
+    out[2] = len;
+    out[3] = (uint8_t)seq;
+    out[4] = (uint8_t)(seq >> 8);
+    out[5] = type;
+    if (len) memcpy(&out[6], payload, len);
+    uint16_t crc = remote_crc16(&out[2], 4 + len);
+    out[6 + len] = (uint8_t)crc;
+    out[7 + len] = (uint8_t)(crc >> 8);
+    return REMOTE_OVERHEAD + len;
+}
+
+void remote_parser_init(remote_parser_t *p)
+{
+    memset(p, 0, sizeof(*p));
+}
+
+void remote_parser_resync(remote_parser_t *p)
+{
+    p->synced = false;
+}
+
+// false for a duplicate or out-of-order frame
+static bool accept_seq(remote_parser_t *p, uint16_t seq)
+{
+    if (p->synced)
+    {
+        uint16_t diff = (uint16_t)(seq - p->last_seq);
+        if (diff == 0 || diff >= 0x8000)
+        {
+            p->stale++;
+            return false;
+        }
+        p->lost += diff - 1u;
+    }
+    p->synced = true;
+    p->last_seq = seq;
+    return true;
+}
+
+size_t remote_parser_feed(remote_parser_t *p, const uint8_t *data, size_t len, remote_msg_t *msg, bool *got)
+{
+    *got = false;
+    for (size_t i = 0; i < len; i++)
+    {
+        uint8_t c = data[i];
+        switch (p->pos)
+        {
+        case 0:
+            if (c == REMOTE_SOF0) p->buf[p->pos++] = c;
+            continue;
+        case 1:
+            if (c == REMOTE_SOF1) p->buf[p->pos++] = c;
+            else if (c != REMOTE_SOF0) p->pos = 0;
+            continue;
+        case 2:
+            if (c > REMOTE_MAX_PAYLOAD)
+            {
+                p->len_errors++;
+                p->pos = 0;
+                continue;
+            }
+            p->need = REMOTE_OVERHEAD + c;
+            break;
+        default:
+            break;
+        }
+        p->buf[p->pos++] = c;
+        if (p->pos < p->need) continue;
+
+        p->pos = 0;
+        uint8_t n = p->buf[2];
+        uint16_t crc = (uint16_t)(p->buf[6 + n] | (p->buf[7 + n] << 8));
+        if (crc != remote_crc16(&p->buf[2], 4 + n))
+        {
+            p->crc_errors++;
+            continue;
+        }
+        uint16_t seq = (uint16_t)(p->buf[3] | (p->buf[4] << 8));
+        if (!accept_seq(p, seq)) continue;
+
+        p->frames++;
+        msg->seq = seq;
+        msg->type = p->buf[5];
+        msg->len = n;
+        memcpy(msg->payload, &p->buf[6], n);
+        *got = true;
+        return i + 1;
+    }
+    return len;
+}
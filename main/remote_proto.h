@@ -0,0 +1,103 @@
+#ifndef _REMOTE_PROTO_H_
+#define _REMOTE_PROTO_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Framed binary remote-control protocol, shared by the firmware and the host client.
+ * All fields are little endian:
+ *
+ *   0xA5 0x5A | len | seq (2) | type | payload (len) | crc16 (2)
+ *
+ * The CRC is CRC-16/CCITT-FALSE over len..payload. The sender numbers every frame;
+ * the receiver drops frames that are not newer than the last one it accepted and
+ * counts the frames missing in between. A parser resynchronises on the next start
+ * bytes after any error, so it can share a line with other traffic.
+ */
+
+#define REMOTE_SOF0             0xA5
+#define REMOTE_SOF1             0x5A
+#define REMOTE_MAX_PAYLOAD      8
+#define REMOTE_OVERHEAD         8   // start, len, seq, type, crc
+#define REMOTE_MAX_FRAME        (REMOTE_OVERHEAD + REMOTE_MAX_PAYLOAD)
+
+typedef enum
+{
+    REMOTE_AIM       = 0x01, // int16 x, int16 y: aim velocity, -1000..1000 of full joystick deflection
+    REMOTE_LAUNCH    = 0x02, // start a launch
+    REMOTE_MODE      = 0x03, // uint8 remote_mode_t
+    REMOTE_PARAM     = 0x04, // uint8 remote_param_t, int32 value
+    REMOTE_HEARTBEAT = 0x05, // keeps the link alive while nothing changes
+    REMOTE_PING      = 0x06, // uint32 token, answered with REMOTE_PONG
+    REMOTE_PONG      = 0x81, // uint32 token
+} remote_type_t;
+
+typedef enum
+{
+    REMOTE_MODE_REHOME    = 0, // re-home the aim axes (key 1)
+    REMOTE_MODE_RANDOM    = 1, // random mode, then launch (key 3)
+    REMOTE_MODE_STABILIZE = 2, // toggle stabilization (key 4)
+    REMOTE_MODE_RELEASE   = 3, // hand control back to the local inputs
+} remote_mode_t;
+
+typedef enum
+{
+    REMOTE_PARAM_LAUNCH_SPEED = 1, // 0..1000 of the potentiometer range
+} remote_param_t;
+
+typedef struct
+{
+    uint16_t seq;
+    uint8_t type;
+    uint8_t len;
+    uint8_t payload[REMOTE_MAX_PAYLOAD];
+} remote_msg_t;
+
+typedef struct
+{
+    uint8_t buf[REMOTE_MAX_FRAME];
+    uint8_t pos;
+    uint8_t need;           // frame size once len is known
+    bool synced;            // a frame has been accepted, seq is valid
+    uint16_t last_seq;
+    uint32_t frames;        // accepted
+    uint32_t crc_errors;
+    uint32_t len_errors;
+    uint32_t stale;         // duplicate or out of order, dropped
+    uint32_t lost;          // sequence numbers skipped
+} remote_parser_t;
+
+uint16_t remote_crc16(const uint8_t *data, size_t len);
+size_t remote_encode(uint8_t out[REMOTE_MAX_FRAME], uint16_t seq, uint8_t type, const void *payload, uint8_t len);
+
+void remote_parser_init(remote_parser_t *p);
+void remote_parser_resync(remote_parser_t *p); // accept any seq next, e.g. after the sender restarted
+// Consumes bytes up to the end of the next accepted frame. Returns the bytes used
+// and sets *got when msg holds a frame; call again with the rest of the buffer.
+size_t remote_parser_feed(remote_parser_t *p, const uint8_t *data, size_t len, remote_msg_t *msg, bool *got);
+
+static inline int16_t remote_get_i16(const uint8_t *p)
+{
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static inline int32_t remote_get_i32(const uint8_t *p)
+{
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static inline void remote_put_i16(uint8_t *p, int16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)((uint16_t)v >> 8);
+}
+
+static inline void remote_put_i32(uint8_t *p, int32_t v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)((uint32_t)v >> (8 * i));
+}
+
+#endif // !_REMOTE_PROTO_H_
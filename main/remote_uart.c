@@ -0,0 +1,67 @@
+#include "remote_uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "remote_ctrl.h"
+
+static const char *TAG = "REMOTE_UART";
+
+#define REMOTE_UART_PORT        UART_NUM_2
+#define REMOTE_UART_TX          GPIO_NUM_NC     // not wired on this board yet
+#define REMOTE_UART_RX          GPIO_NUM_NC
+#define REMOTE_UART_BAUD        921600
+#define REMOTE_UART_RX_BUF      512
+#define REMOTE_UART_TOUT        2               // rx timeout in symbol times, hands short frames over quickly
+#define REMOTE_UART_TASK_PRIO   5               // below app_task: bytes wait in the driver buffer, not commands
+
+static remote_parser_t s_parser;
+
+static void uart_reply(const uint8_t *frame, size_t len, void *arg)
+{
+    uart_write_bytes(REMOTE_UART_PORT, frame, len);
+}
+
+static void remote_uart_task(void *arg)
+{
+    uint8_t buf[64];
+    while (1)
+    {
+        // block for the first byte, then take whatever else is already buffered
+        int n = uart_read_bytes(REMOTE_UART_PORT, buf, 1, portMAX_DELAY);
+        if (n <= 0) continue;
+        size_t more = 0;
+        uart_get_buffered_data_len(REMOTE_UART_PORT, &more);
+        if (more > sizeof(buf) - 1) more = sizeof(buf) - 1;
+        if (more) n += uart_read_bytes(REMOTE_UART_PORT, buf + 1, more, 0);
+        remote_ctrl_rx_bytes(&s_parser, buf, (size_t)n, esp_timer_get_time(), uart_reply, NULL);
+    }
+}
+
+esp_err_t remote_uart_start(void)
+{
+    if (REMOTE_UART_TX == GPIO_NUM_NC || REMOTE_UART_RX == GPIO_NUM_NC)
+    {
+        ESP_LOGW(TAG, "no UART pins assigned");
+        return ESP_ERR_NOT_FOUND;
+    }
+    const uart_config_t cfg = {
+        .baud_rate = REMOTE_UART_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    ESP_ERROR_CHECK(uart_driver_install(REMOTE_UART_PORT, REMOTE_UART_RX_BUF, 0, 0, NULL, 0));
+    ESP_ERROR_CHECK(uart_param_config(REMOTE_UART_PORT, &cfg));
+    ESP_ERROR_CHECK(uart_set_pin(REMOTE_UART_PORT, REMOTE_UART_TX, REMOTE_UART_RX, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+    ESP_ERROR_CHECK(uart_set_rx_timeout(REMOTE_UART_PORT, REMOTE_UART_TOUT));
+
+    remote_parser_init(&s_parser);
+    xTaskCreate(remote_uart_task, "remote_uart", 3072, NULL, REMOTE_UART_TASK_PRIO, NULL);
+    ESP_LOGI(TAG, "remote commands on UART%d, %d baud", REMOTE_UART_PORT, REMOTE_UART_BAUD);
+    return ESP_OK;
+}
@@ -0,0 +1,13 @@
+#ifndef _REMOTE_UART_H_
+#define _REMOTE_UART_H_
+
+#include "esp_err.h"
+
+/*
+ * UART transport for the remote protocol (remote_proto.h): a task feeds received
+ * bytes to remote_ctrl and answers pings on the same port.
+ */
+
+esp_err_t remote_uart_start(void);
+
+#endif // !_REMOTE_UART_H_
@@ -0,0 +1,76 @@
+#include "stab_ctrl.h"
+#include <string.h>
+
+#define MDEG_TURN   360000
+
+static int32_t attitude_axis(const attitude_t *att, int axis)
+{
+    return axis == 0 ? att->yaw_mdeg : att->pitch_mdeg;
+}
+
+static int32_t rate_axis(const attitude_t *att, int axis)
+{
+    return axis == 0 ? att->rate_mdps[2] : att->rate_mdps[1];
+}
+
+void stab_ctrl_init(stab_ctrl_t *c, const stab_gains_t *gains)
+{
+    memset(c, 0, sizeof(*c));
+    c->gains = *gains;
+}
+
+void stab_ctrl_hold(stab_ctrl_t *c, const attitude_t *att)
+{
+    for (int i = 0; i < STAB_AXES; i++)
+    {
+        c->target_q8[i] = attitude_axis(att, i) * 256;
+        c->rate_cmd_mdps[i] = 0;
+    }
+}
+
+void stab_ctrl_set_rate(stab_ctrl_t *c, int32_t yaw_mdps, int32_t pitch_mdps)
+{
+    c->rate_cmd_mdps[0] = yaw_mdps;
+    c->rate_cmd_mdps[1] = pitch_mdps;
+}
+
+void stab_ctrl_set_blocked(stab_ctrl_t *c, int axis, uint8_t blocked)
+{
+    if (axis >= 0 && axis < STAB_AXES) c->blocked[axis] = blocked;
+}
+
+static bool blocked_toward(uint8_t blocked, int32_t v)
+{
+    return (v > 0 && (blocked & STAB_BLOCK_POS)) || (v < 0 && (blocked & STAB_BLOCK_NEG));
+}
+
+void stab_ctrl_step(stab_ctrl_t *c, const attitude_t *att, uint32_t dt_us, int32_t duty[STAB_AXES])
+{
+    const stab_gains_t *g = &c->gains;
+    for (int i = 0; i < STAB_AXES; i++)
+    {
+        int32_t rate = blocked_toward(c->blocked[i], c->rate_cmd_mdps[i]) ? 0 : c->rate_cmd_mdps[i];
+        c->target_q8[i] += (int32_t)((int64_t)rate * 256 * dt_us / 1000000);
+        int32_t err = c->target_q8[i] / 256 - attitude_axis(att, i);
+        if (i == 0)
+        {
+            // yaw wraps, take the short way round
+            if (err > MDEG_TURN / 2) err -= MDEG_TURN;
+            if (err < -MDEG_TURN / 2) err += MDEG_TURN;
+        }
+        if (blocked_toward(c->blocked[i], err))
+        {
+            // the axis cannot get there: hold where it stopped
+            c->target_q8[i] = attitude_axis(att, i) * 256;
+            err = 0;
+        }
+        c->err_mdeg[i] = err;
+
+        int32_t u = fixq_mul(g->kp, err) + fixq_mul(g->kd, rate - rate_axis(att, i));
+        int32_t mag = u < 0 ? -u : u;
+        if (mag > g->duty_max) mag = g->duty_max;
+        if (mag < g->duty_min / 2) mag = 0;          // close enough, let the axis rest
+        else if (mag < g->duty_min) mag = g->duty_min; // below this the axis would stall
+        duty[i] = u < 0 ? -mag : mag;
+    }
+}
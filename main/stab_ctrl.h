@@ -0,0 +1,47 @@
+#ifndef _STAB_CTRL_H_
+#define _STAB_CTRL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "fixq.h"
+#include "attitude.h"
+
+/*
+ * Heading hold for the aim platform: a PD loop per axis (0 = yaw on motor 1,
+ * 1 = pitch on motor 2) on the filtered attitude. The joystick gives a rate
+ * command that moves the held target, so the base can turn under the platform
+ * while the operator still steers. Output is signed duty (MOTOR_DUTY_SCALE).
+ *
+ * While a limit switch stops an axis in one direction, the rate command no longer
+ * moves the target that way and the target is pulled back to the attitude, so
+ * holding the stick into a limit does not wind it up past the end of travel.
+ */
+
+#define STAB_AXES       2
+#define STAB_BLOCK_POS  0x01    // positive duty stopped at a limit switch
+#define STAB_BLOCK_NEG  0x02
+
+typedef struct
+{
+    q16_t kp;           // duty per mdeg of error
+    q16_t kd;           // duty per mdeg/s of rate error
+    int32_t duty_min;   // smallest duty that moves the axis
+    int32_t duty_max;
+} stab_gains_t;
+
+typedef struct
+{
+    stab_gains_t gains;
+    int32_t target_q8[STAB_AXES];   // held attitude in 1/256 mdeg
+    int32_t rate_cmd_mdps[STAB_AXES];
+    int32_t err_mdeg[STAB_AXES];    // last error, for reporting
+    uint8_t blocked[STAB_AXES];     // STAB_BLOCK_*
+} stab_ctrl_t;
+
+void stab_ctrl_init(stab_ctrl_t *c, const stab_gains_t *gains);
+void stab_ctrl_hold(stab_ctrl_t *c, const attitude_t *att); // hold the current attitude
+void stab_ctrl_set_rate(stab_ctrl_t *c, int32_t yaw_mdps, int32_t pitch_mdps);
+void stab_ctrl_set_blocked(stab_ctrl_t *c, int axis, uint8_t blocked);
+void stab_ctrl_step(stab_ctrl_t *c, const attitude_t *att, uint32_t dt_us, int32_t duty[STAB_AXES]);
+
+#endif // !_STAB_CTRL_H_
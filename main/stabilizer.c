@@ -0,0 +1,237 @@
+#include "stabilizer.h"
+#include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "attitude.h"
+#include "stab_ctrl.h"
+#include "motor_control.h"
+#include "input_frame.h"
+
+static const char *TAG = "STAB";
+
+#define STAB_TASK_PRIO      7       // above app_task, the loop must not wait for a control tick
+#define STAB_FIFO_MAX       8       // samples drained per wake, > STAB_PERIOD_US / IMU period
+#define STAB_DUTY_STEP      100     // smaller duty changes are not sent to the motor
+
+// motor direction that increases yaw / pitch, depends on the mechanics
+static const int8_t s_dir[STAB_AXES] = {1, 1};
+
+static const stab_gains_t s_gains = {
+    .kp = FIXQ_ONE * 3,
+    .kd = FIXQ_ONE / 10,
+    .duty_min = 1500,
+    .duty_max = 9000,
+};
+
+typedef struct
+{
+    uint32_t loops;
+    uint32_t overruns;      // timer fired again before the loop finished
+    uint32_t imu_errors;
+    uint32_t samples;
+    uint32_t exec_min_us;
+    uint32_t exec_max_us;
+    uint64_t exec_sum_us;
+    uint32_t jitter_max_us; // wake time against the nominal period
+    int64_t since_us;
+} stab_stats_t;
+
+static const imu_backend_t *s_imu = NULL;
+static TaskHandle_t s_task = NULL;
+static SemaphoreHandle_t s_lock = NULL; // enable flag and motor commands
+static bool s_enabled = false;
+static bool s_hold_pending = false;
+static atomic_int s_rate_mdps[STAB_AXES];
+static atomic_uint s_limits = INPUT_LIMIT_BIT(3) | INPUT_LIMIT_BIT(4) | INPUT_LIMIT_BIT(5) | INPUT_LIMIT_BIT(6); // released
+static atomic_bool s_ready;
+
+static attitude_t s_att;
+static stab_ctrl_t s_ctrl;
+static int8_t s_cmd_dir[STAB_AXES];
+static int32_t s_cmd_duty[STAB_AXES];
+static stab_stats_t s_stats;
+
+static void stats_reset(int64_t now)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.exec_min_us = UINT32_MAX;
+    s_stats.since_us = now;
+}
+
+static void timer_cb(void *arg)
+{
+    xTaskNotifyGive(s_task);
+}
+
+// limit switch that stops motor 1 + axis turning in direction dir: 3/4 and 5/6
+static bool stab_limit_hit(int axis, int8_t dir, uint32_t limits)
+{
+    uint8_t limit = (dir > 0) ? (3 + 2 * axis) : (4 + 2 * axis);
+    return (limits & INPUT_LIMIT_BIT(limit)) == 0;
+}
+
+// duty signs of an axis stopped by a limit switch, so stab_ctrl does not wind up its target
+static uint8_t stab_blocked(int axis, uint32_t limits)
+{
+    uint8_t blocked = 0;
+    if (stab_limit_hit(axis, s_dir[axis], limits)) blocked |= STAB_BLOCK_POS;
+    if (stab_limit_hit(axis, (int8_t)-s_dir[axis], limits)) blocked |= STAB_BLOCK_NEG;
+    return blocked;
+}
+
+static void stab_apply(int axis, int32_t duty, uint32_t limits)
+{
+    uint8_t motor = 1 + axis;
+    int8_t dir = duty > 0 ? s_dir[axis] : (duty < 0 ? -s_dir[axis] : 0);
+    int32_t mag = duty < 0 ? -duty : duty;
+    if (dir != 0 && stab_limit_hit(axis, dir, limits)) dir = 0;
+    if (dir == 0) mag = 0;
+    mag = mag / STAB_DUTY_STEP * STAB_DUTY_STEP;
+
+    if (dir == s_cmd_dir[axis] && mag == s_cmd_duty[axis]) return;
+    if (dir != 0)
+    {
+        motor_start_duty(motor, dir, (uint32_t)mag);
+    }
+    else
+    {
+        motor_stop_mode(motor, MOTOR_STOP_BRAKE);
+    }
+    s_cmd_dir[axis] = dir;
+    s_cmd_duty[axis] = mag;
+}
+
+static void stab_task(void *arg)
+{
+    imu_sample_t buf[STAB_FIFO_MAX];
+    int64_t last_us = esp_timer_get_time();
+
+    while (1)
+    {
+        uint32_t wakes = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int64_t t0 = esp_timer_get_time();
+        int64_t dt_us = t0 - last_us;
+        last_us = t0;
+        if (wakes > 1) s_stats.overruns += wakes - 1;
+        uint32_t jitter = (uint32_t)(dt_us > STAB_PERIOD_US ? dt_us - STAB_PERIOD_US : STAB_PERIOD_US - dt_us);
+        if (jitter > s_stats.jitter_max_us) s_stats.jitter_max_us = jitter;
+        if (dt_us > 4 * STAB_PERIOD_US) dt_us = 4 * STAB_PERIOD_US;
+
+        int n = s_imu->read_fifo(buf, STAB_FIFO_MAX);
+        if (n < 0)
+        {
+            s_stats.imu_errors++;
+            n = 0;
+        }
+        for (int i = 0; i < n; i++) attitude_update(&s_att, &buf[i]);
+        s_stats.samples += n;
+        atomic_store(&s_ready, attitude_ready(&s_att));
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        if (s_enabled && attitude_ready(&s_att))
+        {
+            if (s_hold_pending)
+            {
+                stab_ctrl_hold(&s_ctrl, &s_att);
+                s_hold_pending = false;
+            }
+            uint32_t limits = atomic_load(&s_limits);
+            stab_ctrl_set_rate(&s_ctrl, atomic_load(&s_rate_mdps[0]), atomic_load(&s_rate_mdps[1]));
+            for (int i = 0; i < STAB_AXES; i++) stab_ctrl_set_blocked(&s_ctrl, i, stab_blocked(i, limits));
+            int32_t duty[STAB_AXES];
+            stab_ctrl_step(&s_ctrl, &s_att, (uint32_t)dt_us, duty);
+            for (int i = 0; i < STAB_AXES; i++) stab_apply(i, duty[i], limits);
+        }
+        xSemaphoreGive(s_lock);
+
+        uint32_t exec = (uint32_t)(esp_timer_get_time() - t0);
+        s_stats.loops++;
+        s_stats.exec_sum_us += exec;
+        if (exec < s_stats.exec_min_us) s_stats.exec_min_us = exec;
+        if (exec > s_stats.exec_max_us) s_stats.exec_max_us = exec;
+    }
+}
+
+esp_err_t stabilizer_start(const imu_backend_t *imu)
+{
+    esp_err_t ret = imu->init();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "%s init failed: %s", imu->name, esp_err_to_name(ret));
+        return ret;
+    }
+    s_imu = imu;
+    attitude_init(&s_att);
+    stab_ctrl_init(&s_ctrl, &s_gains);
+    stats_reset(esp_timer_get_time());
+    atomic_init(&s_ready, false);
+    s_lock = xSemaphoreCreateMutex();
+    if (s_lock == NULL) return ESP_ERR_NO_MEM;
+    if (xTaskCreate(stab_task, "stab_task", 4096, NULL, STAB_TASK_PRIO, &s_task) != pdPASS) return ESP_ERR_NO_MEM;
+
+    const esp_timer_create_args_t args = {
+        .callback = timer_cb,
+        .name = "stab",
+    };
+    esp_timer_handle_t timer;
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, STAB_PERIOD_US));
+    ESP_LOGI(TAG, "stabilizer: %s, %d Hz", imu->name, 1000000 / STAB_PERIOD_US);
+    return ESP_OK;
+}
+
+bool stabilizer_available(void)
+{
+    return s_task != NULL && atomic_load(&s_ready);
+}
+
+void stabilizer_enable(bool on)
+{
+    if (s_lock == NULL) return;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (on && !s_enabled)
+    {
+        s_hold_pending = true;
+        memset(s_cmd_dir, 0, sizeof(s_cmd_dir)); // the caller hands over stopped motors
+        memset(s_cmd_duty, 0, sizeof(s_cmd_duty));
+        atomic_store(&s_rate_mdps[0], 0);
+        atomic_store(&s_rate_mdps[1], 0);
+    }
+    s_enabled = on;
+    xSemaphoreGive(s_lock);
+}
+
+void stabilizer_set_rate(int32_t yaw_mdps, int32_t pitch_mdps)
+{
+    atomic_store(&s_rate_mdps[0], yaw_mdps);
+    atomic_store(&s_rate_mdps[1], pitch_mdps);
+}
+
+void stabilizer_set_limits(uint32_t gpio)
+{
+    atomic_store(&s_limits, gpio);
+}
+
+void stabilizer_log_stats(void)
+{
+    if (s_task == NULL) return;
+    int64_t now = esp_timer_get_time();
+    stab_stats_t st = s_stats; // counters only, a torn read just skews one report
+    stats_reset(now);
+    if (st.loops == 0) return;
+
+    uint32_t avg = (uint32_t)(st.exec_sum_us / st.loops);
+    uint32_t load = (uint32_t)(st.exec_sum_us * 1000 / (uint64_t)(now - st.since_us)); // 0.1%
+    ESP_LOGI(TAG, "%" PRIu32 " loops, exec %" PRIu32 "/%" PRIu32 "/%" PRIu32 " us, jitter max %" PRIu32 " us, "
+             "load %" PRIu32 ".%" PRIu32 "%%, %" PRIu32 " overruns, %" PRIu32 " imu errors, %" PRIu32 " samples",
+             st.loops, st.exec_min_us, avg, st.exec_max_us, st.jitter_max_us,
+             load / 10, load % 10, st.overruns, st.imu_errors, st.samples);
+    ESP_LOGI(TAG, "yaw %" PRId32 " pitch %" PRId32 " mdeg, error %" PRId32 "/%" PRId32 " mdeg",
+             s_att.yaw_mdeg, s_att.pitch_mdeg, s_ctrl.err_mdeg[0], s_ctrl.err_mdeg[1]);
+}
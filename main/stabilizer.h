@@ -0,0 +1,29 @@
+#ifndef _STABILIZER_H_
+#define _STABILIZER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "imu.h"
+
+/*
+ * High-rate stabilization loop for the aim axes. A periodic timer wakes a task at
+ * STAB_PERIOD_US that drains the IMU FIFO through the attitude filter and, while
+ * enabled, runs stab_ctrl and drives motors 1 and 2 directly. The control core only
+ * switches it on and off and forwards the joystick as a rate command and the limit
+ * switches of the input frame, so the loop sees the same limits that are recorded;
+ * the loop runs whether or not it is enabled so the filter stays converged.
+ */
+
+#define STAB_PERIOD_US      2000    // 500 Hz
+#define STAB_RATE_MAX_MDPS  30000   // joystick full deflection while stabilizing
+
+esp_err_t stabilizer_start(const imu_backend_t *imu);
+bool stabilizer_available(void);    // started and the attitude filter has converged, sampled into the input frame
+void stabilizer_enable(bool on);    // on: hold the current attitude; off: returns once the loop has let go of the motors
+void stabilizer_set_rate(int32_t yaw_mdps, int32_t pitch_mdps);
+void stabilizer_set_limits(uint32_t gpio); // input frame gpio word, limit switch bits are used
+void stabilizer_log_stats(void);    // loop timing since the last call
+
+#endif // !_STABILIZER_H_
@@ -0,0 +1,183 @@
+#include "tune_cfg.h"
+#include <string.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "nvs.h"
+
+#include "core_local.h"
+#include "motion_progs.h"
+
+static const char *TAG = "TUNE_CFG";
+
+#define TUNE_NVS_NAMESPACE  "tune"
+#define TUNE_NVS_SCHEMA_KEY "schema"
+
+#define PARAM(id, key, field, lo, hi, text)  [id] = {key, offsetof(tune_cfg_t, field), lo, hi, text}
+
+static const tune_param_info_t s_params[TUNE_PARAM_COUNT] = {
+    PARAM(TUNE_JOY_DZ_LO_X, "joy_dz_lo_x", joy_dz_lo[0], 0, 4095, "joystick X deadzone low edge (calibrated)"),
+    PARAM(TUNE_JOY_DZ_HI_X, "joy_dz_hi_x", joy_dz_hi[0], 0, 4095, "joystick X deadzone high edge (calibrated)"),
+    PARAM(TUNE_JOY_DZ_LO_Y, "joy_dz_lo_y", joy_dz_lo[1], 0, 4095, "joystick Y deadzone low edge (calibrated)"),
+    PARAM(TUNE_JOY_DZ_HI_Y, "joy_dz_hi_y", joy_dz_hi[1], 0, 4095, "joystick Y deadzone high edge (calibrated)"),
+    PARAM(TUNE_JOY_DUTY_MIN, "joy_duty_min", joy_duty_min, 0, 10000, "aim duty at the deadzone edge (1/10000)"),
+    PARAM(TUNE_JOY_DUTY_MAX, "joy_duty_max", joy_duty_max, 1000, 10000, "aim duty at full deflection (1/10000)"),
+    PARAM(TUNE_DUTY_PCT, "duty_pct", duty_pct, 10, 100, "launch / homing duty (%)"),
+    PARAM(TUNE_PWM_HZ_1, "pwm_hz_1", pwm_hz[0], 200, 100000, "motor 1 PWM frequency (Hz)"),
+    PARAM(TUNE_PWM_HZ_2, "pwm_hz_2", pwm_hz[1], 200, 100000, "motor 2 PWM frequency (Hz)"),
+    PARAM(TUNE_PWM_HZ_3, "pwm_hz_3", pwm_hz[2], 200, 100000, "motor 3 PWM frequency (Hz)"),
+    PARAM(TUNE_RANDOM_MS, "random_ms", random_ms, 1000, 15000, "random mode duration (ms)"),
+    PARAM(TUNE_KEY_DEBOUNCE_MS, "key_debounce_ms", key_debounce_ms, 0, 200, "key debounce, 0 = off (ms)"),
+    PARAM(TUNE_BRIGHTNESS, "brightness", brightness, 0, 7, "display brightness"),
+    PARAM(TUNE_LAUNCH_PROG, "launch_prog", launch_prog, 1, MOTION_PROG_COUNT, "launch key motion program"),
+    PARAM(TUNE_KEY3_PROG, "key3_prog", key3_prog, 0, MOTION_PROG_COUNT, "key 3 motion program, 0 = random mode"),
+    PARAM(TUNE_DISPLAY_PAGE_MS, "disp_page_ms", display_page_ms, 0, 60000, "display page rotation, 0 = speed only (ms)"),
+};
+
+static const tune_cfg_t s_default = {
+    .version = 1,
+    .joy_dz_lo = {1500, 1300},
+    .joy_dz_hi = {1600, 1400},
+    .joy_duty_min = 2000,
+    .joy_duty_max = 9000,
+    .duty_pct = 90,
+    .pwm_hz = {25000, 25000, 25000},
+    .random_ms = 5000,
+    .key_debounce_ms = 0,
+    .brightness = 3,
+    .launch_prog = MOTION_PROG_LAUNCH,
+    .key3_prog = MOTION_PROG_NONE,
+    .display_page_ms = 0,
+};
+
+static CORE_LOCAL tune_cfg_t s_slots[2];
+static CORE_LOCAL uint8_t s_next_slot = 0;
+static CORE_LOCAL int64_t s_published_us = 0;
+static CORE_LOCAL bool s_published = false;
+static CORE_LOCAL _Atomic(const tune_cfg_t *) s_cur = &s_default;
+
+const tune_cfg_t *tune_cfg_get(void)
+{
+    return atomic_load_explicit(&s_cur, memory_order_acquire);
+}
+
+const tune_cfg_t *tune_cfg_defaults(void)
+{
+    return &s_default;
+}
+
+bool tune_cfg_valid(const tune_cfg_t *cfg)
+{
+    for (int i = 0; i < TUNE_PARAM_COUNT; i++)
+    {
+        uint32_t v = tune_cfg_value(cfg, (tune_param_t)i);
+        if (v < s_params[i].min || v > s_params[i].max) return false;
+    }
+    for (int a = 0; a < 2; a++)
+    {
+        if (cfg->joy_dz_lo[a] >= cfg->joy_dz_hi[a]) return false;
+    }
+    return cfg->joy_duty_min <= cfg->joy_duty_max;
+}
+
+bool tune_cfg_publish(const tune_cfg_t *draft, int64_t now_us)
+{
+    if (!tune_cfg_valid(draft)) return false;
+    if (s_published && (now_us - s_published_us) < TUNE_CFG_GRACE_US) return false;
+
+    tune_cfg_t *slot = &s_slots[s_next_slot];
+    *slot = *draft;
+    slot->version = tune_cfg_get()->version + 1;
+    atomic_store_explicit(&s_cur, (const tune_cfg_t *)slot, memory_order_release);
+    s_next_slot ^= 1;
+    s_published = true;
+    s_published_us = now_us;
+    return true;
+}
+
+const tune_param_info_t *tune_param_info(tune_param_t id)
+{
+    return (id < TUNE_PARAM_COUNT) ? &s_params[id] : NULL;
+}
+
+int tune_param_find(const char *name)
+{
+    for (int i = 0; i < TUNE_PARAM_COUNT; i++)
+    {
+        if (strcmp(s_params[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+uint32_t tune_cfg_value(const tune_cfg_t *cfg, tune_param_t id)
+{
+    uint32_t v;
+    memcpy(&v, (const uint8_t *)cfg + s_params[id].offset, sizeof(v));
+    return v;
+}
+
+bool tune_cfg_put(tune_cfg_t *cfg, tune_param_t id, uint32_t value)
+{
+    if (id >= TUNE_PARAM_COUNT || value < s_params[id].min || value > s_params[id].max) return false;
+    memcpy((uint8_t *)cfg + s_params[id].offset, &value, sizeof(value));
+    return true;
+}
+
+esp_err_t tune_cfg_load(tune_cfg_t *out)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(TUNE_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) return err;
+
+    uint32_t schema = 0;
+    nvs_get_u32(nvs, TUNE_NVS_SCHEMA_KEY, &schema);
+    if (schema != TUNE_CFG_SCHEMA)
+    {
+        nvs_close(nvs);
+        ESP_LOGW(TAG, "Stored parameters have schema %" PRIu32 ", expected %d, using defaults", schema, TUNE_CFG_SCHEMA);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    tune_cfg_t cfg = s_default;
+    int loaded = 0;
+    for (int i = 0; i < TUNE_PARAM_COUNT; i++)
+    {
+        uint32_t v;
+        if (nvs_get_u32(nvs, s_params[i].name, &v) != ESP_OK) continue;
+        if (tune_cfg_put(&cfg, (tune_param_t)i, v))
+        {
+            loaded++;
+        }
+        else
+        {
+            ESP_LOGW(TAG, "Stored %s = %" PRIu32 " out of range, using %" PRIu32, s_params[i].name, v, tune_cfg_value(&s_default, (tune_param_t)i));
+        }
+    }
+    nvs_close(nvs);
+
+    if (!tune_cfg_valid(&cfg))
+    {
+        ESP_LOGW(TAG, "Stored parameters are inconsistent, using defaults");
+        return ESP_ERR_INVALID_STATE;
+    }
+    *out = cfg;
+    ESP_LOGI(TAG, "Loaded %d stored parameters", loaded);
+    return ESP_OK;
+}
+
+esp_err_t tune_cfg_save(void)
+{
+    const tune_cfg_t *cfg = tune_cfg_get();
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(TUNE_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+    for (int i = 0; i < TUNE_PARAM_COUNT && err == ESP_OK; i++)
+    {
+        err = nvs_set_u32(nvs, s_params[i].name, tune_cfg_value(cfg, (tune_param_t)i));
+    }
+    if (err == ESP_OK) err = nvs_set_u32(nvs, TUNE_NVS_SCHEMA_KEY, TUNE_CFG_SCHEMA);
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+    return err;
+}
@@ -0,0 +1,88 @@
+#ifndef _TUNE_CFG_H_
+#define _TUNE_CFG_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * Runtime-tunable parameters. Readers call tune_cfg_get() and get a pointer to an
+ * immutable, versioned snapshot: one atomic load, no locks, and the fields sit in
+ * one small struct. A single writer (the console) edits a copy and publishes it with
+ * tune_cfg_publish(), which swaps the pointer atomically.
+ *
+ * Snapshots live in two alternating slots, so a slot is rewritten two publishes
+ * after it went live. Publishing is refused within TUNE_CFG_GRACE_US of the previous
+ * one, which is how long a reader may keep a pointer; readers that need the values
+ * for longer copy the struct (the control core does, once per change).
+ *
+ * Values persist in NVS under their parameter names with a schema version; a stored
+ * set with another schema is ignored. Changes reach the control core at a tick
+ * boundary through control_core_set_cfg() and are recorded, so replay stays exact.
+ */
+
+#define TUNE_CFG_SCHEMA     1
+#define TUNE_CFG_GRACE_US   100000
+
+typedef enum
+{
+    TUNE_JOY_DZ_LO_X,
+    TUNE_JOY_DZ_HI_X,
+    TUNE_JOY_DZ_LO_Y,
+    TUNE_JOY_DZ_HI_Y,
+    TUNE_JOY_DUTY_MIN,
+    TUNE_JOY_DUTY_MAX,
+    TUNE_DUTY_PCT,
+    TUNE_PWM_HZ_1,
+    TUNE_PWM_HZ_2,
+    TUNE_PWM_HZ_3,
+    TUNE_RANDOM_MS,
+    TUNE_KEY_DEBOUNCE_MS,
+    TUNE_BRIGHTNESS,
+    TUNE_LAUNCH_PROG,
+    TUNE_KEY3_PROG,
+    TUNE_DISPLAY_PAGE_MS,
+    TUNE_PARAM_COUNT,
+} tune_param_t;
+
+typedef struct
+{
+    uint32_t version;           // increments with every publish
+    uint32_t joy_dz_lo[2];      // joystick deadzone X/Y, calibrated scale (joy_cal.h)
+    uint32_t joy_dz_hi[2];
+    uint32_t joy_duty_min;      // duty at the deadzone edge (MOTOR_DUTY_SCALE)
+    uint32_t joy_duty_max;      // duty at full deflection
+    uint32_t duty_pct;          // motor_start_forward / reverse duty
+    uint32_t pwm_hz[3];
+    uint32_t random_ms;         // random mode duration
+    uint32_t key_debounce_ms;   // 0 = keys act on the first sample
+    uint32_t brightness;        // TM1637 0..7
+    uint32_t launch_prog;       // motion program of the launch key (motion_progs.h)
+    uint32_t key3_prog;         // motion program of key 3, 0 = random mode
+    uint32_t display_page_ms;   // display page rotation, 0 = speed page only
+} tune_cfg_t;
+
+typedef struct
+{
+    const char *name;           // NVS key and console name
+    uint16_t offset;            // into tune_cfg_t
+    uint32_t min;
+    uint32_t max;
+    const char *help;
+} tune_param_info_t;
+
+const tune_cfg_t *tune_cfg_get(void);
+const tune_cfg_t *tune_cfg_defaults(void);
+bool tune_cfg_publish(const tune_cfg_t *draft, int64_t now_us); // false if invalid or too soon
+bool tune_cfg_valid(const tune_cfg_t *cfg);                     // cross-field checks
+
+const tune_param_info_t *tune_param_info(tune_param_t id);
+int tune_param_find(const char *name); // -1 if unknown
+uint32_t tune_cfg_value(const tune_cfg_t *cfg, tune_param_t id);
+bool tune_cfg_put(tune_cfg_t *cfg, tune_param_t id, uint32_t value); // false if out of range
+
+esp_err_t tune_cfg_load(tune_cfg_t *out); // stored values, defaults for the rest; caller publishes
+esp_err_t tune_cfg_save(void); // stores the current snapshot
+
+#endif // !_TUNE_CFG_H_
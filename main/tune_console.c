@@ -0,0 +1,371 @@
+#include "tune_console.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "tune_cfg.h"
+#include "lat_hist.h"
+#include "joy_cal.h"
+#include "power_mgr.h"
+#include "bench.h"
+#include "journal.h"
+#include "motion_progs.h"
+#include "display_service.h"
+
+static const char *TAG = "TUNE_CONSOLE";
+
+#define TUNE_CONSOLE_PROMPT     "esp32> "
+#define TUNE_CONSOLE_TASK_PRIO  2       // below every control task
+#define TUNE_STATS_MAX_TASKS    24
+#define TUNE_SWEEP_MS_DEFAULT   5000
+#define TUNE_JOURNAL_DEFAULT    20
+#define TUNE_CONSOLE_LINE_MAX   (2 * MOTION_PROG_MAX + 32) // prog put with a full program in hex
+
+// Publishing is refused right after the previous one (TUNE_CFG_GRACE_US), wait it out.
+static void publish(const tune_cfg_t *draft)
+{
+    while (!tune_cfg_publish(draft, esp_timer_get_time()))
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static void print_param(const tune_cfg_t *cfg, tune_param_t id)
+{
+    const tune_param_info_t *p = tune_param_info(id);
+    printf("%-16s %7" PRIu32 "   [%" PRIu32 "..%" PRIu32 ", default %" PRIu32 "]  %s\n", p->name, tune_cfg_value(cfg, id),
+           p->min, p->max, tune_cfg_value(tune_cfg_defaults(), id), p->help);
+}
+
+static int cmd_get(int argc, char **argv)
+{
+    const tune_cfg_t *cfg = tune_cfg_get();
+    if (argc >= 2)
+    {
+        int id = tune_param_find(argv[1]);
+        if (id < 0)
+        {
+            printf("unknown parameter '%s'\n", argv[1]);
+            return 1;
+        }
+        print_param(cfg, (tune_param_t)id);
+        return 0;
+    }
+    printf("config version %" PRIu32 "\n", cfg->version);
+    for (int i = 0; i < TUNE_PARAM_COUNT; i++) print_param(cfg, (tune_param_t)i);
+    return 0;
+}
+
+static int cmd_set(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        printf("usage: set <name> <value>\n");
+        return 1;
+    }
+    int id = tune_param_find(argv[1]);
+    if (id < 0)
+    {
+        printf("unknown parameter '%s'\n", argv[1]);
+        return 1;
+    }
+    char *end;
+    unsigned long v = strtoul(argv[2], &end, 0);
+    tune_cfg_t draft = *tune_cfg_get();
+    if (*end != '\0' || !tune_cfg_put(&draft, (tune_param_t)id, (uint32_t)v))
+    {
+        const tune_param_info_t *p = tune_param_info((tune_param_t)id);
+        printf("%s: value must be %" PRIu32 "..%" PRIu32 "\n", p->name, p->min, p->max);
+        return 1;
+    }
+    if (!tune_cfg_valid(&draft))
+    {
+        printf("rejected: deadzone low must stay below high, duty min at most duty max\n");
+        return 1;
+    }
+    publish(&draft);
+    print_param(tune_cfg_get(), (tune_param_t)id);
+    return 0;
+}
+
+static int cmd_save(int argc, char **argv)
+{
+    esp_err_t err = tune_cfg_save();
+    printf("%s\n", err == ESP_OK ? "saved" : esp_err_to_name(err));
+    return err == ESP_OK ? 0 : 1;
+}
+
+static int cmd_load(int argc, char **argv)
+{
+    tune_cfg_t cfg;
+    esp_err_t err = tune_cfg_load(&cfg);
+    if (err != ESP_OK)
+    {
+        printf("%s\n", esp_err_to_name(err));
+        return 1;
+    }
+    publish(&cfg);
+    printf("loaded\n");
+    return 0;
+}
+
+static int cmd_defaults(int argc, char **argv)
+{
+    publish(tune_cfg_defaults());
+    printf("defaults in effect, 'save' to keep them\n");
+    return 0;
+}
+
+static void print_tasks(void)
+{
+#if configUSE_TRACE_FACILITY
+    static TaskStatus_t tasks[TUNE_STATS_MAX_TASKS];
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t n = uxTaskGetSystemState(tasks, TUNE_STATS_MAX_TASKS, &total);
+    if (n == 0)
+    {
+        printf("more than %d tasks\n", TUNE_STATS_MAX_TASKS);
+        return;
+    }
+    printf("task              prio  cpu%%  stack free\n");
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        const TaskStatus_t *t = &tasks[i];
+#if configGENERATE_RUN_TIME_STATS
+        uint32_t permille = total ? (uint32_t)((uint64_t)t->ulRunTimeCounter * 1000 / total) : 0;
+#else
+        uint32_t permille = 0;
+#endif
+        printf("%-16s %5u %3" PRIu32 ".%" PRIu32 " %11u\n", t->pcTaskName, (unsigned)t->uxCurrentPriority,
+               permille / 10, permille % 10, (unsigned)t->usStackHighWaterMark);
+    }
+#else
+    printf("task list needs CONFIG_FREERTOS_USE_TRACE_FACILITY\n");
+#endif
+}
+
+static int cmd_stats(int argc, char **argv)
+{
+    print_tasks();
+
+    bench_result_t loop;
+    bench_get(&loop, (argc >= 2) && (strcmp(argv[1], "-r") == 0));
+    power_stats_t pm;
+    power_mgr_get_stats(&pm);
+    lat_summary_t wake;
+    lat_hist_get_summary(LAT_WAKE_DRIVE, &wake);
+    printf("power: %" PRIu32 " sleeps, %" PRIu32 " pin wakes, low-power wait %" PRIu32 "%% of %" PRIu32 " s\n", pm.sleeps,
+           pm.pin_wakes, pm.since_us ? (uint32_t)(pm.asleep_us * 100 / pm.since_us) : 0, (uint32_t)(pm.since_us / 1000000));
+    printf("wake->drive: %" PRIu32 " samples, min %" PRIu32 " us, p50 <= %" PRIu32 " us, max %" PRIu32 " us\n", wake.count,
+           wake.min_us, wake.p50_us, wake.max_us);
+    display_stats_t disp;
+    display_service_get_stats(&disp);
+    printf("display: %" PRIu32 " posts, %" PRIu32 " frames, %" PRIu32 " control writes, bus max %" PRIu32 " us\n", disp.posts,
+           disp.frames, disp.controls, disp.bus_max_us);
+
+    if (loop.ticks == 0)
+    {
+        printf("control loop: no ticks yet\n");
+        return 0;
+    }
+    printf("control loop: %" PRIu32 " ticks, busy avg %" PRIu32 " / max %" PRIu32 " us, period %" PRIu32 "..%" PRIu32 " us\n",
+           loop.ticks, loop.busy_avg_us, loop.busy_max_us, loop.period_min_us, loop.period_max_us);
+    return 0;
+}
+
+static int cmd_bench(int argc, char **argv)
+{
+    bench_report((argc >= 2) && (strcmp(argv[1], "-r") == 0));
+    return 0;
+}
+
+static int cmd_lat(int argc, char **argv)
+{
+    bool buckets = false, reset = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-b") == 0) buckets = true;
+        else if (strcmp(argv[i], "-r") == 0) reset = true;
+    }
+    lat_hist_log(buckets);
+    if (reset) lat_hist_reset();
+    return 0;
+}
+
+static void print_cal(void)
+{
+    joy_cal_t cal;
+    joy_cal_get(&cal);
+    for (int i = 0; i < 2; i++)
+    {
+        const joy_cal_axis_t *a = &cal.axis[i];
+        printf("%c: center %4u  noise %3u  travel %4u..%4u\n", "XY"[i], a->center, a->noise, a->min, a->max);
+    }
+}
+
+static esp_err_t save_cal(void)
+{
+    joy_cal_t cal;
+    joy_cal_get(&cal);
+    esp_err_t err = joy_cal_save(&cal);
+    printf("%s\n", err == ESP_OK ? "calibration saved" : esp_err_to_name(err));
+    return err;
+}
+
+static int cmd_cal(int argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "save") == 0) return save_cal() == ESP_OK ? 0 : 1;
+    if (argc >= 2 && strcmp(argv[1], "sweep") == 0)
+    {
+        uint32_t ms = (argc >= 3) ? (uint32_t)strtoul(argv[2], NULL, 0) : TUNE_SWEEP_MS_DEFAULT;
+        printf("move the stick to every end stop within %" PRIu32 " ms...\n", ms);
+        if (!joy_cal_sweep(ms, 1000))
+        {
+            printf("sweep incomplete, travel unchanged\n");
+            return 1;
+        }
+        print_cal();
+        return save_cal() == ESP_OK ? 0 : 1;
+    }
+    if (argc >= 2)
+    {
+        printf("usage: cal [sweep [ms] | save]\n");
+        return 1;
+    }
+    print_cal();
+    return 0;
+}
+
+// Flushing from the console stalls the control loop for the erase/write; the operator asks for it.
+static int cmd_journal(int argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "flush") == 0)
+    {
+        esp_err_t err = journal_flush();
+        printf("%s\n", err == ESP_OK ? "journal flushed" : esp_err_to_name(err));
+        return err == ESP_OK ? 0 : 1;
+    }
+    journal_stats_t st;
+    journal_get_stats(&st);
+    printf("boot %" PRIu32 ": %" PRIu32 " written, %" PRIu32 " pending, %" PRIu32 " dropped, flush max %" PRIu32 " us, capacity %" PRIu32 "\n",
+           st.boot, st.written, st.pending, st.dropped, st.flush_max_us, st.capacity);
+    journal_dump((argc >= 2) ? (size_t)strtoul(argv[1], NULL, 0) : TUNE_JOURNAL_DEFAULT);
+    return 0;
+}
+
+static void print_prog(uint8_t id, bool code)
+{
+    const motion_prog_t *prog = motion_prog_get(id);
+    if (prog == NULL)
+    {
+        printf("%d  (empty)\n", id);
+        return;
+    }
+    printf("%d  %-15s %3u bytes, motors 0x%x%s\n", id, prog->name, prog->len, prog->motors,
+           (id <= MOTION_BUILTIN_COUNT) ? ", built-in" : "");
+    if (!code) return;
+    size_t pc = 0;
+    do
+    {
+        char line[64];
+        pc = motion_disasm(prog->code, prog->len, pc, line, sizeof(line));
+        printf("    %s\n", line);
+    } while (pc != 0);
+}
+
+// hex from host/motion_asm -x
+static size_t parse_hex(const char *hex, uint8_t *out, size_t size)
+{
+    size_t n = 0;
+    while (hex[0] && hex[1] && n < size)
+    {
+        char byte[3] = {hex[0], hex[1], '\0'};
+        char *end;
+        out[n++] = (uint8_t)strtoul(byte, &end, 16);
+        if (*end != '\0') return 0;
+        hex += 2;
+    }
+    return (*hex == '\0') ? n : 0;
+}
+
+// Stored programs are loaded at the next restart, never under a running interpreter.
+static int cmd_prog(int argc, char **argv)
+{
+    uint8_t id = (argc >= 3) ? (uint8_t)strtoul(argv[2], NULL, 0) : 0;
+    if (argc < 2 || strcmp(argv[1], "list") == 0)
+    {
+        for (uint8_t i = 1; i <= MOTION_PROG_COUNT; i++) print_prog(i, false);
+        return 0;
+    }
+    if (strcmp(argv[1], "show") == 0 && argc >= 3)
+    {
+        print_prog(id, true);
+        return 0;
+    }
+    if (strcmp(argv[1], "put") == 0 && argc >= 5)
+    {
+        uint8_t code[MOTION_PROG_MAX];
+        size_t len = parse_hex(argv[4], code, sizeof(code)), err_pc = 0;
+        motion_err_t verr = motion_validate(code, len, NULL, &err_pc);
+        if (verr != MOTION_OK)
+        {
+            printf("invalid program: %s at byte %d\n", motion_err_name(verr), (int)err_pc);
+            return 1;
+        }
+        esp_err_t err = motion_prog_store(id, argv[3], code, len);
+        printf("%s\n", err == ESP_OK ? "stored, loaded at the next restart" : esp_err_to_name(err));
+        return err == ESP_OK ? 0 : 1;
+    }
+    if (strcmp(argv[1], "del") == 0 && argc >= 3)
+    {
+        esp_err_t err = motion_prog_erase(id);
+        printf("%s\n", err == ESP_OK ? "erased, gone after the next restart" : esp_err_to_name(err));
+        return err == ESP_OK ? 0 : 1;
+    }
+    printf("usage: prog [list | show <id> | put <id> <name> <hex> | del <id>]\n");
+    return 1;
+}
+
+esp_err_t tune_console_start(void)
+{
+    const esp_console_cmd_t cmds[] = {
+        {.command = "get", .help = "Show tuning parameters", .hint = "[name]", .func = cmd_get},
+        {.command = "set", .help = "Set a tuning parameter, effective at the next control tick", .hint = "<name> <value>", .func = cmd_set},
+        {.command = "save", .help = "Store the current parameters in NVS", .func = cmd_save},
+        {.command = "load", .help = "Go back to the parameters stored in NVS", .func = cmd_load},
+        {.command = "defaults", .help = "Use the built-in defaults (not saved)", .func = cmd_defaults},
+        {.command = "stats", .help = "Task CPU and stack, control loop timing; -r resets the loop timing", .hint = "[-r]", .func = cmd_stats},
+        {.command = "bench", .help = "Runtime benchmark: latency, jitter, CPU load, RAM; -r resets", .hint = "[-r]", .func = cmd_bench},
+        {.command = "lat", .help = "Input-to-actuation latency; -b buckets, -r reset", .hint = "[-b] [-r]", .func = cmd_lat},
+        {.command = "journal", .help = "Fault and event journal: last n records (pending ones after a flush)", .hint = "[n | flush]", .func = cmd_journal},
+        {.command = "cal", .help = "Joystick calibration; sweep learns the travel and saves it, save keeps the drifted center", .hint = "[sweep [ms] | save]", .func = cmd_cal},
+        {.command = "prog", .help = "Motion programs: list, disassemble, store a user program (ids 4-7) or erase it", .hint = "[list | show <id> | put <id> <name> <hex> | del <id>]", .func = cmd_prog},
+    };
+    for (size_t i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++)
+    {
+        ESP_ERROR_CHECK(esp_console_cmd_register(&cmds[i]));
+    }
+    ESP_ERROR_CHECK(esp_console_register_help_command());
+
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_cfg = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_cfg.prompt = TUNE_CONSOLE_PROMPT;
+    repl_cfg.task_priority = TUNE_CONSOLE_TASK_PRIO;
+    repl_cfg.max_cmdline_length = TUNE_CONSOLE_LINE_MAX;
+    esp_console_dev_uart_config_t uart_cfg = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    esp_err_t err = esp_console_new_repl_uart(&uart_cfg, &repl_cfg, &repl);
+    if (err == ESP_OK) err = esp_console_start_repl(repl);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Console not started: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "Tuning console ready, type 'help'");
+    return ESP_OK;
+}
@@ -0,0 +1,25 @@
+#ifndef _TUNE_CONSOLE_H_
+#define _TUNE_CONSOLE_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * Serial console (esp_console REPL on the log UART) for live tuning:
+ *
+ *   get [name]            list parameters, or one, with range and default
+ *   set <name> <value>    publish a new value, takes effect at the next control tick
+ *   save | load           store the current values in NVS / go back to the stored ones
+ *   defaults              publish the built-in defaults (not saved)
+ *   stats [-r]            task CPU share and stack headroom, control loop timing
+ *   bench [-r]            runtime benchmark report (bench.h)
+ *   lat [-b] [-r]         input-to-actuation latency histograms (lat_hist.h)
+ *   cal [sweep [ms] | save]  joystick calibration: show, learn the extents, store (joy_cal.h)
+ *   journal [n | flush]   last n records of the fault journal, or write the pending ones now (journal.h)
+ *   prog [list | show <id> | put <id> <name> <hex> | del <id>]
+ *                         motion programs (motion_progs.h): list, disassemble, store or erase a user program
+ */
+
+esp_err_t tune_console_start(void);
+
+#endif // !_TUNE_CONSOLE_H_